@@ -3,6 +3,8 @@ import msgpack from 'msgpack-lite';
 
 function createWebSocket() {
 	let listeners = new Map<string, Set<(data?: unknown) => void>>();
+	// Requested maximum delivery rate (Hz) per event, the server coalesces to the latest value
+	let maxRates = new Map<string, number>();
 	const { subscribe, set } = writable(false);
 	const socketEvents = ['open', 'close', 'error', 'message', 'unresponsive'] as const;
 	type SocketEvent = (typeof socketEvents)[number];
@@ -38,7 +40,7 @@ function createWebSocket() {
 			listeners.get('open')?.forEach((listener) => listener(ev));
 			for (const event of listeners.keys()) {
 				if (socketEvents.includes(event as SocketEvent)) continue;
-				sendEvent('subscribe', event);
+				sendSubscribe(event);
 			}
 		};
 		ws.onmessage = (message) => {
@@ -67,6 +69,7 @@ function createWebSocket() {
 
 		if (!eventListeners.size) {
 			sendEvent('unsubscribe', event);
+			maxRates.delete(event);
 		}
 		if (listener) {
 			eventListeners?.delete(listener);
@@ -93,13 +96,23 @@ function createWebSocket() {
 		send({ event, data });
 	}
 
+	function sendSubscribe(event: string) {
+		const maxRate = maxRates.get(event);
+		if (maxRate) {
+			sendEvent('subscribe', { event, max_rate: maxRate, policy: 'latest' });
+		} else {
+			sendEvent('subscribe', event);
+		}
+	}
+
 	return {
 		subscribe,
 		send,
 		sendEvent,
 		init,
-		on: <T>(event: string, listener: (data: T) => void): (() => void) => {
+		on: <T>(event: string, listener: (data: T) => void, maxRate?: number): (() => void) => {
 			let eventListeners = listeners.get(event);
+			if (maxRate) maxRates.set(event, maxRate);
 			if (!eventListeners) {
 				eventListeners = new Set();
 				listeners.set(event, eventListeners);
@@ -107,8 +120,11 @@ function createWebSocket() {
 				// Only send subscription if WebSocket is open and it's not a socket event
 				if (!socketEvents.includes(event as SocketEvent) && 
 					ws && ws.readyState === WebSocket.OPEN) {
-					sendEvent('subscribe', event);
+					sendSubscribe(event);
 				}
+			} else if (maxRate && ws && ws.readyState === WebSocket.OPEN) {
+				// renegotiate the rate of an existing subscription
+				sendSubscribe(event);
 			}
 			eventListeners.add(listener as (data: any) => void);
 
@@ -29,6 +29,9 @@ export type ThresholdSettings = {
 	min: number;
 	dangerous: number;
 	critical: number;
+	hysteresis?: number; // Ширина полосы возврата, °C
+	debounce?: number; // Подряд идущих отсчетов для смены уровня
+	max_rate?: number; // Предельная скорость роста, °C/мин (0 - выключено)
 }
 
 export type CriticalStateResult = {
@@ -129,6 +129,26 @@ export type StaticSystemInformation = {
 	flash_chip_size: number;
 	flash_chip_speed: number;
 	cpu_reset_reason: string;
+	fs_writes?: FSWriteStats[];
+	event_clients?: EventClientStats[];
+};
+
+export type EventClientStats = {
+	id: number;
+	queue_depth: number;
+	max_queue_depth: number;
+	sent: number;
+	coalesced: number;
+	dropped: number;
+};
+
+export type FSWriteStats = {
+	path: string;
+	writes: number;
+	failures: number;
+	coalesced: number;
+	last_write_us: number;
+	pending: boolean;
 };
 
 export type SystemInformation = Analytics & StaticSystemInformation;
@@ -138,6 +158,19 @@ export type MQTTStatus = {
 	connected: boolean;
 	client_id: string;
 	last_error: string;
+	endpoints?: MQTTEndpointStats[];
+};
+
+export type MQTTEndpointStats = {
+	topic: string;
+	min_interval_ms: number;
+	max_interval_ms: number;
+	publishes: number;
+	failures: number;
+	bytes: number;
+	coalesced: number;
+	last_publish_ms: number;
+	dirty: boolean;
 };
 
 export type MQTTSettings = {
@@ -29,7 +29,7 @@ public:
 
     void begin()
     {
-        _socket->registerEvent(EVENT_ANALYTICS);
+        _eventId = _socket->registerEvent(EVENT_ANALYTICS, true);
     }
 
     void loop()
@@ -37,6 +37,10 @@ public:
         if (millis() - lastMillis > ANALYTICS_INTERVAL)
         {
             lastMillis = millis();
+            if (!_socket->hasSubscribers(_eventId))
+            {
+                return;
+            }
             JsonDocument doc;
             doc["uptime"] = millis() / 1000;
             doc["free_heap"] = ESP.getFreeHeap();
@@ -55,12 +59,13 @@ public:
             }
 
             JsonObject jsonObject = doc.as<JsonObject>();
-            _socket->emitEvent(EVENT_ANALYTICS, jsonObject);
+            _socket->emitEvent(_eventId, jsonObject);
         }
     };
 
 protected:
     EventSocket *_socket;
+    EventId _eventId = EVENT_ID_INVALID;
 
     unsigned long lastMillis = 0;
 };
@@ -41,7 +41,7 @@ int BatteryService::getSOC()
 
 void BatteryService::begin()
 {
-    _socket->registerEvent(EVENT_BATTERY);
+    _socket->registerEvent(EVENT_BATTERY, true);
 }
 
 void BatteryService::batteryEvent()
@@ -56,7 +56,7 @@ ESP32SvelteKit::ESP32SvelteKit(PsychicHttpServer *server, unsigned int numberEnd
 #if FT_ENABLED(FT_COREDUMP)
                                                                                           _coreDump(server, &_securitySettingsService),
 #endif
-                                                                                          _systemStatus(server, &_securitySettingsService)
+                                                                                          _systemStatus(server, &_securitySettingsService, &_socket)
 {
 }
 
@@ -234,6 +234,7 @@ void ESP32SvelteKit::_loop()
 #if FT_ENABLED(FT_ANALYTICS)
         _analyticsService.loop();
 #endif
+        _socket.loop(); // flush rate limited event subscriptions
 
         // Query the connectivity status
         wifi = _wifiStatus.isConnected();
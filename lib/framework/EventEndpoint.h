@@ -40,7 +40,7 @@ public:
 
     void begin()
     {
-        _socket->registerEvent(_event);
+        _eventId = _socket->registerEvent(_event, true);
         _socket->onEvent(_event, std::bind(&EventEndpoint::updateState, this, std::placeholders::_1, std::placeholders::_2));
         _socket->onSubscribe(_event, [&](const String &originId)
                              { syncState(originId, true); });
@@ -52,6 +52,7 @@ private:
     StatefulService<T> *_statefulService;
     EventSocket *_socket;
     const char *_event;
+    EventId _eventId = EVENT_ID_INVALID;
 
     void updateState(JsonObject &root, int originId)
     {
@@ -60,11 +61,13 @@ private:
 
     void syncState(const String &originId, bool sync = false)
     {
-        JsonDocument jsonDocument;
-        JsonObject root = jsonDocument.to<JsonObject>();
-        _statefulService->read(root, _stateReader);
-        JsonObject jsonObject = jsonDocument.as<JsonObject>();
-        _socket->emitEvent(_event, jsonObject, originId.c_str(), sync);
+        if (!_socket->hasSubscribers(_eventId))
+        {
+            return;
+        }
+        // the encoding is shared with the service's other endpoints
+        EncodedState data = _statefulService->encode(_stateReader, EventSocket::messageEncoding());
+        _socket->emitEvent(_eventId, data, originId.c_str(), sync);
     }
 };
 
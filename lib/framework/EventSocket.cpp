@@ -1,7 +1,63 @@
 #include <EventSocket.h>
 
+#include <algorithm>
+
+#ifndef ESP32SVELTEKIT_RUNNING_CORE
+#define ESP32SVELTEKIT_RUNNING_CORE -1
+#endif
+
+// The envelope is encoded once per event with a null placeholder for data, which messages replace:
+// JSON ends with `null}`, MessagePack with the nil byte
+#if FT_ENABLED(EVENT_USE_JSON)
+#define EVENT_ENVELOPE_PLACEHOLDER_LEN 5
+#define EVENT_ENVELOPE_CLOSING "}"
+#else
+#define EVENT_ENVELOPE_PLACEHOLDER_LEN 1
+#define EVENT_ENVELOPE_CLOSING ""
+#endif
+
+#define EVENT_CLIENT_BIT(slot) ((EventClientMask)1 << (slot))
+
 SemaphoreHandle_t clientSubscriptionsMutex = xSemaphoreCreateMutex();
 
+static EventThrottle *findThrottle(EventEntry &entry, int slot)
+{
+    for (auto &throttle : entry.throttles)
+    {
+        if (throttle.slot == slot)
+        {
+            return &throttle;
+        }
+    }
+    return nullptr;
+}
+
+static void removeThrottle(EventEntry &entry, int slot)
+{
+    entry.throttles.erase(std::remove_if(entry.throttles.begin(), entry.throttles.end(), [slot](const EventThrottle &throttle)
+                                         { return throttle.slot == slot; }),
+                          entry.throttles.end());
+    entry.throttled &= ~EVENT_CLIENT_BIT(slot);
+}
+
+static void clearQueue(EventClient &client)
+{
+    for (auto &queued : client.messages)
+    {
+        queued.message.reset();
+    }
+    client.head = 0;
+    client.depth = 0;
+}
+
+static EventMessage popMessage(EventClient &client)
+{
+    EventMessage message = std::move(client.messages[client.head].message);
+    client.head = (client.head + 1) % EVENT_CLIENT_QUEUE_LENGTH;
+    client.depth--;
+    return message;
+}
+
 EventSocket::EventSocket(PsychicHttpServer *server,
                          SecurityManager *securityManager,
                          AuthenticationPredicate authenticationPredicate) : _server(server),
@@ -18,33 +74,129 @@ void EventSocket::begin()
     _socket.onFrame(std::bind(&EventSocket::onFrame, this, std::placeholders::_1, std::placeholders::_2));
     _server->on(EVENT_SERVICE_PATH, &_socket);
 
+    xTaskCreatePinnedToCore(
+        senderTask,                 // Function that should be called
+        "EventSocket Sender",       // Name of the task (for debugging)
+        4096,                       // Stack size (bytes)
+        this,                       // Pass reference to this class instance
+        (tskIDLE_PRIORITY + 2),     // task priority
+        &_senderTaskHandle,         // Task handle
+        ESP32SVELTEKIT_RUNNING_CORE // Pin to application core
+    );
+
     ESP_LOGV(SVK_TAG, "Registered event socket endpoint: %s", EVENT_SERVICE_PATH);
 }
 
-void EventSocket::registerEvent(String event)
+EventId EventSocket::registerEvent(String event, bool coalesce)
 {
-    if (!isEventValid(event))
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    EventId id = findEvent(event);
+    if (id != EVENT_ID_INVALID)
     {
-        ESP_LOGD(SVK_TAG, "Registering event: %s", event.c_str());
-        events.push_back(event);
+        xSemaphoreGive(clientSubscriptionsMutex);
+        ESP_LOGW(SVK_TAG, "Event already registered: %s", event.c_str());
+        return id;
     }
-    else
+    if (_events.size() >= EVENT_ID_INVALID)
     {
-        ESP_LOGW(SVK_TAG, "Event already registered: %s", event.c_str());
+        xSemaphoreGive(clientSubscriptionsMutex);
+        ESP_LOGE(SVK_TAG, "Too many events, cannot register: %s", event.c_str());
+        return EVENT_ID_INVALID;
+    }
+
+    ESP_LOGD(SVK_TAG, "Registering event: %s", event.c_str());
+    id = (EventId)_events.size();
+    _events.emplace_back();
+    EventEntry &entry = _events.back();
+    entry.name = event;
+    entry.coalesce = coalesce;
+
+    JsonDocument envelope;
+    envelope["event"] = event;
+    envelope["data"] = nullptr;
+#if FT_ENABLED(EVENT_USE_JSON)
+    size_t envelopeLen = measureJson(envelope);
+    entry.envelope.resize(envelopeLen + 1);
+    serializeJson(envelope, entry.envelope.data(), envelopeLen + 1);
+#else
+    size_t envelopeLen = measureMsgPack(envelope);
+    entry.envelope.resize(envelopeLen);
+    serializeMsgPack(envelope, entry.envelope.data(), envelopeLen);
+#endif
+    entry.envelope.resize(envelopeLen - EVENT_ENVELOPE_PLACEHOLDER_LEN);
+    entry.envelope.shrink_to_fit();
+
+    xSemaphoreGive(clientSubscriptionsMutex);
+    return id;
+}
+
+EventId EventSocket::eventId(const String &event)
+{
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    EventId id = findEvent(event);
+    xSemaphoreGive(clientSubscriptionsMutex);
+    return id;
+}
+
+EventId EventSocket::findEvent(const String &event)
+{
+    for (size_t i = 0; i < _events.size(); i++)
+    {
+        if (_events[i].name == event)
+        {
+            return (EventId)i;
+        }
     }
+    return EVENT_ID_INVALID;
+}
+
+int EventSocket::clientSlot(int socket)
+{
+    for (int slot = 0; slot < EVENT_MAX_CLIENTS; slot++)
+    {
+        if (_clients[slot].socket == socket)
+        {
+            return slot;
+        }
+    }
+    return -1;
 }
 
 void EventSocket::onWSOpen(PsychicWebSocketClient *client)
 {
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    int slot = clientSlot(-1);
+    if (slot >= 0)
+    {
+        _clients[slot] = EventClient();
+        _clients[slot].socket = client->socket();
+    }
+    xSemaphoreGive(clientSubscriptionsMutex);
+
+    if (slot < 0)
+    {
+        ESP_LOGW(SVK_TAG, "ws[%s][%u] rejected, %d event clients already connected", client->remoteIP().toString().c_str(), client->socket(), EVENT_MAX_CLIENTS);
+        client->close();
+        return;
+    }
     ESP_LOGI(SVK_TAG, "ws[%s][%u] connect", client->remoteIP().toString().c_str(), client->socket());
 }
 
 void EventSocket::onWSClose(PsychicWebSocketClient *client)
 {
     xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
-    for (auto &event_subscriptions : client_subscriptions)
+    int slot = clientSlot(client->socket());
+    if (slot >= 0)
     {
-        event_subscriptions.second.remove(client->socket());
+        for (auto &entry : _events)
+        {
+            entry.subscribers &= ~EVENT_CLIENT_BIT(slot);
+            if (entry.throttled & EVENT_CLIENT_BIT(slot))
+            {
+                removeThrottle(entry, slot);
+            }
+        }
+        _clients[slot] = EventClient();
     }
     xSemaphoreGive(clientSubscriptionsMutex);
     ESP_LOGI(SVK_TAG, "ws[%s][%u] disconnect", client->remoteIP().toString().c_str(), client->socket());
@@ -77,25 +229,57 @@ esp_err_t EventSocket::onFrame(PsychicWebSocketRequest *request, httpd_ws_frame
             String event = doc["event"];
             if (event == "subscribe")
             {
+                // data is either the event name or {"event": name, "max_rate": Hz, "policy": "latest"}
+                String subscribeEvent;
+                uint32_t minIntervalMs = 0;
+                EventCoalescePolicy policy = EventCoalescePolicy::LATEST;
+                if (doc["data"].is<JsonObject>())
+                {
+                    subscribeEvent = doc["data"]["event"].as<String>();
+                    float maxRate = doc["data"]["max_rate"] | 0.0f;
+                    if (maxRate > 0 && maxRate < EVENT_MAX_SUBSCRIBE_RATE_HZ)
+                    {
+                        minIntervalMs = (uint32_t)(1000.0f / maxRate);
+                    }
+                    String policyName = doc["data"]["policy"] | "latest";
+                    if (policyName != "latest")
+                    {
+                        ESP_LOGW(SVK_TAG, "Unsupported coalescing policy '%s' for event %s, using 'latest'", policyName.c_str(), subscribeEvent.c_str());
+                    }
+                }
+                else
+                {
+                    subscribeEvent = doc["data"].as<String>();
+                }
+
                 // only subscribe to events that are registered
-                if (isEventValid(doc["data"].as<String>()))
+                EventId id = eventId(subscribeEvent);
+                if (id != EVENT_ID_INVALID)
                 {
-                    client_subscriptions[doc["data"]].push_back(request->client()->socket());
-                    handleSubscribeCallbacks(doc["data"], String(request->client()->socket()));
+                    subscribeClient(id, request->client()->socket(), minIntervalMs, policy);
+                    handleSubscribeCallbacks(id, String(request->client()->socket()));
                 }
                 else
                 {
-                    ESP_LOGW(SVK_TAG, "Client tried to subscribe to unregistered event: %s", doc["data"].as<String>().c_str());
+                    ESP_LOGW(SVK_TAG, "Client tried to subscribe to unregistered event: %s", subscribeEvent.c_str());
                 }
             }
             else if (event == "unsubscribe")
             {
-                client_subscriptions[doc["data"]].remove(request->client()->socket());
+                EventId id = eventId(doc["data"].as<String>());
+                if (id != EVENT_ID_INVALID)
+                {
+                    unsubscribeClient(id, request->client()->socket());
+                }
             }
             else
             {
-                JsonObject jsonObject = doc["data"].as<JsonObject>();
-                handleEventCallbacks(event, jsonObject, request->client()->socket());
+                EventId id = eventId(event);
+                if (id != EVENT_ID_INVALID)
+                {
+                    JsonObject jsonObject = doc["data"].as<JsonObject>();
+                    handleEventCallbacks(id, jsonObject, request->client()->socket());
+                }
             }
             return ESP_OK;
         }
@@ -104,96 +288,427 @@ esp_err_t EventSocket::onFrame(PsychicWebSocketRequest *request, httpd_ws_frame
     return ESP_OK;
 }
 
-void EventSocket::emitEvent(String event, JsonObject &jsonObject, const char *originId, bool onlyToSameOrigin)
+void EventSocket::subscribeClient(EventId event, int clientId, uint32_t minIntervalMs, EventCoalescePolicy policy)
 {
-    // Only process valid events
-    if (!isEventValid(String(event)))
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    int slot = clientSlot(clientId);
+    if (slot < 0 || event >= _events.size())
     {
-        ESP_LOGW(SVK_TAG, "Method tried to emit unregistered event: %s", event);
+        xSemaphoreGive(clientSubscriptionsMutex);
         return;
     }
+    EventEntry &entry = _events[event];
+    entry.subscribers |= EVENT_CLIENT_BIT(slot);
+    if (!entry.coalesce)
+    {
+        minIntervalMs = 0; // skipping messages would lose them, so they are never throttled
+    }
 
-    int originSubscriptionId = originId[0] ? atoi(originId) : -1;
+    // a repeated subscribe renegotiates the rate of the existing subscription
+    EventThrottle *throttle = findThrottle(entry, slot);
+    if (minIntervalMs == 0)
+    {
+        if (throttle)
+        {
+            EventMessage pending = throttle->pending;
+            removeThrottle(entry, slot);
+            if (pending)
+            {
+                enqueue(slot, event, pending, millis());
+            }
+        }
+    }
+    else if (throttle)
+    {
+        throttle->minIntervalMs = minIntervalMs;
+        throttle->policy = policy;
+    }
+    else
+    {
+        entry.throttles.push_back({(uint8_t)slot, minIntervalMs, policy, 0, nullptr});
+        entry.throttled |= EVENT_CLIENT_BIT(slot);
+    }
+    xSemaphoreGive(clientSubscriptionsMutex);
+    ESP_LOGV(SVK_TAG, "Client[%d] subscribed to %s, min interval %lu ms", clientId, entry.name.c_str(), minIntervalMs);
+}
+
+void EventSocket::unsubscribeClient(EventId event, int clientId)
+{
     xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
-    auto &subscriptions = client_subscriptions[event];
-    if (subscriptions.empty())
+    int slot = clientSlot(clientId);
+    if (slot >= 0 && event < _events.size())
+    {
+        EventEntry &entry = _events[event];
+        entry.subscribers &= ~EVENT_CLIENT_BIT(slot);
+        removeThrottle(entry, slot);
+    }
+    xSemaphoreGive(clientSubscriptionsMutex);
+}
+
+void EventSocket::enqueue(int slot, EventId event, const EventMessage &message, uint32_t now)
+{
+    EventClient &client = _clients[slot];
+    if (client.evicting)
     {
-        xSemaphoreGive(clientSubscriptionsMutex);
         return;
     }
 
-    JsonDocument doc;
-    doc["event"] = event;
-    doc["data"] = jsonObject;
+    // latest value wins: a message of the same coalescing event still waiting is replaced in place
+    for (uint8_t i = 0; _events[event].coalesce && i < client.depth; i++)
+    {
+        EventQueuedMessage &queued = client.messages[(client.head + i) % EVENT_CLIENT_QUEUE_LENGTH];
+        if (queued.event == event)
+        {
+            queued.message = message;
+            client.coalesced++;
+            return;
+        }
+    }
+
+    if (client.depth >= EVENT_CLIENT_QUEUE_LENGTH)
+    {
+        client.dropped++;
+        switch (_overflowPolicy)
+        {
+        case EventOverflowPolicy::DROP_NEWEST:
+            return;
+        case EventOverflowPolicy::DISCONNECT:
+            evict(slot, "queue overflow");
+            return;
+        case EventOverflowPolicy::DROP_OLDEST:
+        default:
+            popMessage(client);
+            break;
+        }
+    }
+
+    if (client.depth == 0)
+    {
+        client.lastProgressMs = now;
+    }
+    client.messages[(client.head + client.depth) % EVENT_CLIENT_QUEUE_LENGTH] = {event, message};
+    client.depth++;
+    if (client.depth > client.maxDepth)
+    {
+        client.maxDepth = client.depth;
+    }
+
+    if (_senderTaskHandle)
+    {
+        xTaskNotifyGive(_senderTaskHandle);
+    }
+}
+
+void EventSocket::evict(int slot, const char *reason)
+{
+    EventClient &client = _clients[slot];
+    ESP_LOGW(SVK_TAG, "Disconnecting event client[%d]: %s", client.socket, reason);
+    // the slot is freed by onWSClose once the session is closed
+    client.evicting = true;
+    clearQueue(client);
+    auto *wsClient = _socket.getClient(client.socket);
+    if (wsClient)
+    {
+        wsClient->close();
+    }
+}
+
+void EventSocket::senderTask(void *param)
+{
+    auto *self = static_cast<EventSocket *>(param);
+    while (true)
+    {
+        // the periodic wake up detects stalled clients even when no new messages arrive
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        self->drainQueues();
+    }
+}
+
+void EventSocket::drainQueues()
+{
+    struct
+    {
+        int slot;
+        int socket;
+        EventMessage message;
+    } batch[EVENT_MAX_CLIENTS];
+
+    while (true)
+    {
+        // take one message per client, so clients are served round robin
+        size_t count = 0;
+        uint32_t now = millis();
+        xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+        for (int slot = 0; slot < EVENT_MAX_CLIENTS; slot++)
+        {
+            EventClient &client = _clients[slot];
+            if (client.socket < 0 || client.evicting || client.depth == 0)
+            {
+                continue;
+            }
+            if (now - client.lastProgressMs >= EVENT_CLIENT_STALL_TIMEOUT_MS)
+            {
+                evict(slot, "stalled");
+                continue;
+            }
+            batch[count].slot = slot;
+            batch[count].socket = client.socket;
+            batch[count].message = popMessage(client);
+            count++;
+        }
+        xSemaphoreGive(clientSubscriptionsMutex);
 
+        if (count == 0)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            EventMessage message = std::move(batch[i].message);
+
+            // sending blocks while the client's socket buffer is full, so no lock is held here
+            auto *wsClient = _socket.getClient(batch[i].socket);
+            esp_err_t result = ESP_FAIL;
+            if (wsClient)
+            {
+                ESP_LOGV(SVK_TAG, "Emitting event to %s[%u], Message[%zu]", wsClient->remoteIP().toString().c_str(), wsClient->socket(), message->size());
 #if FT_ENABLED(EVENT_USE_JSON)
-    size_t len = measureJson(doc);
+                result = wsClient->sendMessage(HTTPD_WS_TYPE_TEXT, message->data(), message->size());
 #else
-    size_t len = measureMsgPack(doc);
+                result = wsClient->sendMessage(HTTPD_WS_TYPE_BINARY, message->data(), message->size());
 #endif
+            }
+
+            xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+            // the slot may have been freed, or even reused, while sending
+            EventClient &client = _clients[batch[i].slot];
+            if (client.socket == batch[i].socket)
+            {
+                if (result == ESP_OK)
+                {
+                    client.sent++;
+                    client.lastProgressMs = millis();
+                }
+                else if (!client.evicting)
+                {
+                    evict(batch[i].slot, wsClient ? "send failed" : "disconnected");
+                }
+            }
+            xSemaphoreGive(clientSubscriptionsMutex);
+        }
+    }
+}
 
-    char *output = new char[len + 1];
+std::vector<EventClientStats> EventSocket::getClientStats()
+{
+    std::vector<EventClientStats> stats;
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    for (const auto &client : _clients)
+    {
+        if (client.socket >= 0)
+        {
+            stats.push_back({client.socket, client.depth, client.maxDepth, client.sent, client.coalesced, client.dropped});
+        }
+    }
+    xSemaphoreGive(clientSubscriptionsMutex);
+    return stats;
+}
+
+EventMessage EventSocket::beginMessage(EventId event, size_t dataLen, char *&data)
+{
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    const std::vector<char> &envelope = _events[event].envelope;
+    size_t closingLen = strlen(EVENT_ENVELOPE_CLOSING);
+
+    // the serialized message is shared by every client that has to wait for its slot
+    EventMessage message = std::make_shared<std::vector<char>>(envelope.size() + dataLen + closingLen + 1);
+    memcpy(message->data(), envelope.data(), envelope.size());
+    data = message->data() + envelope.size();
+    xSemaphoreGive(clientSubscriptionsMutex);
+    return message;
+}
+
+// Closes the envelope after the data written by the caller
+static void endMessage(std::vector<char> &message, const char *dataEnd)
+{
+    size_t len = dataEnd - message.data();
+    size_t closingLen = strlen(EVENT_ENVELOPE_CLOSING);
+    memcpy(message.data() + len, EVENT_ENVELOPE_CLOSING, closingLen);
+    len += closingLen;
+
+    // null terminate the string, but never send the terminator
+    message[len] = '\0';
+    message.resize(len);
+}
+
+void EventSocket::emitEvent(EventId event, JsonObject &jsonObject, const char *originId, bool onlyToSameOrigin)
+{
+    if (!hasSubscribers(event))
+    {
+        return;
+    }
 
 #if FT_ENABLED(EVENT_USE_JSON)
-    serializeJson(doc, output, len + 1);
+    size_t len = measureJson(jsonObject);
 #else
-    serializeMsgPack(doc, output, len);
+    size_t len = measureMsgPack(jsonObject);
 #endif
 
-    // null terminate the string
-    output[len] = '\0';
+    char *data;
+    EventMessage message = beginMessage(event, len, data);
+#if FT_ENABLED(EVENT_USE_JSON)
+    serializeJson(jsonObject, data, len + 1);
+#else
+    serializeMsgPack(jsonObject, data, len);
+#endif
+    endMessage(*message, data + len);
+
+    dispatchMessage(event, message, originId, onlyToSameOrigin);
+}
+
+void EventSocket::emitEvent(EventId event, const EncodedState &encoded, const char *originId, bool onlyToSameOrigin)
+{
+    if (!encoded || !hasSubscribers(event))
+    {
+        return;
+    }
+
+    char *data;
+    EventMessage message = beginMessage(event, encoded->size(), data);
+    memcpy(data, encoded->data(), encoded->size());
+    endMessage(*message, data + encoded->size());
+
+    dispatchMessage(event, message, originId, onlyToSameOrigin);
+}
+
+void EventSocket::emitEvent(String event, JsonObject &jsonObject, const char *originId, bool onlyToSameOrigin)
+{
+    EventId id = eventId(event);
+    // Only process valid events
+    if (id == EVENT_ID_INVALID)
+    {
+        ESP_LOGW(SVK_TAG, "Method tried to emit unregistered event: %s", event.c_str());
+        return;
+    }
+    emitEvent(id, jsonObject, originId, onlyToSameOrigin);
+}
+
+void EventSocket::emitEvent(String event, const EncodedState &data, const char *originId, bool onlyToSameOrigin)
+{
+    EventId id = eventId(event);
+    if (id == EVENT_ID_INVALID)
+    {
+        ESP_LOGW(SVK_TAG, "Method tried to emit unregistered event: %s", event.c_str());
+        return;
+    }
+    emitEvent(id, data, originId, onlyToSameOrigin);
+}
+
+bool EventSocket::hasSubscribers(EventId event)
+{
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    bool subscribed = event < _events.size() && _events[event].subscribers != 0;
+    xSemaphoreGive(clientSubscriptionsMutex);
+    return subscribed;
+}
+
+bool EventSocket::hasSubscribers(const String &event)
+{
+    return hasSubscribers(eventId(event));
+}
+
+void EventSocket::dispatchMessage(EventId event, const EventMessage &message, const char *originId, bool onlyToSameOrigin)
+{
+    int originSubscriptionId = originId[0] ? atoi(originId) : -1;
+    uint32_t now = millis();
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    EventEntry &entry = _events[event];
+    int originSlot = originSubscriptionId > 0 ? clientSlot(originSubscriptionId) : -1;
 
     // if onlyToSameOrigin == true, send the message back to the origin
     if (onlyToSameOrigin && originSubscriptionId > 0)
     {
-        auto *client = _socket.getClient(originSubscriptionId);
-        if (client)
+        if (originSlot >= 0 && (entry.subscribers & EVENT_CLIENT_BIT(originSlot)))
         {
-            ESP_LOGV(SVK_TAG, "Emitting event: %s to %s[%u], Message[%d]: %s", event, client->remoteIP().toString().c_str(), client->socket(), len, output);
-#if FT_ENABLED(EVENT_USE_JSON)
-            client->sendMessage(HTTPD_WS_TYPE_TEXT, output, len);
-#else
-            client->sendMessage(HTTPD_WS_TYPE_BINARY, output, len);
-#endif
+            // the initial sync after a subscribe is never throttled
+            EventThrottle *throttle = (entry.throttled & EVENT_CLIENT_BIT(originSlot)) ? findThrottle(entry, originSlot) : nullptr;
+            if (throttle)
+            {
+                throttle->lastSentMs = now;
+                throttle->pending.reset();
+            }
+            enqueue(originSlot, event, message, now);
         }
     }
     else
     { // else send the message to all other clients
-
-        for (int subscription : client_subscriptions[event])
+        EventClientMask recipients = entry.subscribers;
+        if (originSlot >= 0)
         {
-            if (subscription == originSubscriptionId)
-                continue;
-            auto *client = _socket.getClient(subscription);
-            if (!client)
+            recipients &= ~EVENT_CLIENT_BIT(originSlot);
+        }
+        while (recipients)
+        {
+            int slot = __builtin_ctz(recipients);
+            recipients &= recipients - 1;
+
+            if (entry.throttled & EVENT_CLIENT_BIT(slot))
             {
-                subscriptions.remove(subscription);
-                continue;
+                EventThrottle *throttle = findThrottle(entry, slot);
+                if (now - throttle->lastSentMs < throttle->minIntervalMs)
+                {
+                    // latest-wins: replace whatever is still waiting for this client
+                    throttle->pending = message;
+                    continue;
+                }
+                throttle->lastSentMs = now;
+                throttle->pending.reset();
             }
-            ESP_LOGV(SVK_TAG, "Emitting event: %s to %s[%u], Message[%d]: %s", event, client->remoteIP().toString().c_str(), client->socket(), len, output);
-#if FT_ENABLED(EVENT_USE_JSON)
-            client->sendMessage(HTTPD_WS_TYPE_TEXT, output, len);
-#else
-            client->sendMessage(HTTPD_WS_TYPE_BINARY, output, len);
-#endif
+            enqueue(slot, event, message, now);
         }
     }
 
-    delete[] output;
     xSemaphoreGive(clientSubscriptionsMutex);
 }
 
-void EventSocket::handleEventCallbacks(String event, JsonObject &jsonObject, int originId)
+void EventSocket::loop()
+{
+    uint32_t now = millis();
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    for (size_t event = 0; event < _events.size(); event++)
+    {
+        for (auto &throttle : _events[event].throttles)
+        {
+            if (throttle.pending && now - throttle.lastSentMs >= throttle.minIntervalMs)
+            {
+                EventMessage message = std::move(throttle.pending);
+                throttle.lastSentMs = now;
+                enqueue(throttle.slot, (EventId)event, message, now);
+            }
+        }
+    }
+    xSemaphoreGive(clientSubscriptionsMutex);
+}
+
+void EventSocket::handleEventCallbacks(EventId event, JsonObject &jsonObject, int originId)
 {
-    for (auto &callback : event_callbacks[event])
+    // registrations may grow the tables meanwhile, so callbacks run on a copy and without the lock
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    std::vector<EventCallback> callbacks = _events[event].eventCallbacks;
+    xSemaphoreGive(clientSubscriptionsMutex);
+    for (auto &callback : callbacks)
     {
         callback(jsonObject, originId);
     }
 }
 
-void EventSocket::handleSubscribeCallbacks(String event, const String &originId)
+void EventSocket::handleSubscribeCallbacks(EventId event, const String &originId)
 {
-    for (auto &callback : subscribe_callbacks[event])
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    std::vector<SubscribeCallback> callbacks = _events[event].subscribeCallbacks;
+    xSemaphoreGive(clientSubscriptionsMutex);
+    for (auto &callback : callbacks)
     {
         callback(originId);
     }
@@ -201,28 +716,39 @@ void EventSocket::handleSubscribeCallbacks(String event, const String &originId)
 
 void EventSocket::onEvent(String event, EventCallback callback)
 {
-    if (!isEventValid(event))
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    EventId id = findEvent(event);
+    if (id != EVENT_ID_INVALID)
+    {
+        _events[id].eventCallbacks.push_back(callback);
+    }
+    xSemaphoreGive(clientSubscriptionsMutex);
+    if (id == EVENT_ID_INVALID)
     {
         ESP_LOGW(SVK_TAG, "Method tried to register unregistered event: %s", event.c_str());
-        return;
     }
-    event_callbacks[event].push_back(callback);
 }
 
 void EventSocket::onSubscribe(String event, SubscribeCallback callback)
 {
-    if (!isEventValid(event))
+    xSemaphoreTake(clientSubscriptionsMutex, portMAX_DELAY);
+    EventId id = findEvent(event);
+    if (id != EVENT_ID_INVALID)
+    {
+        _events[id].subscribeCallbacks.push_back(callback);
+    }
+    xSemaphoreGive(clientSubscriptionsMutex);
+    if (id == EVENT_ID_INVALID)
     {
         ESP_LOGW(SVK_TAG, "Method tried to subscribe to unregistered event: %s", event.c_str());
         return;
     }
-    subscribe_callbacks[event].push_back(callback);
     ESP_LOGI(SVK_TAG, "onSubscribe for event: %s", event.c_str());
 }
 
 bool EventSocket::isEventValid(String event)
 {
-    return std::find(events.begin(), events.end(), event) != events.end();
+    return eventId(event) != EVENT_ID_INVALID;
 }
 
 unsigned int EventSocket::getConnectedClients()
@@ -18,15 +18,113 @@
 #include <PsychicHttp.h>
 #include <SecurityManager.h>
 #include <StatefulService.h>
-#include <list>
-#include <map>
+#include <memory>
 #include <vector>
 
 #define EVENT_SERVICE_PATH "/ws/events"
 
+// Upper bound for the rate a client may request, anything faster is delivered unthrottled
+#ifndef EVENT_MAX_SUBSCRIBE_RATE_HZ
+#define EVENT_MAX_SUBSCRIBE_RATE_HZ 100
+#endif
+
+// Messages waiting to be sent to one client. Further messages of a coalescing event already waiting
+// replace it, other events are queued in order and the bound applies to them as registered.
+#ifndef EVENT_CLIENT_QUEUE_LENGTH
+#define EVENT_CLIENT_QUEUE_LENGTH 8
+#endif
+
+// A client with queued messages that accepts none for this long is disconnected
+#ifndef EVENT_CLIENT_STALL_TIMEOUT_MS
+#define EVENT_CLIENT_STALL_TIMEOUT_MS 10000
+#endif
+
+// Clients tracked at once, one bit each in the per-event subscriber masks. The HTTP server
+// accepts max_open_sockets (7 by default) connections, so this is only reached if that is raised.
+#ifndef EVENT_MAX_CLIENTS
+#define EVENT_MAX_CLIENTS 16
+#endif
+
 typedef std::function<void(JsonObject &root, int originId)> EventCallback;
 typedef std::function<void(const String &originId)> SubscribeCallback;
 
+// Events are interned at registration, the ID indexes the flat per-event tables
+typedef uint16_t EventId;
+#define EVENT_ID_INVALID 0xFFFF
+
+typedef uint32_t EventClientMask; // bit n = client slot n
+static_assert(EVENT_MAX_CLIENTS <= 32, "EVENT_MAX_CLIENTS exceeds the width of EventClientMask");
+
+// How messages are merged while a rate limited client waits for its next slot
+enum class EventCoalescePolicy
+{
+    LATEST // only the newest message is kept, older undelivered ones are dropped
+};
+
+// What happens to a message for a client whose queue is full
+enum class EventOverflowPolicy
+{
+    DROP_OLDEST, // the oldest queued message is dropped
+    DROP_NEWEST, // the new message is dropped
+    DISCONNECT   // the client is disconnected, it will resubscribe and get a full sync
+};
+
+typedef std::shared_ptr<std::vector<char>> EventMessage;
+
+// Rate limit of one client's subscription, only rate limited subscriptions have one
+struct EventThrottle
+{
+    uint8_t slot;
+    uint32_t minIntervalMs;
+    EventCoalescePolicy policy;
+    uint32_t lastSentMs;  // when the last message was queued for the client
+    EventMessage pending; // message waiting for the next slot, if any
+};
+
+// Everything known about one registered event, indexed by EventId
+struct EventEntry
+{
+    String name;
+    bool coalesce = false;        // messages carry a full state, a newer one may replace an unsent one
+    std::vector<char> envelope;   // encoded message up to the data, built once at registration
+    EventClientMask subscribers = 0;
+    EventClientMask throttled = 0; // subscribers with an entry in throttles
+    std::vector<EventThrottle> throttles;
+    std::vector<EventCallback> eventCallbacks;
+    std::vector<SubscribeCallback> subscribeCallbacks;
+};
+
+struct EventQueuedMessage
+{
+    EventId event;
+    EventMessage message;
+};
+
+// A connected client and its outbound queue, drained by the sender task
+struct EventClient
+{
+    int socket = -1; // -1 = free slot
+    EventQueuedMessage messages[EVENT_CLIENT_QUEUE_LENGTH];
+    uint8_t head = 0; // ring buffer of messages
+    uint8_t depth = 0;
+    bool evicting = false;
+    uint32_t lastProgressMs = 0; // last successful send, or when the queue became non-empty
+    uint16_t maxDepth = 0;
+    uint32_t sent = 0;
+    uint32_t coalesced = 0; // messages replaced by a newer one of the same event
+    uint32_t dropped = 0;   // messages dropped on overflow
+};
+
+struct EventClientStats
+{
+    int clientId;
+    uint16_t depth;
+    uint16_t maxDepth;
+    uint32_t sent;
+    uint32_t coalesced;
+    uint32_t dropped;
+};
+
 class EventSocket
 {
 public:
@@ -34,31 +132,89 @@ public:
 
     void begin();
 
-    void registerEvent(String event);
+    // Returns the event's ID, the same one if the event is already registered.
+    // Producers keep the ID and emit by it, which skips the lookup by name.
+    // coalesce = true is for events whose every message carries the full state: a message still
+    // waiting for a client is replaced by a newer one and clients may subscribe with a max_rate.
+    // Messages of other events are delivered one by one, in order.
+    EventId registerEvent(String event, bool coalesce = false);
+
+    // ID of a registered event, EVENT_ID_INVALID if unknown
+    EventId eventId(const String &event);
 
     void onEvent(String event, EventCallback callback);
 
     void onSubscribe(String event, SubscribeCallback callback);
 
-    void emitEvent(String event, JsonObject &jsonObject, const char *originId = "", bool onlyToSameOrigin = false);
+    void emitEvent(EventId event, JsonObject &jsonObject, const char *originId = "", bool onlyToSameOrigin = false);
     // if onlyToSameOrigin == true, the message will be sent to the originId only, otherwise it will be broadcasted to all clients except the originId
 
+    // Same as above for data already encoded in messageEncoding(), e.g. by StatefulService::encode()
+    void emitEvent(EventId event, const EncodedState &data, const char *originId = "", bool onlyToSameOrigin = false);
+
+    // Emit by name, looked up on every call
+    void emitEvent(String event, JsonObject &jsonObject, const char *originId = "", bool onlyToSameOrigin = false);
+    void emitEvent(String event, const EncodedState &data, const char *originId = "", bool onlyToSameOrigin = false);
+
+    // Encoding of event messages: MessagePack unless EVENT_USE_JSON is set
+    static StateEncoding messageEncoding()
+    {
+#if FT_ENABLED(EVENT_USE_JSON)
+        return StateEncoding::JSON;
+#else
+        return StateEncoding::MSGPACK;
+#endif
+    }
+
+    // Lets producers skip building a message nobody receives
+    bool hasSubscribers(EventId event);
+    bool hasSubscribers(const String &event);
+
     bool isEventValid(String event);
 
     unsigned int getConnectedClients();
 
+    // delivers pending messages of rate limited subscriptions whose slot has come
+    void loop();
+
+    void setOverflowPolicy(EventOverflowPolicy policy)
+    {
+        _overflowPolicy = policy;
+    }
+
+    // Outbound queue statistics per connected client, for diagnostics
+    std::vector<EventClientStats> getClientStats();
+
 private:
     PsychicHttpServer *_server;
     PsychicWebSocketHandler _socket;
     SecurityManager *_securityManager;
     AuthenticationPredicate _authenticationPredicate;
 
-    std::vector<String> events;
-    std::map<String, std::list<int>> client_subscriptions;
-    std::map<String, std::list<EventCallback>> event_callbacks;
-    std::map<String, std::list<SubscribeCallback>> subscribe_callbacks;
-    void handleEventCallbacks(String event, JsonObject &jsonObject, int originId);
-    void handleSubscribeCallbacks(String event, const String &originId);
+    // Events and clients, under clientSubscriptionsMutex. Emitting walks the subscriber mask of
+    // one event: no lookups by name, no per-client allocations.
+    std::vector<EventEntry> _events;
+    EventClient _clients[EVENT_MAX_CLIENTS];
+
+    void handleEventCallbacks(EventId event, JsonObject &jsonObject, int originId);
+    void handleSubscribeCallbacks(EventId event, const String &originId);
+
+    EventId findEvent(const String &event);
+    int clientSlot(int socket);
+    void subscribeClient(EventId event, int clientId, uint32_t minIntervalMs, EventCoalescePolicy policy);
+    void unsubscribeClient(EventId event, int clientId);
+    // Allocates a message for dataLen bytes of data with the event's envelope in front of it
+    EventMessage beginMessage(EventId event, size_t dataLen, char *&data);
+    void dispatchMessage(EventId event, const EventMessage &message, const char *originId, bool onlyToSameOrigin);
+
+    // Sending happens in the sender task without the mutex, so a slow client delays
+    // neither producers nor other clients' queues.
+    EventOverflowPolicy _overflowPolicy = EventOverflowPolicy::DROP_OLDEST;
+    TaskHandle_t _senderTaskHandle = nullptr;
+    void enqueue(int slot, EventId event, const EventMessage &message, uint32_t now);
+    void evict(int slot, const char *reason);
+    static void senderTask(void *param);
+    void drainQueues();
 
     void onWSOpen(PsychicWebSocketClient *client);
     void onWSClose(PsychicWebSocketClient *client);
@@ -0,0 +1,145 @@
+#ifndef FSDocument_h
+#define FSDocument_h
+
+/**
+ *   ESP32 SvelteKit
+ *
+ *   A simple, secure and extensible framework for IoT projects for ESP32 platforms
+ *   with responsive Sveltekit front-end built with TailwindCSS and DaisyUI.
+ *   https://github.com/theelims/ESP32-sveltekit
+ *
+ *   Copyright (C) 2018 - 2023 rjwats
+ *   Copyright (C) 2023 - 2025 theelims
+ *
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ **/
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Features.h>
+#include <FS.h>
+#include <memory>
+#include <new>
+
+#define FS_DOCUMENT_TEMP_SUFFIX ".tmp"
+
+enum class FSDocumentFormat : uint8_t
+{
+    JSON,
+    MSGPACK
+};
+
+/**
+ * Reads and writes documents stored on the file system as JSON or MessagePack.
+ * The format of an existing file is detected from its first byte, so files keep their
+ * names and either format can be read regardless of the configured one.
+ */
+class FSDocument
+{
+public:
+    // Format used for new writes. JSON unless FS_PERSISTENCE_USE_MSGPACK is set, so firmware
+    // that only reads JSON can still be rolled back to.
+    static FSDocumentFormat defaultFormat()
+    {
+#if FT_ENABLED(FS_PERSISTENCE_USE_MSGPACK)
+        return FSDocumentFormat::MSGPACK;
+#else
+        return FSDocumentFormat::JSON;
+#endif
+    }
+
+    static const char *formatName(FSDocumentFormat format)
+    {
+        return format == FSDocumentFormat::MSGPACK ? "MessagePack" : "JSON";
+    }
+
+    // Documents are always objects or arrays: MessagePack map and array markers never start JSON text
+    static FSDocumentFormat detect(uint8_t firstByte)
+    {
+        if ((firstByte >= 0x80 && firstByte <= 0x9f) || (firstByte >= 0xdc && firstByte <= 0xdf))
+        {
+            return FSDocumentFormat::MSGPACK;
+        }
+        return FSDocumentFormat::JSON;
+    }
+
+    static FSDocumentFormat detect(File &file)
+    {
+        int firstByte = file.peek();
+        return firstByte < 0 ? FSDocumentFormat::JSON : detect(static_cast<uint8_t>(firstByte));
+    }
+
+    static String tempPath(const String &path)
+    {
+        return path + FS_DOCUMENT_TEMP_SUFFIX;
+    }
+
+    /**
+     * Deserializes a file in either format. The file is read into memory in one call first:
+     * parsing straight from a LittleFS file reads it byte by byte. format receives the
+     * detected format.
+     */
+    static DeserializationError read(File &file, JsonDocument &doc, FSDocumentFormat *format = nullptr)
+    {
+        int firstByte = file.peek();
+        if (firstByte < 0)
+        {
+            return DeserializationError::EmptyInput;
+        }
+        FSDocumentFormat found = detect(static_cast<uint8_t>(firstByte));
+        if (format != nullptr)
+        {
+            *format = found;
+        }
+
+        size_t size = file.size();
+        std::unique_ptr<char[]> buffer(new (std::nothrow) char[size]);
+        if (buffer && file.read(reinterpret_cast<uint8_t *>(buffer.get()), size) == size)
+        {
+            return found == FSDocumentFormat::MSGPACK ? deserializeMsgPack(doc, buffer.get(), size)
+                                                      : deserializeJson(doc, buffer.get(), size);
+        }
+
+        // Not enough memory for the buffer, parse from the file
+        file.seek(0);
+        return found == FSDocumentFormat::MSGPACK ? deserializeMsgPack(doc, file) : deserializeJson(doc, file);
+    }
+
+    static size_t measure(const JsonDocument &doc, FSDocumentFormat format)
+    {
+        return format == FSDocumentFormat::MSGPACK ? measureMsgPack(doc) : measureJson(doc);
+    }
+
+    /**
+     * Writes the document to "<path>.tmp" and renames it over path, so an interrupted
+     * write leaves the previous file intact. Parent directories must exist.
+     */
+    static bool write(FS *fs, const String &path, const JsonDocument &doc, FSDocumentFormat format)
+    {
+        String temp = tempPath(path);
+        File file = fs->open(temp, "w");
+        if (!file)
+        {
+            return false;
+        }
+
+        size_t written = format == FSDocumentFormat::MSGPACK ? serializeMsgPack(doc, file) : serializeJson(doc, file);
+        file.close();
+        if (written == 0 || written != measure(doc, format))
+        {
+            fs->remove(temp);
+            return false;
+        }
+
+        // LittleFS replaces the target atomically; fall back to remove and rename where it does not
+        if (fs->rename(temp, path))
+        {
+            return true;
+        }
+        fs->remove(path);
+        return fs->rename(temp, path);
+    }
+};
+
+#endif // end FSDocument_h
@@ -16,42 +16,92 @@
  **/
 
 #include <StatefulService.h>
+#include <FSPersistenceWriter.h>
+#include <FSDocument.h>
 #include <FS.h>
+#include <esp_timer.h>
 
+/**
+ * Persists a stateful service as a JSON or MessagePack file (see FSDocument). A file in the
+ * other format is read as well and rewritten in the configured one. State changes are written by the background
+ * FSPersistenceWriter once writeDelayMs has passed without further changes. Every write goes
+ * to a temporary file which is then renamed over the settings file, so a reset during a write
+ * leaves the previous settings intact.
+ */
 template <class T>
-class FSPersistence
+class FSPersistence : public FSPersistenceJob
 {
 public:
     FSPersistence(JsonStateReader<T> stateReader,
                   JsonStateUpdater<T> stateUpdater,
                   StatefulService<T> *statefulService,
                   FS *fs,
-                  const char *filePath) : _stateReader(stateReader),
-                                          _stateUpdater(stateUpdater),
-                                          _statefulService(statefulService),
-                                          _fs(fs),
-                                          _filePath(filePath),
-                                          _updateHandlerId(0)
+                  const char *filePath,
+                  uint32_t writeDelayMs = FS_PERSISTENCE_WRITE_DELAY_MS) : _stateReader(stateReader),
+                                                                           _stateUpdater(stateUpdater),
+                                                                           _statefulService(statefulService),
+                                                                           _fs(fs),
+                                                                           _filePath(filePath),
+                                                                           _writeDelayMs(writeDelayMs),
+                                                                           _format(FSDocument::defaultFormat()),
+                                                                           _updateHandlerId(0)
     {
+        FSPersistenceWriter::getInstance().registerJob(this);
         enableUpdateHandler();
     }
 
+    ~FSPersistence() override
+    {
+        disableUpdateHandler();
+        FSPersistenceWriter::getInstance().unregisterJob(this);
+    }
+
+    const char *getFilePath() const override
+    {
+        return _filePath;
+    }
+
+    // Delay between a state change and the write. 0 writes on the next writer cycle.
+    void setWriteDelay(uint32_t writeDelayMs)
+    {
+        _writeDelayMs = writeDelayMs;
+    }
+
+    // Format of subsequent writes. Call before readFromFS() to migrate the file at boot.
+    void setFormat(FSDocumentFormat format)
+    {
+        _format = format;
+    }
+
     void readFromFS()
     {
+        // A temporary file left over from an interrupted write is incomplete, the settings file is not
+        String tempPath = FSDocument::tempPath(_filePath);
+        if (_fs->exists(tempPath))
+        {
+            _fs->remove(tempPath);
+        }
+
         File settingsFile = _fs->open(_filePath, "r");
 
         if (settingsFile)
         {
             JsonDocument jsonDocument;
-            DeserializationError error = deserializeJson(jsonDocument, settingsFile);
+            FSDocumentFormat format;
+            DeserializationError error = FSDocument::read(settingsFile, jsonDocument, &format);
+            settingsFile.close();
             if (error == DeserializationError::Ok && jsonDocument.is<JsonObject>())
             {
                 JsonObject jsonObject = jsonDocument.as<JsonObject>();
                 _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater);
-                settingsFile.close();
+                if (format != _format)
+                {
+                    ESP_LOGI("FSPersistence", "Migrating %s from %s to %s", _filePath,
+                             FSDocument::formatName(format), FSDocument::formatName(_format));
+                    writeToFS();
+                }
                 return;
             }
-            settingsFile.close();
         }
 
         // If we reach here we have not been successful in loading the config and hard-coded defaults are now applied.
@@ -61,29 +111,31 @@ public:
         writeToFS();
     }
 
-    bool writeToFS()
+    // Writes the current state synchronously. Normally called by the writer task.
+    bool writeToFS() override
     {
+        FSPersistenceWriter &writer = FSPersistenceWriter::getInstance();
+        if (writer.isSuspended())
+        {
+            return false;
+        }
+
         // create and populate a new json object
         JsonDocument jsonDocument;
         JsonObject jsonObject = jsonDocument.to<JsonObject>();
         _statefulService->read(jsonObject, _stateReader);
 
-        // make directories if required
-        mkdirs();
-
-        // serialize it to filesystem
-        File settingsFile = _fs->open(_filePath, "w");
+        writer.lockIO();
+        int64_t start = esp_timer_get_time();
+        bool ok = writeAtomically(jsonDocument);
+        writer.recordWrite(this, ok, static_cast<uint32_t>(esp_timer_get_time() - start));
+        writer.unlockIO();
 
-        // failed to open file, return false
-        if (!settingsFile)
+        if (!ok)
         {
-            return false;
+            ESP_LOGE("FSPersistence", "Failed to write %s", _filePath);
         }
-
-        // serialize the data to the file
-        serializeJson(jsonDocument, settingsFile);
-        settingsFile.close();
-        return true;
+        return ok;
     }
 
     void disableUpdateHandler()
@@ -100,7 +152,7 @@ public:
         if (!_updateHandlerId)
         {
             _updateHandlerId = _statefulService->addUpdateHandler([&](const String &originId)
-                                                                  { writeToFS(); });
+                                                                  { FSPersistenceWriter::getInstance().schedule(this, _writeDelayMs); });
         }
     }
 
@@ -110,8 +162,19 @@ private:
     StatefulService<T> *_statefulService;
     FS *_fs;
     const char *_filePath;
+    uint32_t _writeDelayMs;
+    FSDocumentFormat _format;
     update_handler_id_t _updateHandlerId;
 
+    bool writeAtomically(JsonDocument &jsonDocument)
+    {
+        // make directories if required
+        mkdirs();
+
+        // the settings file is untouched until the temporary file is complete
+        return FSDocument::write(_fs, _filePath, jsonDocument, _format);
+    }
+
     // We assume we have a _filePath with format "/directory1/directory2/filename"
     // We create a directory for each missing parent
     void mkdirs()
@@ -0,0 +1,229 @@
+/**
+ *   ESP32 SvelteKit
+ *
+ *   A simple, secure and extensible framework for IoT projects for ESP32 platforms
+ *   with responsive Sveltekit front-end built with TailwindCSS and DaisyUI.
+ *   https://github.com/theelims/ESP32-sveltekit
+ *
+ *   Copyright (C) 2018 - 2023 rjwats
+ *   Copyright (C) 2023 - 2025 theelims
+ *
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ **/
+
+#include <FSPersistenceWriter.h>
+#include <algorithm>
+#include <esp_timer.h>
+
+static const char *TAG = "FSPersistence";
+
+FSPersistenceWriter &FSPersistenceWriter::getInstance()
+{
+    static FSPersistenceWriter instance;
+    return instance;
+}
+
+FSPersistenceWriter::FSPersistenceWriter() : _mutex(xSemaphoreCreateMutex()),
+                                             _ioMutex(xSemaphoreCreateRecursiveMutex())
+{
+}
+
+void FSPersistenceWriter::registerJob(FSPersistenceJob *job)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (std::find(_jobs.begin(), _jobs.end(), job) == _jobs.end())
+    {
+        _jobs.push_back(job);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void FSPersistenceWriter::unregisterJob(FSPersistenceJob *job)
+{
+    // Waits for a write of this job in progress
+    lockIO();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _jobs.erase(std::remove(_jobs.begin(), _jobs.end(), job), _jobs.end());
+    xSemaphoreGive(_mutex);
+    unlockIO();
+}
+
+void FSPersistenceWriter::ensureTask()
+{
+    if (_taskHandle != nullptr)
+    {
+        return;
+    }
+    // Low priority: a settings write can wait for sensor polling and networking
+    xTaskCreatePinnedToCore(writerTask, "FSPersistence", 6144, this, 1, &_taskHandle, APP_CPU_NUM);
+    if (_taskHandle == nullptr)
+    {
+        ESP_LOGE(TAG, "Failed to create persistence writer task");
+    }
+}
+
+void FSPersistenceWriter::schedule(FSPersistenceJob *job, const uint32_t delayMs)
+{
+    if (_suspended)
+    {
+        return;
+    }
+
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t delay = pdMS_TO_TICKS(delayMs);
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    ensureTask();
+    if (!job->_pending)
+    {
+        job->_pending = true;
+        job->_firstChange = now;
+    }
+    else
+    {
+        job->_coalesced++;
+    }
+    // Each change restarts the delay, but a stream of changes cannot postpone the write forever
+    const TickType_t latest = job->_firstChange + delay * FS_PERSISTENCE_MAX_DELAY_FACTOR;
+    const TickType_t due = now + delay;
+    job->_due = static_cast<int32_t>(due - latest) > 0 ? latest : due;
+    TaskHandle_t task = _taskHandle;
+    if (task == nullptr)
+    {
+        job->_pending = false;
+    }
+    xSemaphoreGive(_mutex);
+
+    if (task != nullptr)
+    {
+        xTaskNotifyGive(task);
+    }
+    else
+    {
+        // No writer task: fall back to writing synchronously
+        job->writeToFS();
+    }
+}
+
+void FSPersistenceWriter::recordWrite(FSPersistenceJob *job, const bool ok, const uint32_t durationUs)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (ok)
+    {
+        job->_writes++;
+    }
+    else
+    {
+        job->_failures++;
+    }
+    job->_lastWriteUs = durationUs;
+    xSemaphoreGive(_mutex);
+}
+
+TickType_t FSPersistenceWriter::takeDue(std::vector<FSPersistenceJob *> &due, const bool all)
+{
+    const TickType_t now = xTaskGetTickCount();
+    TickType_t wait = portMAX_DELAY;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (FSPersistenceJob *job : _jobs)
+    {
+        if (!job->_pending)
+        {
+            continue;
+        }
+        const auto remaining = static_cast<int32_t>(job->_due - now);
+        if (all || remaining <= 0)
+        {
+            job->_pending = false;
+            due.push_back(job);
+        }
+        else if (static_cast<TickType_t>(remaining) < wait)
+        {
+            wait = static_cast<TickType_t>(remaining);
+        }
+    }
+    xSemaphoreGive(_mutex);
+    return wait;
+}
+
+void FSPersistenceWriter::writerTask(void *param)
+{
+    auto *self = static_cast<FSPersistenceWriter *>(param);
+    std::vector<FSPersistenceJob *> due;
+
+    while (true)
+    {
+        due.clear();
+        const TickType_t wait = self->takeDue(due, false);
+        if (due.empty())
+        {
+            ulTaskNotifyTake(pdTRUE, wait);
+            continue;
+        }
+
+        // A change arriving during the write sets the job pending again and is written later
+        self->lockIO();
+        for (FSPersistenceJob *job : due)
+        {
+            if (!self->_suspended)
+            {
+                job->writeToFS();
+            }
+        }
+        self->unlockIO();
+    }
+}
+
+void FSPersistenceWriter::flushAll()
+{
+    std::vector<FSPersistenceJob *> due;
+    lockIO();
+    takeDue(due, true);
+    for (FSPersistenceJob *job : due)
+    {
+        if (!_suspended)
+        {
+            job->writeToFS();
+        }
+    }
+    unlockIO();
+    if (!due.empty())
+    {
+        ESP_LOGI(TAG, "Flushed %u pending settings files", static_cast<unsigned>(due.size()));
+    }
+}
+
+void FSPersistenceWriter::suspend()
+{
+    // Waits for a write in progress, then drops the pending ones
+    lockIO();
+    _suspended = true;
+    std::vector<FSPersistenceJob *> dropped;
+    takeDue(dropped, true);
+    unlockIO();
+}
+
+void FSPersistenceWriter::lockIO()
+{
+    xSemaphoreTakeRecursive(_ioMutex, portMAX_DELAY);
+}
+
+void FSPersistenceWriter::unlockIO()
+{
+    xSemaphoreGiveRecursive(_ioMutex);
+}
+
+std::vector<FSPersistenceStats> FSPersistenceWriter::getStats()
+{
+    std::vector<FSPersistenceStats> stats;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    stats.reserve(_jobs.size());
+    for (const FSPersistenceJob *job : _jobs)
+    {
+        stats.push_back({job->getFilePath(), job->_writes, job->_failures, job->_coalesced, job->_lastWriteUs, job->_pending});
+    }
+    xSemaphoreGive(_mutex);
+    return stats;
+}
@@ -0,0 +1,120 @@
+#ifndef FSPersistenceWriter_h
+#define FSPersistenceWriter_h
+
+/**
+ *   ESP32 SvelteKit
+ *
+ *   A simple, secure and extensible framework for IoT projects for ESP32 platforms
+ *   with responsive Sveltekit front-end built with TailwindCSS and DaisyUI.
+ *   https://github.com/theelims/ESP32-sveltekit
+ *
+ *   Copyright (C) 2018 - 2023 rjwats
+ *   Copyright (C) 2023 - 2025 theelims
+ *
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ **/
+
+#include <Arduino.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+// Default delay between a state change and the file write. Further changes within the
+// delay are coalesced into the same write.
+#ifndef FS_PERSISTENCE_WRITE_DELAY_MS
+#define FS_PERSISTENCE_WRITE_DELAY_MS 1000
+#endif
+
+// A write is never postponed by further changes for longer than this many delays
+#define FS_PERSISTENCE_MAX_DELAY_FACTOR 4
+
+// Write statistics of one persisted file, for flash wear monitoring
+struct FSPersistenceStats
+{
+    const char *path;
+    uint32_t writes;      // Successful writes since boot
+    uint32_t failures;    // Failed writes since boot
+    uint32_t coalesced;   // State changes merged into another write
+    uint32_t lastWriteUs; // Duration of the last write
+    bool pending;         // A write is scheduled
+};
+
+/**
+ * A file written by the background writer. Implemented by FSPersistence.
+ */
+class FSPersistenceJob
+{
+public:
+    virtual ~FSPersistenceJob() = default;
+    virtual const char *getFilePath() const = 0;
+
+    // Writes the current state to the file. Returns false if the write failed.
+    virtual bool writeToFS() = 0;
+
+private:
+    friend class FSPersistenceWriter;
+
+    // Guarded by the writer mutex
+    bool _pending = false;
+    TickType_t _due = 0;
+    TickType_t _firstChange = 0;
+    uint32_t _writes = 0;
+    uint32_t _failures = 0;
+    uint32_t _coalesced = 0;
+    uint32_t _lastWriteUs = 0;
+};
+
+/**
+ * Background task writing persisted state files. Update handlers only schedule a write;
+ * the task writes each file once its delay has passed without further changes.
+ */
+class FSPersistenceWriter
+{
+public:
+    static FSPersistenceWriter &getInstance();
+
+    void registerJob(FSPersistenceJob *job);
+    void unregisterJob(FSPersistenceJob *job);
+
+    // Schedules a write of the job's file after delayMs, coalescing with a pending one
+    void schedule(FSPersistenceJob *job, uint32_t delayMs);
+
+    // Records the result of a write (called by the job for every write, scheduled or not)
+    void recordWrite(FSPersistenceJob *job, bool ok, uint32_t durationUs);
+
+    // Writes all pending files now, e.g. before a restart
+    void flushAll();
+
+    // Drops pending writes and blocks further ones until restart (factory reset)
+    void suspend();
+
+    bool isSuspended() const
+    {
+        return _suspended;
+    }
+
+    // Serialises file writes: the writer task, synchronous writes and flushAll()
+    void lockIO();
+    void unlockIO();
+
+    std::vector<FSPersistenceStats> getStats();
+
+private:
+    FSPersistenceWriter();
+
+    static void writerTask(void *param);
+    void ensureTask();
+
+    // Collects due jobs and clears their pending flag; returns ticks until the next due job
+    TickType_t takeDue(std::vector<FSPersistenceJob *> &due, bool all);
+
+    std::vector<FSPersistenceJob *> _jobs;
+    SemaphoreHandle_t _mutex;   // _jobs and the job scheduling fields
+    SemaphoreHandle_t _ioMutex; // File writes
+    TaskHandle_t _taskHandle = nullptr;
+    volatile bool _suspended = false;
+};
+
+#endif // end FSPersistenceWriter_h
@@ -46,6 +46,9 @@ esp_err_t FactoryResetService::handleRequest(PsychicRequest *request)
  */
 void FactoryResetService::factoryReset()
 {
+    // Pending settings writes would otherwise recreate the files before the restart
+    FSPersistenceWriter::getInstance().suspend();
+
     File root = fs->open(FS_CONFIG_DIRECTORY);
     File file;
     while (file = root.openNextFile())
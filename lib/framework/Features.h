@@ -62,6 +62,11 @@
 #define EVENT_USE_JSON 0
 #endif
 
+// Store settings files and profiles as MessagePack, off by default (JSON)
+#ifndef FS_PERSISTENCE_USE_MSGPACK
+#define FS_PERSISTENCE_USE_MSGPACK 0
+#endif
+
 // Endpoint for Core Dump, off by default
 #ifndef FT_COREDUMP
 #define FT_COREDUMP 0
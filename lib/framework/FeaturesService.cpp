@@ -29,7 +29,7 @@ void FeaturesService::begin()
 
     ESP_LOGV(SVK_TAG, "Registered GET endpoint: %s", FEATURES_SERVICE_PATH);
 
-    _socket->registerEvent(FEATURES_SERVICE_EVENT);
+    _socket->registerEvent(FEATURES_SERVICE_EVENT, true);
 
     _socket->onSubscribe(FEATURES_SERVICE_EVENT, [&](const String &originId)
                          {
@@ -64,10 +64,7 @@ public:
                     _securityManager->wrapRequest(
                         [this](PsychicRequest *request)
                         {
-                            PsychicJsonResponse response = PsychicJsonResponse(request, false);
-                            JsonObject jsonObject = response.getRoot();
-                            _statefulService->read(jsonObject, _stateReader);
-                            return response.send();
+                            return sendState(request);
                         },
                         _authenticationPredicate));
         ESP_LOGV(SVK_TAG, "Registered GET endpoint: %s", _servicePath);
@@ -96,17 +93,24 @@ public:
                                 _statefulService->callUpdateHandlers(HTTP_ENDPOINT_ORIGIN_ID);
                             }
 
-                            PsychicJsonResponse response = PsychicJsonResponse(request, false);
-                            jsonObject = response.getRoot();
-
-                            _statefulService->read(jsonObject, _stateReader);
-
-                            return response.send();
+                            return sendState(request);
                         },
                         _authenticationPredicate));
 
         ESP_LOGV(SVK_TAG, "Registered POST endpoint: %s", _servicePath);
     }
+
+protected:
+    // Replies with the cached JSON encoding shared with the service's other endpoints
+    esp_err_t sendState(PsychicRequest *request)
+    {
+        EncodedState payload = _statefulService->encode(_stateReader, StateEncoding::JSON);
+        PsychicResponse response(request);
+        response.setCode(200);
+        response.setContentType("application/json");
+        response.setContent(reinterpret_cast<const uint8_t *>(payload->data()), payload->size());
+        return response.send();
+    }
 };
 
 #endif
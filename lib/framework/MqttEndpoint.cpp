@@ -17,4 +17,271 @@
 
 std::vector<MqttCommitHandler *> MqttCommitHandler::_instances;
 TimerHandle_t MqttCommitHandler::_sendTimer = nullptr;
-uint32_t MqttCommitHandler::_timerIntervalMs = FACTORY_MQTT_MIN_MESSAGE_INTERVAL_MS; // default
\ No newline at end of file
+SemaphoreHandle_t MqttCommitHandler::_commitMutex = nullptr;
+uint32_t MqttCommitHandler::_timerIntervalMs = FACTORY_MQTT_MIN_MESSAGE_INTERVAL_MS; // default
+uint32_t MqttCommitHandler::_dirtyMask = 0;
+uint32_t MqttCommitHandler::_heartbeatMask = 0;
+bool MqttCommitHandler::_timerArmed = false;
+uint32_t MqttCommitHandler::_armedDueMs = 0;
+
+#define MQTT_ENDPOINT_BIT(index) ((uint32_t)1 << (index))
+
+MqttCommitHandler::MqttCommitHandler()
+{
+    if (_instances.size() == 0)
+    {
+        _sendTimer = xTimerCreate("MqttSendTimer",
+                                  pdMS_TO_TICKS(500),
+                                  pdFALSE, // one-shot, armed for the next due endpoint
+                                  nullptr,
+                                  commitPending);
+        _commitMutex = xSemaphoreCreateMutex();
+    }
+    _index = _instances.size();
+    _instances.push_back(this);
+    if (_index >= MQTT_MAX_ENDPOINTS)
+    {
+        ESP_LOGW(SVK_TAG, "More than %d MQTT endpoints, endpoint %u publishes unthrottled", MQTT_MAX_ENDPOINTS, (unsigned)_index);
+    }
+}
+
+MqttCommitHandler::~MqttCommitHandler()
+{
+    xSemaphoreTake(_commitMutex, portMAX_DELAY);
+    _instances[_index] = nullptr; // indexes of the other endpoints stay valid
+    if (_index < MQTT_MAX_ENDPOINTS)
+    {
+        _dirtyMask &= ~MQTT_ENDPOINT_BIT(_index);
+        _heartbeatMask &= ~MQTT_ENDPOINT_BIT(_index);
+    }
+    xSemaphoreGive(_commitMutex);
+}
+
+void MqttCommitHandler::setPublishIntervals(uint32_t minIntervalMs, uint32_t maxIntervalMs)
+{
+    xSemaphoreTake(_commitMutex, portMAX_DELAY);
+    _minIntervalMs = minIntervalMs;
+    _maxIntervalMs = maxIntervalMs;
+    if (_index < MQTT_MAX_ENDPOINTS)
+    {
+        if (maxIntervalMs > 0)
+        {
+            _heartbeatMask |= MQTT_ENDPOINT_BIT(_index);
+        }
+        else
+        {
+            _heartbeatMask &= ~MQTT_ENDPOINT_BIT(_index);
+        }
+        armNext(millis());
+    }
+    xSemaphoreGive(_commitMutex);
+}
+
+void MqttCommitHandler::setTimerInterval(uint32_t intervalMs)
+{
+    _timerIntervalMs = intervalMs;
+    if (_commitMutex)
+    {
+        // endpoints waiting for the old interval are rescheduled
+        xSemaphoreTake(_commitMutex, portMAX_DELAY);
+        armNext(millis());
+        xSemaphoreGive(_commitMutex);
+    }
+}
+
+void MqttCommitHandler::markDirty()
+{
+    uint32_t now = millis();
+    if (_index >= MQTT_MAX_ENDPOINTS || minInterval() == 0)
+    {
+        publishNow(now); // No throttling—send immediately
+        return;
+    }
+
+    xSemaphoreTake(_commitMutex, portMAX_DELAY);
+    if (_dirtyMask & MQTT_ENDPOINT_BIT(_index))
+    {
+        _coalesced++; // already waiting for its slot, which will publish the latest state
+    }
+    else
+    {
+        _dirtyMask |= MQTT_ENDPOINT_BIT(_index);
+        armTimer(now, _published ? _lastPublishMs + dueInterval(true) : now);
+    }
+    xSemaphoreGive(_commitMutex);
+}
+
+void MqttCommitHandler::commit()
+{
+    bool dirty = true;
+    if (_index < MQTT_MAX_ENDPOINTS)
+    {
+        xSemaphoreTake(_commitMutex, portMAX_DELAY);
+        dirty = _dirtyMask & MQTT_ENDPOINT_BIT(_index);
+        _dirtyMask &= ~MQTT_ENDPOINT_BIT(_index);
+        xSemaphoreGive(_commitMutex);
+    }
+    if (dirty)
+    {
+        publishNow(millis());
+    }
+}
+
+void MqttCommitHandler::publishNow(uint32_t now)
+{
+    size_t bytes = 0;
+    bool published = publishState(bytes);
+
+    xSemaphoreTake(_commitMutex, portMAX_DELAY);
+    // a failed attempt also counts, so an unreachable broker is not retried on every tick
+    _lastPublishMs = now;
+    _published = true;
+    _failed = !published && bytes > 0; // the payload was ready but the client did not take it
+    if (published)
+    {
+        _publishes++;
+        _bytes += bytes;
+    }
+    else if (_failed)
+    {
+        _failures++;
+        if (_index < MQTT_MAX_ENDPOINTS)
+        {
+            // dirty again, so the state is retried instead of waiting for the next change
+            _dirtyMask |= MQTT_ENDPOINT_BIT(_index);
+            armTimer(now, now + dueInterval(true));
+        }
+    }
+    xSemaphoreGive(_commitMutex);
+}
+
+void MqttCommitHandler::commitPending(TimerHandle_t xTimer)
+{
+    uint32_t now = millis();
+    xSemaphoreTake(_commitMutex, portMAX_DELAY);
+    _timerArmed = false;
+    uint32_t due = takeDue(now);
+    xSemaphoreGive(_commitMutex);
+
+    ESP_LOGV(SVK_TAG, "Publishing pending MQTT messages");
+    // all due endpoints are published in one pass, each with the payload cached by its service
+    while (due)
+    {
+        size_t index = __builtin_ctz(due);
+        due &= due - 1;
+        MqttCommitHandler *instance = _instances[index];
+        if (instance)
+        {
+            instance->publishNow(now);
+        }
+    }
+
+    xSemaphoreTake(_commitMutex, portMAX_DELAY);
+    armNext(millis());
+    xSemaphoreGive(_commitMutex);
+}
+
+uint32_t MqttCommitHandler::takeDue(uint32_t now)
+{
+    uint32_t due = 0;
+    uint32_t candidates = _dirtyMask | _heartbeatMask;
+    while (candidates)
+    {
+        size_t index = __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+        MqttCommitHandler *instance = _instances[index];
+        if (!instance)
+        {
+            continue;
+        }
+        bool dirty = _dirtyMask & MQTT_ENDPOINT_BIT(index);
+        if (!dirty && !instance->_published)
+        {
+            continue; // republishing starts with the first publish
+        }
+        uint32_t interval = instance->dueInterval(dirty);
+        if (!instance->_published || now - instance->_lastPublishMs >= interval)
+        {
+            due |= MQTT_ENDPOINT_BIT(index);
+        }
+    }
+    _dirtyMask &= ~due;
+    return due;
+}
+
+void MqttCommitHandler::armNext(uint32_t now)
+{
+    bool found = false;
+    uint32_t next = 0;
+    uint32_t candidates = _dirtyMask | _heartbeatMask;
+    while (candidates)
+    {
+        size_t index = __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+        MqttCommitHandler *instance = _instances[index];
+        if (!instance || !instance->_published)
+        {
+            if (instance && (_dirtyMask & MQTT_ENDPOINT_BIT(index)))
+            {
+                next = now; // never published, due right away
+                found = true;
+            }
+            continue;
+        }
+        uint32_t interval = instance->dueInterval(_dirtyMask & MQTT_ENDPOINT_BIT(index));
+        uint32_t dueMs = instance->_lastPublishMs + interval;
+        if (!found || (int32_t)(dueMs - next) < 0)
+        {
+            next = dueMs;
+            found = true;
+        }
+    }
+    if (found)
+    {
+        _timerArmed = false; // the earliest due endpoint replaces whatever the timer was armed for
+        armTimer(now, next);
+    }
+}
+
+void MqttCommitHandler::armTimer(uint32_t now, uint32_t dueMs)
+{
+    if (!_sendTimer || (_timerArmed && (int32_t)(_armedDueMs - dueMs) <= 0))
+    {
+        return; // already armed for an earlier or the same time
+    }
+    int32_t delayMs = (int32_t)(dueMs - now);
+    TickType_t ticks = delayMs > 0 ? pdMS_TO_TICKS(delayMs) : 0;
+    _timerArmed = true;
+    _armedDueMs = dueMs;
+    xTimerChangePeriod(_sendTimer, ticks > 0 ? ticks : 1, 0); // also starts the timer
+}
+
+MqttPublishStats MqttCommitHandler::getPublishStats()
+{
+    String topic = getPublishTopic();
+    xSemaphoreTake(_commitMutex, portMAX_DELAY);
+    MqttPublishStats stats = {topic,
+                              minInterval(),
+                              _maxIntervalMs,
+                              _publishes,
+                              _failures,
+                              _bytes,
+                              _coalesced,
+                              _lastPublishMs,
+                              _index < MQTT_MAX_ENDPOINTS && (_dirtyMask & MQTT_ENDPOINT_BIT(_index))};
+    xSemaphoreGive(_commitMutex);
+    return stats;
+}
+
+std::vector<MqttPublishStats> MqttCommitHandler::getAllPublishStats()
+{
+    std::vector<MqttPublishStats> stats;
+    for (auto instance : _instances)
+    {
+        if (instance)
+        {
+            stats.push_back(instance->getPublishStats());
+        }
+    }
+    return stats;
+}
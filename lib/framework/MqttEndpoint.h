@@ -22,58 +22,104 @@
 
 #define MQTT_ORIGIN_ID "mqtt"
 
-// Commit interface, needed to ensure that the MqttEndpoint can be used in a commit pattern without template
+// Endpoints tracked in the dirty and heartbeat bitmasks, later ones publish unthrottled
+#ifndef MQTT_MAX_ENDPOINTS
+#define MQTT_MAX_ENDPOINTS 32
+#endif
+
+// A publish the client rejected is retried after the minimum interval, but not sooner than this
+#ifndef MQTT_PUBLISH_RETRY_MS
+#define MQTT_PUBLISH_RETRY_MS 1000
+#endif
+
+struct MqttPublishStats
+{
+    String topic;
+    uint32_t minIntervalMs; // effective, after falling back to the global interval
+    uint32_t maxIntervalMs;
+    uint32_t publishes;
+    uint32_t failures;
+    uint32_t bytes;
+    uint32_t coalesced; // updates merged into a later publish
+    uint32_t lastPublishMs;
+    bool dirty;
+};
+
+// Commit interface, needed to ensure that the MqttEndpoint can be used in a commit pattern without template.
+// Each endpoint publishes at most once per minimum interval and, if a maximum interval is set, at least once
+// per maximum interval even if its state did not change. Only endpoints marked dirty or having a maximum
+// interval are looked at when the shared one-shot timer fires, which is armed for the earliest due endpoint.
 class MqttCommitHandler
 {
 public:
-    MqttCommitHandler()
-    {
-        if (_instances.size() == 0)
-        {
-            _sendTimer = xTimerCreate("MqttSendTimer",
-                                      pdMS_TO_TICKS(500),
-                                      pdTRUE,
-                                      nullptr,
-                                      commitPending);
-            setTimerInterval(_timerIntervalMs);
-        }
-        _instances.push_back(this);
-    }
-    virtual void commit() {};
-    virtual ~MqttCommitHandler() = default;
-    static void setTimerInterval(uint32_t intervalMs)
-    {
-        _timerIntervalMs = intervalMs;
-        if (_sendTimer)
-        {
-            if (intervalMs == 0)
-            {
-                xTimerStop(_sendTimer, 0); // Disable timer (no throttling)
-            }
-            else
-            {
-                xTimerChangePeriod(_sendTimer, pdMS_TO_TICKS(intervalMs), 0); // Update interval
-                xTimerStart(_sendTimer, 0);
-            }
-        }
-    }
+    MqttCommitHandler();
+    virtual ~MqttCommitHandler();
+
+    // Publishes right away if there are unpublished changes, ignoring the intervals
+    void commit();
+
+    // minIntervalMs = 0 uses the global interval from the MQTT settings, maxIntervalMs = 0 disables republishing
+    void setPublishIntervals(uint32_t minIntervalMs, uint32_t maxIntervalMs = 0);
+
+    MqttPublishStats getPublishStats();
+
+    // Default minimum interval of all endpoints, 0 = no throttling
+    static void setTimerInterval(uint32_t intervalMs);
     static uint32_t getTimerInterval()
     {
         return _timerIntervalMs;
     }
 
+    static std::vector<MqttPublishStats> getAllPublishStats();
+
 protected:
-    static std::vector<MqttCommitHandler *> _instances;
-    static void commitPending(TimerHandle_t xTimer)
+    // Called on every state change, publishes now or once the minimum interval has passed
+    void markDirty();
+
+    // Publishes the current state, returns false if nothing was sent. bytes receives the payload size.
+    virtual bool publishState(size_t &bytes) = 0;
+    virtual String getPublishTopic() = 0;
+
+private:
+    size_t _index;
+    uint32_t _minIntervalMs = 0;
+    uint32_t _maxIntervalMs = 0;
+    uint32_t _lastPublishMs = 0;
+    bool _published = false; // _lastPublishMs is valid
+    bool _failed = false;    // the last publish was rejected and is pending a retry
+    uint32_t _publishes = 0;
+    uint32_t _failures = 0;
+    uint32_t _bytes = 0;
+    uint32_t _coalesced = 0;
+
+    uint32_t minInterval()
     {
-        ESP_LOGV(SVK_TAG, "Publishing pending MQTT messages");
-        for (auto instance : _instances)
+        return _minIntervalMs ? _minIntervalMs : _timerIntervalMs;
+    }
+    // Time after the last publish at which the endpoint is due again
+    uint32_t dueInterval(bool dirty)
+    {
+        if (!dirty)
         {
-            instance->commit();
+            return _maxIntervalMs;
         }
+        return _failed && minInterval() < MQTT_PUBLISH_RETRY_MS ? MQTT_PUBLISH_RETRY_MS : minInterval();
     }
+    void publishNow(uint32_t now);
+
+    static std::vector<MqttCommitHandler *> _instances;
     static TimerHandle_t _sendTimer;
+    static SemaphoreHandle_t _commitMutex; // guards the masks and the timer state below
     static uint32_t _timerIntervalMs;
+    static uint32_t _dirtyMask;
+    static uint32_t _heartbeatMask;
+    static bool _timerArmed;
+    static uint32_t _armedDueMs;
+
+    static void commitPending(TimerHandle_t xTimer);
+    static uint32_t takeDue(uint32_t now);
+    static void armNext(uint32_t now);
+    static void armTimer(uint32_t now, uint32_t dueMs);
 };
 
 template <class T>
@@ -94,8 +140,7 @@ public:
                                         _pubTopic(pubTopic),
                                         _subTopic(subTopic),
                                         _qos(QoS),
-                                        _retain(retain),
-                                        _pendingCommit(false)
+                                        _retain(retain)
 
     {
         _statefulService->addUpdateHandler([&](const String &originId)
@@ -146,36 +191,9 @@ public:
         publish();
     }
 
-    void commit() override
-    {
-        if (!_pendingCommit)
-        {
-            return; // nothing to do
-        }
-        if (_pubTopic.length() > 0 && _mqttClient->connected())
-        {
-            // serialize to json doc
-            JsonDocument json;
-            JsonObject jsonObject = json.to<JsonObject>();
-            _statefulService->read(jsonObject, _stateReader);
-
-            // serialize to string
-            String payload;
-            serializeJson(json, payload);
-
-            // publish the payload
-            _mqttClient->publish(_pubTopic.c_str(), _qos, _retain, payload.c_str(), 0, false);
-        }
-        _pendingCommit = false;
-    }
-
     void publish()
     {
-        _pendingCommit = true;
-        if (MqttCommitHandler::getTimerInterval() == 0)
-        {
-            commit(); // No throttling—send immediately
-        }
+        markDirty();
     }
 
     PsychicMqttClient *getMqttClient()
@@ -192,7 +210,27 @@ protected:
     String _pubTopic;
     int _qos;
     bool _retain;
-    bool _pendingCommit;
+
+    bool publishState(size_t &bytes) override
+    {
+        if (_pubTopic.length() == 0 || !_mqttClient->connected())
+        {
+            return false;
+        }
+        // the JSON encoding is shared with the service's other endpoints and reused while the state is unchanged
+        EncodedState payload = _statefulService->encode(_stateReader, StateEncoding::JSON);
+        if (!payload)
+        {
+            return false;
+        }
+        bytes = payload->size();
+        return _mqttClient->publish(_pubTopic.c_str(), _qos, _retain, payload->data(), static_cast<int>(payload->size()), false) >= 0;
+    }
+
+    String getPublishTopic() override
+    {
+        return _pubTopic;
+    }
 
     void onMqttMessage(char *topic,
                        char *payload,
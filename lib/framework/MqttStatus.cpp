@@ -42,6 +42,21 @@ esp_err_t MqttStatus::mqttStatus(PsychicRequest *request)
     root["client_id"] = _mqttSettingsService->getClientId();
     root["last_error"] = _mqttSettingsService->getLastError();
 
+    JsonArray endpoints = root["endpoints"].to<JsonArray>();
+    for (const MqttPublishStats &stats : MqttCommitHandler::getAllPublishStats())
+    {
+        JsonObject entry = endpoints.add<JsonObject>();
+        entry["topic"] = stats.topic;
+        entry["min_interval_ms"] = stats.minIntervalMs;
+        entry["max_interval_ms"] = stats.maxIntervalMs;
+        entry["publishes"] = stats.publishes;
+        entry["failures"] = stats.failures;
+        entry["bytes"] = stats.bytes;
+        entry["coalesced"] = stats.coalesced;
+        entry["last_publish_ms"] = stats.lastPublishMs;
+        entry["dirty"] = stats.dirty;
+    }
+
     return response.send();
 }
 
@@ -18,6 +18,7 @@
 #include <WiFi.h>
 
 #include <MqttSettingsService.h>
+#include <MqttEndpoint.h>
 #include <ArduinoJson.h>
 #include <PsychicHttp.h>
 #include <SecurityManager.h>
@@ -20,6 +20,7 @@
 #include <ESPmDNS.h>
 #include <PsychicHttp.h>
 #include <SecurityManager.h>
+#include <FSPersistenceWriter.h>
 
 #define RESTART_SERVICE_PATH "/rest/restart"
 
@@ -32,6 +33,8 @@ public:
 
     static void restartNow()
     {
+        // Settings changed just before the restart are still waiting for their write delay
+        FSPersistenceWriter::getInstance().flushAll();
         delay(250);
         MDNS.end();
         delay(100);
@@ -20,6 +20,8 @@
 
 #include <list>
 #include <functional>
+#include <memory>
+#include <vector>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
@@ -36,6 +38,47 @@ using JsonStateUpdater = std::function<StateUpdateResult(JsonObject &root, T &se
 template <typename T>
 using JsonStateReader = std::function<void(T &settings, JsonObject &root)>;
 
+// Number of encodings kept per service, e.g. JSON for HTTP and MQTT plus MessagePack for events
+#ifndef STATE_ENCODE_CACHE_SLOTS
+#define STATE_ENCODE_CACHE_SLOTS 3
+#endif
+
+enum class StateEncoding : uint8_t
+{
+    JSON,
+    MSGPACK
+};
+
+// An encoded state, shared by every transport sending the same state version
+typedef std::shared_ptr<const std::vector<char>> EncodedState;
+
+/**
+ * Identifies a state reader for the encode cache. Readers are compared by the address of the
+ * function they wrap; lambdas and bound members cannot be compared and return nullptr, their
+ * encodings are not cached.
+ */
+template <typename T>
+const void *stateReaderKey(const JsonStateReader<T> &stateReader)
+{
+    if (auto f = stateReader.template target<void (*)(T &, JsonObject &)>())
+    {
+        return reinterpret_cast<const void *>(*f);
+    }
+    if (auto f = stateReader.template target<void (*)(const T &, JsonObject &)>())
+    {
+        return reinterpret_cast<const void *>(*f);
+    }
+    if (auto f = stateReader.template target<void (*)(const T &, const JsonObject &)>())
+    {
+        return reinterpret_cast<const void *>(*f);
+    }
+    if (auto f = stateReader.template target<void (*)(T &, const JsonObject &)>())
+    {
+        return reinterpret_cast<const void *>(*f);
+    }
+    return nullptr;
+}
+
 typedef size_t update_handler_id_t;
 typedef size_t hook_handler_id_t;
 typedef std::function<void(const String &originId)> StateUpdateCallback;
@@ -64,7 +107,9 @@ class StatefulService
 {
 public:
     template <typename... Args>
-    StatefulService(Args &&...args) : _state(std::forward<Args>(args)...), _accessMutex(xSemaphoreCreateRecursiveMutex())
+    StatefulService(Args &&...args) : _state(std::forward<Args>(args)...),
+                                      _accessMutex(xSemaphoreCreateRecursiveMutex()),
+                                      _encodeMutex(xSemaphoreCreateMutex())
     {
     }
 
@@ -124,6 +169,7 @@ public:
     {
         beginTransaction();
         StateUpdateResult result = stateUpdater(_state);
+        publishSnapshot();
         endTransaction();
         callHookHandlers(originId, result);
         if (result == StateUpdateResult::CHANGED)
@@ -137,6 +183,7 @@ public:
     {
         beginTransaction();
         StateUpdateResult result = stateUpdater(_state);
+        publishSnapshot();
         endTransaction();
         return result;
     }
@@ -145,6 +192,7 @@ public:
     {
         beginTransaction();
         StateUpdateResult result = stateUpdater(jsonObject, _state);
+        publishSnapshot();
         endTransaction();
         callHookHandlers(originId, result);
         if (result == StateUpdateResult::CHANGED)
@@ -158,12 +206,143 @@ public:
     {
         beginTransaction();
         StateUpdateResult result = stateUpdater(jsonObject, _state);
+        publishSnapshot();
         endTransaction();
         return result;
     }
 
+    /**
+     * Opt-in snapshot mode for small states: every write publishes an immutable, versioned
+     * copy of the state and read() works on the current copy without taking the access
+     * mutex. A slow reader (e.g. JSON serialisation) then neither blocks writers nor other
+     * readers. Readers must not modify the state they are given. Call before the service is
+     * used by other tasks.
+     */
+    void enableSnapshots()
+    {
+        beginTransaction();
+        _snapshotsEnabled = true;
+        publishSnapshot();
+        endTransaction();
+    }
+
+    bool snapshotsEnabled() const
+    {
+        return _snapshotsEnabled;
+    }
+
+    // Current snapshot and its state version, nullptr if snapshots are disabled
+    std::shared_ptr<const T> snapshot(uint32_t *version = nullptr) const
+    {
+        portENTER_CRITICAL(&_snapshotMux);
+        std::shared_ptr<const T> current = _snapshot;
+        if (version)
+        {
+            *version = _stateVersion;
+        }
+        portEXIT_CRITICAL(&_snapshotMux);
+        return current;
+    }
+
+    // Incremented by every write transaction
+    uint32_t stateVersion() const
+    {
+        portENTER_CRITICAL(&_snapshotMux);
+        uint32_t version = _stateVersion;
+        portEXIT_CRITICAL(&_snapshotMux);
+        return version;
+    }
+
+    /**
+     * Returns the state serialised by stateReader, shared between all endpoints of this service.
+     * The first call after a write reads the state and encodes it once; later calls for the same
+     * reader and encoding get the same buffer until the next write. Readers must therefore only
+     * depend on the state.
+     */
+    EncodedState encode(const JsonStateReader<T> &stateReader, StateEncoding encoding)
+    {
+        const void *readerKey = stateReaderKey(stateReader);
+
+        // Concurrent misses wait here instead of encoding the same version again
+        xSemaphoreTake(_encodeMutex, portMAX_DELAY);
+        const uint32_t version = stateVersion();
+        if (readerKey)
+        {
+            for (const EncodeCacheSlot &slot : _encodeCache)
+            {
+                if (slot.data && slot.readerKey == readerKey && slot.encoding == encoding && slot.version == version)
+                {
+                    EncodedState hit = slot.data;
+                    xSemaphoreGive(_encodeMutex);
+                    return hit;
+                }
+            }
+        }
+
+        JsonDocument jsonDocument;
+        JsonObject jsonObject = jsonDocument.to<JsonObject>();
+        uint32_t encodedVersion;
+        if (_snapshotsEnabled)
+        {
+            const std::shared_ptr<const T> current = snapshot(&encodedVersion);
+            stateReader(const_cast<T &>(*current), jsonObject);
+        }
+        else
+        {
+            beginTransaction();
+            encodedVersion = _stateVersion;
+            stateReader(_state, jsonObject);
+            endTransaction();
+        }
+
+        size_t length = encoding == StateEncoding::MSGPACK ? measureMsgPack(jsonDocument) : measureJson(jsonDocument);
+        auto buffer = std::make_shared<std::vector<char>>(length + 1);
+        if (encoding == StateEncoding::MSGPACK)
+        {
+            serializeMsgPack(jsonDocument, buffer->data(), length);
+        }
+        else
+        {
+            serializeJson(jsonDocument, buffer->data(), length + 1);
+        }
+        // keep the terminator in the allocation for transports expecting a C string, but not in size()
+        (*buffer)[length] = '\0';
+        buffer->resize(length);
+        EncodedState encoded = buffer;
+
+        if (readerKey)
+        {
+            // replace the slot of this reader and encoding, or the oldest one
+            EncodeCacheSlot *target = &_encodeCache[0];
+            for (EncodeCacheSlot &slot : _encodeCache)
+            {
+                if (slot.readerKey == readerKey && slot.encoding == encoding)
+                {
+                    target = &slot;
+                    break;
+                }
+                if (!slot.data || slot.version < target->version)
+                {
+                    target = &slot;
+                }
+            }
+            target->readerKey = readerKey;
+            target->encoding = encoding;
+            target->version = encodedVersion;
+            target->data = encoded;
+        }
+        xSemaphoreGive(_encodeMutex);
+        return encoded;
+    }
+
     void read(std::function<void(T &)> stateReader)
     {
+        if (_snapshotsEnabled)
+        {
+            const std::shared_ptr<const T> current = snapshot();
+            stateReader(const_cast<T &>(*current));
+            return;
+        }
         beginTransaction();
         stateReader(_state);
         endTransaction();
@@ -171,6 +350,12 @@ public:
 
     void read(JsonObject &jsonObject, JsonStateReader<T> stateReader)
     {
+        if (_snapshotsEnabled)
+        {
+            const std::shared_ptr<const T> current = snapshot();
+            stateReader(const_cast<T &>(*current), jsonObject);
+            return;
+        }
         beginTransaction();
         stateReader(_state, jsonObject);
         endTransaction();
@@ -205,8 +390,46 @@ protected:
         xSemaphoreGiveRecursive(_accessMutex);
     }
 
+    // Starts a new state version, which invalidates cached encodings, and publishes a copy of
+    // _state for snapshot readers. Must be called inside a transaction, so versions follow write
+    // order. Subclasses that write _state directly call it themselves before notifying update
+    // handlers.
+    void publishSnapshot()
+    {
+        if (!_snapshotsEnabled)
+        {
+            portENTER_CRITICAL(&_snapshotMux);
+            _stateVersion++;
+            portEXIT_CRITICAL(&_snapshotMux);
+            return;
+        }
+        std::shared_ptr<const T> next = std::make_shared<T>(_state);
+        portENTER_CRITICAL(&_snapshotMux);
+        _snapshot.swap(next);
+        _stateVersion++;
+        portEXIT_CRITICAL(&_snapshotMux);
+        // The previous snapshot is released here, outside the critical section; readers still
+        // holding it keep it alive until they finish
+    }
+
 private:
     SemaphoreHandle_t _accessMutex;
+
+    // Only the pointer swap and reference count increment happen under this spinlock
+    bool _snapshotsEnabled = false;
+    std::shared_ptr<const T> _snapshot;
+    uint32_t _stateVersion = 0;
+    mutable portMUX_TYPE _snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+
+    struct EncodeCacheSlot
+    {
+        const void *readerKey = nullptr;
+        StateEncoding encoding = StateEncoding::JSON;
+        uint32_t version = 0;
+        EncodedState data;
+    };
+    SemaphoreHandle_t _encodeMutex;
+    EncodeCacheSlot _encodeCache[STATE_ENCODE_CACHE_SLOTS];
     std::list<StateUpdateHandlerInfo_t> _updateHandlers;
     std::list<StateHookHandlerInfo_t> _hookHandlers;
 };
@@ -0,0 +1,153 @@
+/**
+ *   ESP32 SvelteKit
+ *
+ *   A simple, secure and extensible framework for IoT projects for ESP32 platforms
+ *   with responsive Sveltekit front-end built with TailwindCSS and DaisyUI.
+ *   https://github.com/theelims/ESP32-sveltekit
+ *
+ *   Copyright (C) 2018 - 2023 rjwats
+ *   Copyright (C) 2023 - 2025 theelims
+ *
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ **/
+
+#include <StatefulServiceBenchmark.h>
+#include <StatefulService.h>
+#include <esp_timer.h>
+#include <atomic>
+
+namespace
+{
+    const char *TAG = "StatefulBench";
+
+    struct BenchState
+    {
+        float values[16] = {};
+        String label = "benchmark";
+        uint32_t counter = 0;
+
+        static void read(const BenchState &state, JsonObject &root)
+        {
+            root["label"] = state.label;
+            root["counter"] = state.counter;
+            JsonArray values = root["values"].to<JsonArray>();
+            for (const float value : state.values)
+            {
+                values.add(value);
+            }
+        }
+    };
+
+    struct BenchContext
+    {
+        StatefulService<BenchState> service;
+        std::atomic<bool> stop{false};
+        SemaphoreHandle_t done = nullptr;
+        portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        StatefulServiceBenchmark::Result result;
+        uint64_t readUsTotal = 0;
+    };
+
+    void readerTask(void *param)
+    {
+        auto *ctx = static_cast<BenchContext *>(param);
+        uint32_t reads = 0;
+        uint32_t maxUs = 0;
+        uint64_t totalUs = 0;
+        while (!ctx->stop.load())
+        {
+            JsonDocument doc;
+            JsonObject root = doc.to<JsonObject>();
+            const int64_t started = esp_timer_get_time();
+            ctx->service.read(root, BenchState::read);
+            const auto elapsed = static_cast<uint32_t>(esp_timer_get_time() - started);
+            reads++;
+            totalUs += elapsed;
+            maxUs = elapsed > maxUs ? elapsed : maxUs;
+        }
+        portENTER_CRITICAL(&ctx->mux);
+        ctx->result.reads += reads;
+        ctx->readUsTotal += totalUs;
+        ctx->result.maxReadUs = maxUs > ctx->result.maxReadUs ? maxUs : ctx->result.maxReadUs;
+        portEXIT_CRITICAL(&ctx->mux);
+        xSemaphoreGive(ctx->done);
+        vTaskDelete(nullptr);
+    }
+
+    void writerTask(void *param)
+    {
+        auto *ctx = static_cast<BenchContext *>(param);
+        uint32_t writes = 0;
+        uint32_t maxUs = 0;
+        TickType_t lastWake = xTaskGetTickCount();
+        while (!ctx->stop.load())
+        {
+            const int64_t started = esp_timer_get_time();
+            ctx->service.update(
+                [](BenchState &state)
+                {
+                    state.counter++;
+                    for (float &value : state.values)
+                    {
+                        value += 0.25f;
+                    }
+                    return StateUpdateResult::CHANGED;
+                },
+                "bench");
+            const auto elapsed = static_cast<uint32_t>(esp_timer_get_time() - started);
+            writes++;
+            maxUs = elapsed > maxUs ? elapsed : maxUs;
+            vTaskDelayUntil(&lastWake, 1);
+        }
+        portENTER_CRITICAL(&ctx->mux);
+        ctx->result.writes = writes;
+        ctx->result.maxWriteUs = maxUs;
+        portEXIT_CRITICAL(&ctx->mux);
+        xSemaphoreGive(ctx->done);
+        vTaskDelete(nullptr);
+    }
+}
+
+StatefulServiceBenchmark::Result StatefulServiceBenchmark::run(const bool snapshots, const uint32_t durationMs, const uint8_t readers)
+{
+    BenchContext ctx;
+    ctx.done = xSemaphoreCreateCounting(readers + 1, 0);
+    if (snapshots)
+    {
+        ctx.service.enableSnapshots();
+    }
+
+    // The writer gets the higher priority, as the sensor loop does in the firmware
+    xTaskCreatePinnedToCore(writerTask, "benchWriter", 4096, &ctx, 3, nullptr, 1);
+    for (uint8_t i = 0; i < readers; i++)
+    {
+        xTaskCreatePinnedToCore(readerTask, "benchReader", 4096, &ctx, 2, nullptr, i % 2);
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(durationMs));
+    ctx.stop.store(true);
+    for (uint8_t i = 0; i < readers + 1; i++)
+    {
+        xSemaphoreTake(ctx.done, portMAX_DELAY);
+    }
+    vSemaphoreDelete(ctx.done);
+
+    if (ctx.result.reads > 0)
+    {
+        ctx.result.avgReadUs = static_cast<uint32_t>(ctx.readUsTotal / ctx.result.reads);
+    }
+    return ctx.result;
+}
+
+void StatefulServiceBenchmark::runAndLog(const uint32_t durationMs)
+{
+    const char *modes[] = {"mutex", "snapshot"};
+    for (int i = 0; i < 2; i++)
+    {
+        const Result result = run(i == 1, durationMs);
+        ESP_LOGI(TAG, "%-8s reads: %lu (avg %lu us, max %lu us), writes: %lu (max %lu us) in %lu ms",
+                 modes[i], result.reads, result.avgReadUs, result.maxReadUs,
+                 result.writes, result.maxWriteUs, durationMs);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef StatefulServiceBenchmark_h
+#define StatefulServiceBenchmark_h
+
+/**
+ *   ESP32 SvelteKit
+ *
+ *   A simple, secure and extensible framework for IoT projects for ESP32 platforms
+ *   with responsive Sveltekit front-end built with TailwindCSS and DaisyUI.
+ *   https://github.com/theelims/ESP32-sveltekit
+ *
+ *   Copyright (C) 2018 - 2023 rjwats
+ *   Copyright (C) 2023 - 2025 theelims
+ *
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ **/
+
+#include <Arduino.h>
+
+/**
+ * Contention benchmark for StatefulService: one writer task updates a small state every
+ * millisecond while reader tasks on both cores serialise it to JSON as fast as they can.
+ * Runs the same load with the access mutex and with snapshot mode and logs both results.
+ *
+ * Enabled with the STATEFUL_SERVICE_BENCHMARK build flag (see platformio.ini).
+ */
+class StatefulServiceBenchmark
+{
+public:
+    struct Result
+    {
+        uint32_t reads = 0;
+        uint32_t writes = 0;
+        uint32_t avgReadUs = 0;
+        uint32_t maxReadUs = 0;
+        uint32_t maxWriteUs = 0; // Includes waiting for the access mutex
+    };
+
+    static Result run(bool snapshots, uint32_t durationMs = 2000, uint8_t readers = 2);
+
+    // Runs both modes and prints the comparison to the log
+    static void runAndLog(uint32_t durationMs = 2000);
+};
+
+#endif // end StatefulServiceBenchmark_h
@@ -14,6 +14,7 @@
 
 #include <SystemStatus.h>
 #include <esp32-hal.h>
+#include <FSPersistenceWriter.h>
 
 #if CONFIG_IDF_TARGET_ESP32 // ESP32/PICO-D4
 #include "esp32/rom/rtc.h"
@@ -113,8 +114,10 @@ String verbosePrintResetReason(int reason)
 }
 
 SystemStatus::SystemStatus(PsychicHttpServer *server,
-                           SecurityManager *securityManager) : _server(server),
-                                                               _securityManager(securityManager)
+                           SecurityManager *securityManager,
+                           EventSocket *socket) : _server(server),
+                                                  _securityManager(securityManager),
+                                                  _socket(socket)
 {
 }
 
@@ -162,5 +165,31 @@ esp_err_t SystemStatus::systemStatus(PsychicRequest *request)
     root["cpu_reset_reason"] = verbosePrintResetReason(esp_reset_reason());
     root["uptime"] = millis() / 1000;
 
+    // Settings file writes since boot, for flash wear monitoring
+    JsonArray fsWrites = root["fs_writes"].to<JsonArray>();
+    for (const FSPersistenceStats &stats : FSPersistenceWriter::getInstance().getStats())
+    {
+        JsonObject entry = fsWrites.add<JsonObject>();
+        entry["path"] = stats.path;
+        entry["writes"] = stats.writes;
+        entry["failures"] = stats.failures;
+        entry["coalesced"] = stats.coalesced;
+        entry["last_write_us"] = stats.lastWriteUs;
+        entry["pending"] = stats.pending;
+    }
+
+    // Outbound event queues of connected clients
+    JsonArray eventClients = root["event_clients"].to<JsonArray>();
+    for (const EventClientStats &stats : _socket->getClientStats())
+    {
+        JsonObject entry = eventClients.add<JsonObject>();
+        entry["id"] = stats.clientId;
+        entry["queue_depth"] = stats.depth;
+        entry["max_queue_depth"] = stats.maxDepth;
+        entry["sent"] = stats.sent;
+        entry["coalesced"] = stats.coalesced;
+        entry["dropped"] = stats.dropped;
+    }
+
     return response.send();
 }
@@ -20,6 +20,7 @@
 #include <ArduinoJson.h>
 #include <PsychicHttp.h>
 #include <SecurityManager.h>
+#include <EventSocket.h>
 #include <ESPFS.h>
 
 #define SYSTEM_STATUS_SERVICE_PATH "/rest/systemStatus"
@@ -27,13 +28,14 @@
 class SystemStatus
 {
 public:
-    SystemStatus(PsychicHttpServer *server, SecurityManager *securityManager);
+    SystemStatus(PsychicHttpServer *server, SecurityManager *securityManager, EventSocket *socket);
 
     void begin();
 
 private:
     PsychicHttpServer *_server;
     SecurityManager *_securityManager;
+    EventSocket *_socket;
     esp_err_t systemStatus(PsychicRequest *request);
 };
 
@@ -77,7 +77,7 @@ void WiFiSettingsService::initWiFi()
 
 void WiFiSettingsService::begin()
 {
-    _socket->registerEvent(EVENT_RSSI);
+    _rssiEvent = _socket->registerEvent(EVENT_RSSI, true);
     _socket->registerEvent(EVENT_RECONNECT);
 
     _httpEndpoint.begin();
@@ -312,11 +312,15 @@ void WiFiSettingsService::configureNetwork(wifi_settings_t &network)
 
 void WiFiSettingsService::updateRSSI()
 {
+    if (!_socket->hasSubscribers(_rssiEvent))
+    {
+        return;
+    }
     JsonDocument doc;
     doc["rssi"] = WiFi.RSSI();
     doc["ssid"] = WiFi.isConnected() ? WiFi.SSID() : "disconnected";
     JsonObject jsonObject = doc.as<JsonObject>();
-    _socket->emitEvent(EVENT_RSSI, jsonObject);
+    _socket->emitEvent(_rssiEvent, jsonObject);
 }
 
 void WiFiSettingsService::onStationModeDisconnected(WiFiEvent_t event, WiFiEventInfo_t info)
@@ -231,6 +231,7 @@ private:
     HttpEndpoint<WiFiSettings> _httpEndpoint;
     FSPersistence<WiFiSettings> _fsPersistence;
     EventSocket *_socket;
+    EventId _rssiEvent = EVENT_ID_INVALID;
     unsigned long _lastConnectionAttempt;
     unsigned long _lastRssiUpdate;
     unsigned long _delayedReconnectTime;
@@ -11,7 +11,8 @@ HandlerRegistrator::HandlerRegistrator(PsychicHttpServer& server,
                                  SubsystemHandler& subsystemHandler,
                                  OpenConnectHandler& openConnectHandler,
                                  ProfileHandler& profileHandler,
-                                 FileHandler& fileHandler)
+                                 FileHandler& fileHandler,
+                                 AlarmHandler& alarmHandler)
     : _server(server),
       _securityManager(securityManager),
       _settingsHandler(settingsHandler),
@@ -21,7 +22,8 @@ HandlerRegistrator::HandlerRegistrator(PsychicHttpServer& server,
       _subsystemHandler(subsystemHandler),
       _openConnectHandler(openConnectHandler),
       _profileHandler(profileHandler),
-      _fileHandler(fileHandler)
+      _fileHandler(fileHandler),
+      _alarmHandler(alarmHandler)
 {}
 
 void HandlerRegistrator::registerAllHandlers() const
@@ -36,6 +38,7 @@ void HandlerRegistrator::registerAllHandlers() const
     registerTelegramBotHandler();
     registerProfileHandler();
     registerFileHandler();
+    registerAlarmHandlers();
 
     ESP_LOGI(TAG, "All HTTP handlers registered successfully");
 }
@@ -75,6 +78,41 @@ void HandlerRegistrator::registerSensorHandlers() const
                       return SensorHandler::updateSensorZone(request);
                   },
                   AuthenticationPredicates::IS_AUTHENTICATED));
+
+    _server.on("/rest/sensors/resolution", HTTP_PUT,
+              _securityManager->wrapRequest(
+                  [](PsychicRequest* request) {
+                      return SensorHandler::updateSensorResolution(request);
+                  },
+                  AuthenticationPredicates::IS_AUTHENTICATED));
+
+    _server.on("/rest/sensors/rescan", HTTP_POST,
+              _securityManager->wrapRequest(
+                  [](PsychicRequest* request) {
+                      return SensorHandler::rescanBus(request);
+                  },
+                  AuthenticationPredicates::IS_AUTHENTICATED));
+
+    _server.on("/rest/sensors/trend", HTTP_GET,
+              _securityManager->wrapRequest(
+                  [](PsychicRequest* request) {
+                      return SensorHandler::getSensorTrends(request);
+                  },
+                  AuthenticationPredicates::IS_AUTHENTICATED));
+
+    _server.on("/rest/sensors/timing", HTTP_GET,
+              _securityManager->wrapRequest(
+                  [](PsychicRequest* request) {
+                      return SensorHandler::getPollTiming(request);
+                  },
+                  AuthenticationPredicates::IS_AUTHENTICATED));
+
+    _server.on("/rest/sensors/health", HTTP_GET,
+              _securityManager->wrapRequest(
+                  [](PsychicRequest* request) {
+                      return SensorHandler::getBusHealth(request);
+                  },
+                  AuthenticationPredicates::IS_AUTHENTICATED));
 }
 
 
@@ -196,3 +234,20 @@ void HandlerRegistrator::registerFileHandler() const
 {
     _fileHandler.registerHandlers(_server, _securityManager);
 }
+
+void HandlerRegistrator::registerAlarmHandlers() const
+{
+    _server.on("/rest/alarms/journal", HTTP_GET,
+              _securityManager->wrapRequest(
+                  [](PsychicRequest* request) {
+                      return AlarmHandler::getJournal(request);
+                  },
+                  AuthenticationPredicates::IS_AUTHENTICATED));
+
+    _server.on("/rest/alarms/dispatch", HTTP_GET,
+              _securityManager->wrapRequest(
+                  [](PsychicRequest* request) {
+                      return AlarmHandler::getDispatchStats(request);
+                  },
+                  AuthenticationPredicates::IS_AUTHENTICATED));
+}
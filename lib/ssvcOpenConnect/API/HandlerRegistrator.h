@@ -12,6 +12,7 @@
 #include "handlers/TelegramBot/TelegramBotHandler.h"
 #include "handlers/ProfileHandler/ProfileHandler.h"
 #include "handlers/FileHandler/FileHandler.h"
+#include "handlers/AlarmHandler/AlarmHandler.h"
 
 class HandlerRegistrator {
 public:
@@ -24,7 +25,8 @@ public:
                     SubsystemHandler& subsystemHandler,
                     OpenConnectHandler& openConnectHandler,
                     ProfileHandler& profileHandler,
-                    FileHandler& fileHandler);
+                    FileHandler& fileHandler,
+                    AlarmHandler& alarmHandler);
 
     void registerAllHandlers() const;
 
@@ -40,6 +42,7 @@ private:
     OpenConnectHandler& _openConnectHandler;
     ProfileHandler& _profileHandler;
     FileHandler& _fileHandler;
+    AlarmHandler& _alarmHandler;
 
     void registerSettingsHandlers() const;
     void registerCommandHandlers() const;
@@ -49,6 +52,7 @@ private:
     void registerTelegramBotHandler() const;
     void registerProfileHandler() const;
     void registerFileHandler() const;
+    void registerAlarmHandlers() const;
 };
 
 #endif
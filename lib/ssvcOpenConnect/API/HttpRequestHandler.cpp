@@ -16,6 +16,7 @@ HttpRequestHandler::HttpRequestHandler(PsychicHttpServer& server,
         _openConnectHandler(),
         _profileHandler(profileService),
         _fileHandler(fs),
+        _alarmHandler(),
         _handlerRegistrar(server,
                         securityManager,
                         _settingsHandler,
@@ -25,7 +26,8 @@ HttpRequestHandler::HttpRequestHandler(PsychicHttpServer& server,
                         _subsystemHandler,
                         _openConnectHandler,
                         _profileHandler,
-                        _fileHandler)
+                        _fileHandler,
+                        _alarmHandler)
 {
 
 }
@@ -31,6 +31,7 @@ private:
     OpenConnectHandler _openConnectHandler;
     ProfileHandler _profileHandler;
     FileHandler _fileHandler;
+    AlarmHandler _alarmHandler;
 
     HandlerRegistrator _handlerRegistrar;
 };
@@ -0,0 +1,122 @@
+#include "AlarmHandler.h"
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <vector>
+#include "core/AlarmSubscribers/Journal/AlarmJournal.h"
+
+AlarmHandler::AlarmHandler() = default;
+
+static const char* levelName(const uint8_t level)
+{
+    switch (static_cast<AlarmLevel>(level)) {
+    case AlarmLevel::MIN: return "MIN";
+    case AlarmLevel::DANGEROUS: return "DANGEROUS";
+    case AlarmLevel::CRITICAL: return "CRITICAL";
+    case AlarmLevel::NORMAL:
+    default: return "NORMAL";
+    }
+}
+
+static const char* causeName(const uint8_t cause)
+{
+    switch (static_cast<AlarmCause>(cause)) {
+    case AlarmCause::RATE_OF_CHANGE: return "rate";
+    case AlarmCause::SENSOR_FAILURE: return "failure";
+    case AlarmCause::RULE: return "rule";
+    case AlarmCause::THRESHOLD:
+    default: return "threshold";
+    }
+}
+
+uint32_t AlarmHandler::getUintParam(PsychicRequest* request, const char* name, const uint32_t defaultValue)
+{
+    if (!request->hasParam(name)) {
+        return defaultValue;
+    }
+    return static_cast<uint32_t>(strtoul(request->getParam(name)->value().c_str(), nullptr, 10));
+}
+
+esp_err_t AlarmHandler::getJournal(PsychicRequest* request)
+{
+    auto response = PsychicJsonResponse(request, false);
+    const JsonObject root = response.getRoot();
+    const AlarmJournal& journal = AlarmJournal::getInstance();
+
+    // Диапазон времени (Unix, с) и курсор: записи с seq > after
+    const uint32_t fromTime = getUintParam(request, "from", 0);
+    const uint32_t toTime = getUintParam(request, "to", UINT32_MAX);
+    const uint32_t afterSeq = getUintParam(request, "after", 0);
+    const size_t maxPage = AlarmJournal::MAX_PAGE;
+    size_t limit = getUintParam(request, "limit", maxPage);
+    if (limit == 0 || limit > maxPage) {
+        limit = maxPage;
+    }
+
+    std::vector<AlarmJournalRecord> records(limit);
+    const size_t count = journal.read(afterSeq, fromTime, toTime, records.data(), limit);
+
+    char addressHex[SENSOR_ID_HEX_LENGTH + 1];
+    const auto recordsArray = root["records"].to<JsonArray>();
+    for (size_t i = 0; i < count; i++) {
+        const AlarmJournalRecord& record = records[i];
+        sensorIdToHex(record.sensorId, addressHex);
+
+        const auto obj = recordsArray.add<JsonObject>();
+        obj["seq"] = record.seq;
+        obj["time"] = record.timestamp;
+        obj["address"] = static_cast<const char*>(addressHex);
+        obj["level"] = levelName(record.level);
+        obj["cause"] = causeName(record.cause);
+        obj["value"] = record.value;
+        obj["threshold"] = record.threshold;
+        if (record.cause == static_cast<uint8_t>(AlarmCause::RULE)) {
+            obj["rule"] = record.rule;
+        }
+    }
+    // Страница заполнена - следующую запрашивают с after = next
+    if (count == limit) {
+        root["next"] = records[count - 1].seq;
+    }
+
+    const AlarmJournalStats stats = journal.getStats();
+    root["count"] = stats.count;
+    root["capacity"] = stats.capacity;
+    root["written"] = stats.written;
+    root["dropped"] = stats.dropped;
+    root["flushes"] = stats.flushes;
+    root["last_flush_us"] = stats.lastFlushUs;
+    return response.send();
+}
+
+esp_err_t AlarmHandler::getDispatchStats(PsychicRequest* request)
+{
+    auto response = PsychicJsonResponse(request, false);
+    const JsonObject root = response.getRoot();
+
+    const AlarmDispatchStats stats = AlarmMonitor::getInstance().getDispatchStats();
+    root["queue_depth"] = stats.depth;
+    root["queue_max_depth"] = stats.maxDepth;
+    root["queue_capacity"] = static_cast<uint32_t>(AlarmMonitor::DISPATCH_QUEUE_LENGTH);
+    root["queued"] = stats.queued;
+    root["delivered"] = stats.delivered;
+    root["dropped"] = stats.dropped;
+    root["last_latency_us"] = stats.lastLatencyUs;
+    root["max_latency_us"] = stats.maxLatencyUs;
+    return response.send();
+}
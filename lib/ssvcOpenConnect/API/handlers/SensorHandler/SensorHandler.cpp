@@ -1,4 +1,5 @@
 #include "SensorHandler.h"
+#include <algorithm>
 
 /**
 *   SSVC Open Connect
@@ -20,6 +21,8 @@
 #include "DallasTemperature.h"
 #include "esp_log.h"
 #include "components/sensors/SensorManager/SensorManager.h"
+#include "components/sensors/SensorCoordinator/SensorCoordinator.h"
+#include "components/sensors/OneWireThermalSubsystem/OneWireThermalSubsystem.h"
 #include "core/SsvcOpenConnect.h"
 #include "core/StatefulServices/SensorConfigService/SensorConfigService.h"
 
@@ -45,11 +48,9 @@ esp_err_t SensorHandler::updateSensorZone(PsychicRequest* request)
     const char* address = request->getParam("address")->value().c_str();
     const std::string zoneName = request->getParam("zone")->value().c_str();
 
-    // 1. Создание переменной для 8-байтового адреса (не используется для вызова сервиса, но необходима для проверки формата)
-    AbstractSensor::Address addressBytes;
-
-    // 2. Преобразование строкового адреса в массив байт
-    if (!SensorManager::stringToAddress(address, addressBytes)) {
+    // Преобразование строкового адреса во внутренний идентификатор
+    SensorId sensorId;
+    if (!SensorManager::stringToId(address, sensorId)) {
         // Обработка ошибки, если строка имеет неверный формат (например, не 16 hex-символов)
         root["status"] = "error";
         root["message"] = "Invalid 1-Wire address format. Must be 16 hex characters.";
@@ -78,7 +79,7 @@ esp_err_t SensorHandler::updateSensorZone(PsychicRequest* request)
     }
 
     // ВЫЗОВ СЕРВИСА: Используем корректное имя переменной 'address'
-    const bool success = service->setZoneForSensor(address, zone);
+    const bool success = service->setZoneForSensor(sensorId, zone);
 
     // Формирование ответа
     if (success) {
@@ -98,6 +99,242 @@ esp_err_t SensorHandler::updateSensorZone(PsychicRequest* request)
     return response.send();
 }
 
+esp_err_t SensorHandler::updateSensorResolution(PsychicRequest* request)
+{
+    auto response = PsychicJsonResponse(request, true);
+    const JsonObject root = response.getRoot();
+
+    if (!request->hasParam("address") || !request->hasParam("resolution")) {
+        root["status"] = "error";
+        root["message"] = "Missing required parameters: 'address' and 'resolution'";
+        response.setCode(400);
+        return response.send();
+    }
+
+    const std::string address = request->getParam("address")->value().c_str();
+    const long resolution = request->getParam("resolution")->value().toInt();
+
+    SensorId sensorId;
+    if (!SensorManager::stringToId(address, sensorId)) {
+        root["status"] = "error";
+        root["message"] = "Invalid 1-Wire address format. Must be 16 hex characters.";
+        root["address"] = address;
+        response.setCode(400);
+        return response.send();
+    }
+
+    if (!DS18B20Sensor::isValidResolution(resolution)) {
+        root["status"] = "error";
+        root["message"] = "Invalid resolution value. Valid values: 9, 10, 11, 12";
+        root["received_resolution"] = resolution;
+        response.setCode(400);
+        return response.send();
+    }
+
+    SensorConfigService* service = SsvcOpenConnect::getInstance().getSensorConfigService();
+    if (!service) {
+        root["message"] = "Zone Service not initialized";
+        response.setCode(500);
+        return response.send();
+    }
+
+    root["address"] = address;
+    root["resolution"] = resolution;
+    if (service->setResolutionForSensor(sensorId, static_cast<uint8_t>(resolution))) {
+        root["status"] = "success";
+        root["message"] = "Resolution will be applied on the next poll cycle";
+        response.setCode(200);
+    } else {
+        root["status"] = "error";
+        root["message"] = "Sensor not found on the 1-Wire bus";
+        response.setCode(404);
+    }
+
+    return response.send();
+}
+
+esp_err_t SensorHandler::rescanBus(PsychicRequest* request)
+{
+    auto response = PsychicJsonResponse(request, false);
+    const JsonObject root = response.getRoot();
+
+    OneWireThermalSubsystem::requestRescanAll();
+
+    // Поиск выполняется задачами шин асинхронно, результат придет событием onewire_bus по каждой шине
+    root["status"] = "accepted";
+    size_t active = 0;
+    size_t retired = 0;
+    const auto buses = root["buses"].to<JsonArray>();
+    for (const OneWireThermalSubsystem* bus : OneWireThermalSubsystem::getBuses()) {
+        const size_t busActive = bus->getActiveSensorCount();
+        const size_t busRetired = bus->getRetiredSensorCount();
+        const auto item = buses.add<JsonObject>();
+        item["pin"] = bus->getPin();
+        item["active"] = busActive;
+        item["retired"] = busRetired;
+        active += busActive;
+        retired += busRetired;
+    }
+    root["active"] = active;
+    root["retired"] = retired;
+    response.setCode(202);
+    return response.send();
+}
+
+esp_err_t SensorHandler::getSensorTrends(PsychicRequest* request)
+{
+    auto response = PsychicJsonResponse(request, false);
+    const JsonObject root = response.getRoot();
+    const SensorManager& manager = SensorManager::getInstance();
+
+    // Один датчик: статистика и точки истории
+    if (request->hasParam("address")) {
+        const std::string address = request->getParam("address")->value().c_str();
+        SensorId sensorId;
+        const AbstractSensor* sensor = SensorManager::stringToId(address, sensorId)
+            ? manager.getSensorById(sensorId)
+            : nullptr;
+        if (!sensor) {
+            root["status"] = "error";
+            root["message"] = "Sensor not found";
+            root["address"] = address;
+            response.setCode(404);
+            return response.send();
+        }
+
+        root["address"] = address;
+        writeTrend(root["trend"].to<JsonObject>(), sensor->getHistory().getTrend());
+
+        SensorSample samples[SensorHistory::CAPACITY];
+        const size_t count = sensor->getHistory().copySamples(samples, SensorHistory::CAPACITY);
+        const uint32_t now = millis();
+        const auto samplesArray = root["samples"].to<JsonArray>();
+        for (size_t i = 0; i < count; i++) {
+            // Возраст точки в мс относительно момента ответа
+            const auto point = samplesArray.add<JsonArray>();
+            point.add(now - samples[i].timestampMs);
+            point.add(samples[i].value);
+        }
+        return response.send();
+    }
+
+    // Все датчики: только статистика
+    const auto sensors = root["sensors"].to<JsonObject>();
+    const SensorList registered = manager.getAllSensors();
+    for (const AbstractSensor* sensor : *registered) {
+        writeTrend(sensors[sensor->getIdHex()].to<JsonObject>(), sensor->getHistory().getTrend());
+    }
+    return response.send();
+}
+
+void SensorHandler::writeTrend(const JsonObject& obj, const SensorTrend& trend)
+{
+    obj["count"] = trend.count;
+    obj["window_ms"] = trend.windowMs;
+    if (trend.count == 0) {
+        return;
+    }
+    obj["last"] = trend.last;
+    obj["ema"] = trend.ema;
+    obj["min"] = trend.min;
+    obj["max"] = trend.max;
+    obj["slope_per_min"] = trend.slopePerMin;
+}
+
+esp_err_t SensorHandler::getPollTiming(PsychicRequest* request)
+{
+    auto response = PsychicJsonResponse(request, false);
+    const JsonObject root = response.getRoot();
+
+    const SensorCoordinator& coordinator = SensorCoordinator::getInstance();
+    const PollCycleTiming timing = coordinator.getLastCycleTiming();
+
+    root["cycle"] = timing.cycle;
+    root["tick_ms"] = coordinator.getTickMs();
+    root["skipped_ticks"] = coordinator.getSkippedTicks();
+    root["cycle_subsystems"] = timing.subsystems;
+    root["valid_sensors"] = timing.validSensors;
+    root["invalid_sensors"] = timing.invalidSensors;
+
+    const auto stages = root["stages_us"].to<JsonObject>();
+    stages["acquire"] = timing.acquireUs;
+    stages["validate"] = timing.validateUs;
+    stages["publish"] = timing.publishUs;
+    stages["alarms"] = timing.alarmsUs;
+    stages["total"] = timing.totalUs;
+
+    // Шины преобразуют параллельно: сбор длится столько, сколько самая медленная из них
+    uint32_t conversionMs = 0;
+    const auto buses = root["buses"].to<JsonArray>();
+    for (const OneWireThermalSubsystem* bus : OneWireThermalSubsystem::getBuses()) {
+        const auto item = buses.add<JsonObject>();
+        item["pin"] = bus->getPin();
+        item["conversion_ms"] = bus->getConversionTimeMs();
+        item["bus_ms"] = bus->getLastBusTimeMs();
+        item["active"] = bus->getActiveSensorCount();
+        conversionMs = std::max(conversionMs, bus->getConversionTimeMs());
+    }
+    root["conversion_ms"] = conversionMs;
+
+    // Планировщик: период, срок, джиттер запуска и перерасходы по каждой подсистеме
+    const auto subsystems = root["subsystems"].to<JsonArray>();
+    for (const SubsystemScheduleStats& stats : coordinator.getScheduleStats()) {
+        const auto item = subsystems.add<JsonObject>();
+        item["name"] = stats.name;
+        item["period_ms"] = stats.periodMs;
+        item["deadline_ms"] = stats.deadlineMs;
+        item["dispatches"] = stats.dispatches;
+        item["overruns"] = stats.overruns;
+        item["deadline_misses"] = stats.deadlineMisses;
+        item["jitter_us"] = stats.lastJitterUs;
+        item["max_jitter_us"] = stats.maxJitterUs;
+        item["acquire_us"] = stats.lastAcquireUs;
+        item["max_acquire_us"] = stats.maxAcquireUs;
+    }
+
+    return response.send();
+}
+
+esp_err_t SensorHandler::getBusHealth(PsychicRequest* request)
+{
+    auto response = PsychicJsonResponse(request, false);
+    const JsonObject root = response.getRoot();
+
+    const auto buses = root["buses"].to<JsonArray>();
+    for (const OneWireThermalSubsystem* bus : OneWireThermalSubsystem::getBuses()) {
+        const OneWireBusStats busStats = bus->getBusStats();
+        const auto item = buses.add<JsonObject>();
+        item["pin"] = bus->getPin();
+        item["cycles"] = busStats.cycles;
+        item["conversion_ms"] = bus->getConversionTimeMs();
+        item["request_ms"] = busStats.lastRequestMs;
+        item["read_ms"] = busStats.lastReadMs;
+        item["max_bus_ms"] = busStats.maxBusMs;
+        item["failed_reads"] = busStats.lastFailedReads;
+
+        const auto sensors = item["sensors"].to<JsonArray>();
+        bus->readSensors([&sensors](const DS18B20Sensor* sensor) {
+            const DS18B20ReadStats stats = sensor->getReadStats();
+            const auto entry = sensors.add<JsonObject>();
+            entry["address"] = sensor->getIdHex();
+            entry["present"] = sensor->isPresent();
+            entry["reads"] = stats.reads;
+            entry["failed_reads"] = stats.failedReads;
+            entry["crc_errors"] = stats.crcErrors;
+            entry["retries"] = stats.retries;
+            entry["disconnects"] = stats.disconnects;
+            entry["power_on_resets"] = stats.powerOnResets;
+            entry["spikes_rejected"] = stats.spikesRejected;
+            entry["consecutive_failures"] = stats.consecutiveFailures;
+            // Доля циклов без валидного показания
+            const uint32_t attempts = stats.reads + stats.failedReads;
+            entry["error_rate"] = attempts > 0 ? static_cast<float>(stats.failedReads) / attempts : 0.0f;
+        });
+    }
+
+    return response.send();
+}
+
 void SensorHandler::parseQueryParams(const String& query,
                                    std::vector<std::pair<String, String>>& output) {
     unsigned int start = 0;
@@ -6,6 +6,8 @@
 #define SENSOR_HANDLER_H
 
 #include "PsychicHttp.h"
+#include "ArduinoJson.h"
+#include "components/sensors/SensorHistory/SensorHistory.h"
 
 #include <vector>
 #include <utility>
@@ -16,8 +18,14 @@ public:
 
     static esp_err_t getSensorAddresses(PsychicRequest* request);
     static esp_err_t updateSensorZone(PsychicRequest* request);
+    static esp_err_t updateSensorResolution(PsychicRequest* request);
+    static esp_err_t rescanBus(PsychicRequest* request);
+    static esp_err_t getSensorTrends(PsychicRequest* request);
+    static esp_err_t getPollTiming(PsychicRequest* request);
+    static esp_err_t getBusHealth(PsychicRequest* request);
 
 private:
+    static void writeTrend(const JsonObject& obj, const SensorTrend& trend);
     static void parseQueryParams(const String& query,
                                std::vector<std::pair<String, String>>& output);
 
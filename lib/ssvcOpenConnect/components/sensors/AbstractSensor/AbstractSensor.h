@@ -17,9 +17,13 @@
  *   Disclaimer: Use at your own risk. High voltage safety precautions required.
  **/
 
+#include <cmath>
 #include <cstring>
 #include <string>
 #include "components/Zone/SensorZone.h"
+#include "components/sensors/SensorFilter/SensorFilter.h"
+#include "components/sensors/SensorHistory/SensorHistory.h"
+#include "components/sensors/SensorId/SensorId.h"
 
 enum class MeasuredValueType {
     GENERIC = 0,
@@ -47,6 +51,9 @@ public:
         _isInitialized(false)
     {
         memcpy(this->address, addr, 8);
+        // Идентификатор и его hex-форма вычисляются один раз
+        id = sensorIdFromAddress(this->address);
+        sensorIdToHex(id, idHex);
     }
 
     virtual ~AbstractSensor() = default;
@@ -57,23 +64,93 @@ public:
     virtual bool isDataValid() const { return _dataValid; }
     virtual bool isInitialized() const { return _isInitialized; }
 
+    // Датчик физически присутствует на шине. Отсутствующий датчик остается
+    // зарегистрированным (на него могут ссылаться другие модули), но не опрашивается.
+    bool isPresent() const { return _present; }
+    void setPresent(const bool present) {
+        _present = present;
+        if (!present) {
+            _dataValid = false;
+            _dirty = true;
+            // После возврата тренд и фильтр считаются заново, без разрыва во времени
+            history.clear();
+            filter.reset();
+        }
+    }
+
     // Геттеры
     const Address& getAddress() const { return address; }
+    SensorId getId() const { return id; }
+    // Адрес в виде 16 hex-символов (для JSON и логов)
+    const char* getIdHex() const { return idHex; }
     const std::string& getName() const { return name; }
     SensorZone getZone() const { return currentZone; }
+    // История валидных показаний со статистикой тренда
+    const SensorHistory& getHistory() const { return history; }
 
     // Сеттер для зоны
-    void setZone(const SensorZone newZone) { currentZone = newZone; }
+    void setZone(const SensorZone newZone) {
+        if (newZone != currentZone) {
+            currentZone = newZone;
+            _dirty = true;
+        }
+    }
     void setName(const std::string& newName) { this->name = newName; }
 
     virtual MeasuredValueType getMeasurementType() const = 0;
 
+    // --- Отслеживание изменений для публикации ---
+
+    // Изменение значения относительно опубликованного, ниже которого показание не публикуется заново
+    static constexpr float PUBLISH_DEADBAND = 0.01f;
+
+    // Значение (сверх зоны нечувствительности), валидность или зона изменились с последней публикации
+    bool isDirty() const { return _dirty; }
+    // Опубликованное состояние: по нему публикатор находит прежнюю запись
+    bool isPublishedValid() const { return _publishedValid; }
+    SensorZone getPublishedZone() const { return _publishedZone; }
+
+    /**
+     * @brief Фиксирует опубликованное состояние и снимает флаг изменения.
+     * Вызывается публикатором (SensorDataService).
+     */
+    void markPublished(const float value, const bool valid) {
+        _publishedValue = value;
+        _publishedValid = valid;
+        _publishedZone = currentZone;
+        _dirty = false;
+    }
+
 protected:
+    /**
+     * @brief Вызывается наследником после каждого чтения (стадия сбора).
+     * Сравнение идет с опубликованным значением, поэтому медленный дрейф накапливается
+     * и публикуется, как только превысит зону нечувствительности.
+     */
+    void updateDirty() {
+        if (_dataValid != _publishedValid ||
+            (_dataValid && std::fabs(getData() - _publishedValue) > PUBLISH_DEADBAND)) {
+            _dirty = true;
+        }
+    }
+
     Address address{};
+    SensorId id = INVALID_SENSOR_ID;
+    char idHex[SENSOR_ID_HEX_LENGTH + 1] = {};
     std::string name;
     SensorZone currentZone;
     bool _dataValid;
     bool _isInitialized;
+    bool _present = true;
+    // Состояние последней публикации. Новый датчик помечен измененным до первой публикации
+    volatile bool _dirty = true;
+    float _publishedValue = 0.0f;
+    bool _publishedValid = false;
+    SensorZone _publishedZone = SensorZone::UNKNOWN;
+    // Наследник добавляет сюда каждое валидное показание
+    SensorHistory history;
+    // Наследник пропускает через него каждое валидное сырое показание (настройки - по зоне)
+    SensorFilter filter;
 };
 
 
@@ -24,6 +24,26 @@
 // Тег для логирования в этом файле
 static const char *TAG = "DS18B20_SENSOR";
 
+namespace {
+    // Раскладка scratchpad
+    constexpr uint8_t SCRATCHPAD_SIZE = 9;
+    constexpr uint8_t SP_TEMP_LSB = 0;
+    constexpr uint8_t SP_TEMP_MSB = 1;
+    constexpr uint8_t SP_COUNT_REMAIN = 6;
+    constexpr uint8_t SP_COUNT_PER_C = 7;
+    constexpr uint8_t SP_CRC = 8;
+
+    // Семейство DS18S20: 9-битный результат с расширением через COUNT_REMAIN
+    constexpr uint8_t FAMILY_DS18S20 = 0x10;
+
+    // Значение регистра температуры после сброса питания: 85 °C (0x0550)
+    constexpr uint8_t POWER_ON_TEMP_LSB = 0x50;
+    constexpr uint8_t POWER_ON_TEMP_MSB = 0x05;
+    constexpr float POWER_ON_TEMP_C = 85.0f;
+    // Если прошлое показание ближе, 85 °C считается реальной температурой
+    constexpr float POWER_ON_TOLERANCE_C = 1.0f;
+}
+
 DS18B20Sensor::DS18B20Sensor(
     const Address addr,
     const std::string& name,
@@ -33,37 +53,160 @@ DS18B20Sensor::DS18B20Sensor(
     // Обязательный вызов конструктора родителя
     : AbstractSensor(addr, name, zone),
       dallasSensors(sensors),
-      lastReading(DEVICE_DISCONNECTED_C)
+      lastReading(DEVICE_DISCONNECTED_C),
+      resolution(MAX_RESOLUTION)
 {
 
-    const std::string addressStr = SensorManager::addressToString(reinterpret_cast<const AbstractSensor::Address&>(addr));
-    
-    ESP_LOGV(TAG, "New DS18B20 Sensor created. Name: %s, Address: %s, Zone: %d.", 
-             getName().c_str(), addressStr.c_str(), static_cast<int>(zone));
+    // Разрешение, записанное в датчике (0 - датчик не ответил)
+    const uint8_t deviceResolution = dallasSensors->getResolution(address);
+    if (isValidResolution(deviceResolution)) {
+        resolution = deviceResolution;
+    }
+
+    ESP_LOGV(TAG, "New DS18B20 Sensor created. Name: %s, Address: %s, Zone: %d, Resolution: %u bit.",
+             getName().c_str(), getIdHex(), static_cast<int>(zone), resolution);
+}
+
+bool DS18B20Sensor::requestResolution(const uint8_t bits) {
+    if (!isValidResolution(bits)) {
+        ESP_LOGW(TAG, "Sensor %s: invalid resolution %u bit requested.", getName().c_str(), bits);
+        return false;
+    }
+    requestedResolution = bits;
+    return true;
+}
+
+bool DS18B20Sensor::applyPendingResolution() {
+    const uint8_t bits = requestedResolution;
+    if (bits == 0) {
+        return false;
+    }
+    requestedResolution = 0;
+    if (bits == resolution) {
+        return false;
+    }
+
+    // Глобальное разрешение библиотеки не пересчитываем: время ожидания считается по датчикам
+    if (!dallasSensors->setResolution(address, bits, true)) {
+        ESP_LOGW(TAG, "Sensor %s: failed to set resolution %u bit.", getName().c_str(), bits);
+        return false;
+    }
+    ESP_LOGI(TAG, "Sensor %s: resolution changed %u -> %u bit.", getName().c_str(), resolution, bits);
+    resolution = bits;
+    return true;
+}
+
+uint16_t DS18B20Sensor::getConversionTimeMs() const {
+    return dallasSensors->millisToWaitForConversion(resolution);
 }
 
 /**
  * @brief Запускает считывание температуры и сохраняет результат.
+ * Ошибка CRC повторяется чтением того же scratchpad (преобразование не повторяется).
  */
 void DS18B20Sensor::readValue() {
-    // Получаем значение для конкретного адреса.
-    const std::string addressStr = SensorManager::addressToString(address);
-    
-    // Считывание из кэша DallasTemperature
-    lastReading = dallasSensors->getTempC(address);
-    
-    if (lastReading == DEVICE_DISCONNECTED_C) {
-        ESP_LOGV(TAG, "Sensor %s (%s) read failed. Value: %.2f.",
-                 getName().c_str(), addressStr.c_str(), lastReading);
-        this->_dataValid = false;
-    } else {
-        ESP_LOGV(TAG, "Sensor %s (%s) updated. New temperature: %.2f C.",
-                 getName().c_str(), addressStr.c_str(), lastReading);
+    float value = DEVICE_DISCONNECTED_C;
+    ReadResult result = readScratchPad(value);
+    for (uint8_t attempt = 0; result == ReadResult::CRC_ERROR && attempt < MAX_CRC_RETRIES; attempt++) {
+        readStats.crcErrors++;
+        readStats.retries++;
+        result = readScratchPad(value);
+    }
+
+    switch (result) {
+    case ReadResult::OK: {
+        readStats.reads++;
+        readStats.consecutiveFailures = 0;
+        // Фильтр зоны: потребители видят сглаженное значение, одиночный выброс не публикуется
+        bool rejected = false;
+        lastReading = filter.apply(currentZone, value, rejected);
+        if (rejected) {
+            readStats.spikesRejected++;
+        }
+        ESP_LOGV(TAG, "Sensor %s (%s) updated. Raw %.2f C, filtered %.2f C%s.",
+                 getName().c_str(), getIdHex(), value, lastReading, rejected ? " (spike rejected)" : "");
         this->_dataValid = true;
+        history.addSample(millis(), lastReading);
+        break;
     }
+    case ReadResult::CRC_ERROR:
+        readStats.crcErrors++;
+        readStats.consecutiveFailures++;
+        ESP_LOGW(TAG, "Sensor %s (%s): CRC error persisted after %u retries.",
+                 getName().c_str(), getIdHex(), MAX_CRC_RETRIES);
+        break;
+    case ReadResult::POWER_ON_RESET:
+        // Датчик перезапустился (просадка питания) и не выполнил преобразование
+        readStats.powerOnResets++;
+        readStats.consecutiveFailures++;
+        ESP_LOGW(TAG, "Sensor %s (%s) returned power-on value 85 C. Reading discarded.",
+                 getName().c_str(), getIdHex());
+        break;
+    case ReadResult::DISCONNECTED:
+        readStats.disconnects++;
+        readStats.consecutiveFailures++;
+        ESP_LOGV(TAG, "Sensor %s (%s) read failed: no response.", getName().c_str(), getIdHex());
+        break;
+    }
+
+    if (result != ReadResult::OK) {
+        readStats.failedReads++;
+        lastReading = DEVICE_DISCONNECTED_C;
+        this->_dataValid = false;
+    }
+    updateDirty();
     this->_isInitialized = true;
 }
 
+DS18B20Sensor::ReadResult DS18B20Sensor::readScratchPad(float& value) const {
+    uint8_t scratchPad[SCRATCHPAD_SIZE];
+    // false - датчик не ответил импульсом присутствия
+    if (!dallasSensors->readScratchPad(address, scratchPad)) {
+        return ReadResult::DISCONNECTED;
+    }
+
+    // Все нули или все единицы - обрыв или замыкание линии данных, а не помеха
+    bool allZeros = true;
+    bool allOnes = true;
+    for (const uint8_t byte : scratchPad) {
+        allZeros = allZeros && byte == 0x00;
+        allOnes = allOnes && byte == 0xFF;
+    }
+    if (allZeros || allOnes) {
+        return ReadResult::DISCONNECTED;
+    }
+    if (OneWire::crc8(scratchPad, SP_CRC) != scratchPad[SP_CRC]) {
+        return ReadResult::CRC_ERROR;
+    }
+
+    // 85 °C - значение после сброса питания. Реальную температуру около 85 °C
+    // не отбрасываем, если предыдущее показание было рядом
+    if (scratchPad[SP_TEMP_LSB] == POWER_ON_TEMP_LSB && scratchPad[SP_TEMP_MSB] == POWER_ON_TEMP_MSB) {
+        const bool nearPrevious = _dataValid && std::fabs(lastReading - POWER_ON_TEMP_C) <= POWER_ON_TOLERANCE_C;
+        if (!nearPrevious) {
+            return ReadResult::POWER_ON_RESET;
+        }
+    }
+
+    value = scratchPadToCelsius(scratchPad);
+    return ReadResult::OK;
+}
+
+float DS18B20Sensor::scratchPadToCelsius(const uint8_t* scratchPad) const {
+    int16_t raw = static_cast<int16_t>((scratchPad[SP_TEMP_MSB] << 8) | scratchPad[SP_TEMP_LSB]);
+
+    if (address[0] == FAMILY_DS18S20) {
+        // Шаг 0.5 °C, уточнение по остатку счетчика
+        const uint8_t countPerC = scratchPad[SP_COUNT_PER_C] != 0 ? scratchPad[SP_COUNT_PER_C] : 16;
+        return static_cast<float>(raw >> 1) - 0.25f +
+               static_cast<float>(countPerC - scratchPad[SP_COUNT_REMAIN]) / countPerC;
+    }
+
+    // Младшие биты не определены при разрешении ниже 12 бит
+    raw &= static_cast<int16_t>(~((1 << (MAX_RESOLUTION - resolution)) - 1));
+    return static_cast<float>(raw) / 16.0f;
+}
+
 /**
   * @brief Возвращает последнее считанное значение температуры.
   */
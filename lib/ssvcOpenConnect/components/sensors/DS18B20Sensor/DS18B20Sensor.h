@@ -23,6 +23,20 @@
 #include "components/Zone/SensorZone.h"
 
 
+/**
+ * @brief Счетчики чтений датчика (с момента обнаружения).
+ */
+struct DS18B20ReadStats {
+    uint32_t reads = 0;               // Успешные чтения
+    uint32_t failedReads = 0;         // Циклы без валидного показания (по любой причине)
+    uint32_t crcErrors = 0;           // Чтения scratchpad с неверной CRC (включая повторы)
+    uint32_t retries = 0;             // Повторные чтения после ошибки CRC
+    uint32_t disconnects = 0;         // Нет ответа датчика (нет импульса присутствия, линия 0x00/0xFF)
+    uint32_t powerOnResets = 0;       // Значение 85 °C после сброса питания вместо результата
+    uint32_t spikesRejected = 0;      // Показания, отброшенные фильтром зоны как скачок
+    uint32_t consecutiveFailures = 0; // Неудачных циклов подряд
+};
+
 /**
  * @brief Конкретный класс для управления датчиком DS18B20.
  */
@@ -46,10 +60,66 @@ public:
     float getData() const override;
     MeasuredValueType getMeasurementType() const override;
 
+    // Допустимый диапазон разрешения DS18B20 (бит)
+    static constexpr uint8_t MIN_RESOLUTION = 9;
+    static constexpr uint8_t MAX_RESOLUTION = 12;
+
+    static bool isValidResolution(const long bits) {
+        return bits >= MIN_RESOLUTION && bits <= MAX_RESOLUTION;
+    }
+
+    /**
+     * @brief Текущее разрешение датчика (бит).
+     */
+    uint8_t getResolution() const { return resolution; }
+
+    /**
+     * @brief Запрашивает смену разрешения. Запись на шину выполняется позже,
+     * в задаче шины, через applyPendingResolution().
+     * @return false, если разрешение вне диапазона 9..12 бит.
+     */
+    bool requestResolution(uint8_t bits);
+
+    /**
+     * @brief Записывает запрошенное разрешение в датчик. Вызывается только владельцем шины.
+     * @return true, если разрешение было изменено.
+     */
+    bool applyPendingResolution();
+
+    /**
+     * @brief Время преобразования для текущего разрешения (мс).
+     */
+    uint16_t getConversionTimeMs() const;
+
+    // Повторных чтений scratchpad при ошибке CRC в пределах одного цикла (без нового преобразования)
+    static constexpr uint8_t MAX_CRC_RETRIES = 2;
+
+    DS18B20ReadStats getReadStats() const { return readStats; }
+
 private:
     DallasTemperature* dallasSensors;
     float lastReading;
 
+    // Результат одного чтения scratchpad
+    enum class ReadResult : uint8_t {
+        OK,
+        CRC_ERROR,
+        DISCONNECTED,
+        POWER_ON_RESET,
+    };
+
+    // Читает scratchpad, проверяет CRC и пересчитывает температуру в value
+    ReadResult readScratchPad(float& value) const;
+
+    // Температура из scratchpad (с учетом разрешения и семейства датчика)
+    float scratchPadToCelsius(const uint8_t* scratchPad) const;
+
+    DS18B20ReadStats readStats;
+
+    uint8_t resolution;
+    // 0 - нет отложенного запроса на смену разрешения
+    volatile uint8_t requestedResolution = 0;
+
 };
 
 
@@ -17,138 +17,451 @@
  *   Disclaimer: Use at your own risk. High voltage safety precautions required.
  **/
 
+#include <algorithm>
 #include "components/sensors/SensorManager/SensorManager.h"
 #include "core/SsvcOpenConnect.h"
 
-OneWireThermalSubsystem& OneWireThermalSubsystem::getInstance() {
-    static OneWireThermalSubsystem instance;
-    return instance;
+std::vector<OneWireThermalSubsystem*> OneWireThermalSubsystem::_buses;
+std::atomic<int> OneWireThermalSubsystem::_nextSensorIndex{1};
+
+OneWireThermalSubsystem::OneWireThermalSubsystem(const uint8_t pin)
+    : PollingSubsystem(), _pin(pin) {
+    snprintf(_name, sizeof(_name), "OW_THERMAL_GPIO%u", _pin);
+}
+
+const std::vector<OneWireThermalSubsystem*>& OneWireThermalSubsystem::createBuses() {
+    if (!_buses.empty()) {
+        return _buses;
+    }
+    static constexpr uint8_t pins[] = {ONEWIRE_BUS_PINS};
+    for (const uint8_t pin : pins) {
+        const bool duplicate = std::any_of(_buses.begin(), _buses.end(),
+            [pin](const OneWireThermalSubsystem* bus) { return bus->getPin() == pin; });
+        if (duplicate) {
+            ESP_LOGW(TAG, "GPIO %u is listed twice in ONEWIRE_BUS_PINS. Ignoring duplicate.", pin);
+            continue;
+        }
+        _buses.push_back(new OneWireThermalSubsystem(pin));
+    }
+    ESP_LOGI(TAG, "Created %zu 1-Wire bus(es).", _buses.size());
+    return _buses;
 }
 
 bool OneWireThermalSubsystem::initialize() {
-    ESP_LOGV(TAG, "Initializing OneWire Thermal Subsystem on pin %d.", ONEWIRE_PIN);
+    ESP_LOGV(TAG, "Initializing OneWire Thermal Subsystem on pin %u.", _pin);
+
+    if (!_sensorsMutex) {
+        _sensorsMutex = xSemaphoreCreateMutex();
+    }
 
     // 1. Инициализация аппаратных ресурсов
-    oneWireBus = new OneWire(ONEWIRE_PIN);
+    oneWireBus = new OneWire(_pin);
     dallasTemp = new DallasTemperature(oneWireBus);
     
     // Начало работы DallasTemperature
     dallasTemp->begin();
+    // Преобразование ждем не внутри библиотеки, а в своей задаче через vTaskDelay
+    dallasTemp->setWaitForConversion(false);
     ESP_LOGV(TAG, "DallasTemperature started successfully.");
 
-    // 2. Поиск и регистрация датчиков
+    // 2. Поиск и регистрация датчиков (сохраненные зоны и разрешения применяются в addSensor)
     discoverAndRegisterSensors();
 
-    const auto* ssvcConnect = &SsvcOpenConnect::getInstance();
-
-    if (auto* zoneService = ssvcConnect->getSensorConfigService()) {
-
-        zoneService->read([&](const SensorConfigState& state) {
-            ESP_LOGV(TAG, "[ZONE_CONFIG] Loaded zones in memory: %zu entries.", state.sensor_zones.size());
-            for (const auto& pair : state.sensor_zones) {
-                ESP_LOGV(TAG, "[ZONE_CONFIG] Address: %s, Zone: %d",
-                         pair.first.c_str(), static_cast<int>(pair.second));
-            }
-
-            // Вызываем метод applyZonesToSensors
-            state.applyZonesToSensors();
-        });
+    if (auto* socket = SsvcOpenConnect::getInstance().getESP32SvelteKit()->getSocket()) {
+        socket->registerEvent(ONEWIRE_BUS_EVENT);
+    }
 
-        ESP_LOGV(TAG, "Applied saved SensorZone configurations to %zu sensors after discovery.", SensorManager::getInstance().getRegisteredSensorCount());
-    } else {
-        ESP_LOGE(TAG, "Cannot apply SensorZone configuration: SensorZoneService not initialized/accessible.");
+    // 3. Задача, обслуживающая шину вне демона таймеров
+    if (!_taskHandle) {
+        char taskName[configMAX_TASK_NAME_LEN];
+        snprintf(taskName, sizeof(taskName), "%s%u", DEFAULT_TASK_NAME, _pin);
+        xTaskCreatePinnedToCore(
+            busTask,
+            taskName,
+            TASK_STACK_SIZE,
+            this,
+            TASK_PRIORITY,
+            &_taskHandle,
+            1
+        );
+        if (!_taskHandle) {
+            ESP_LOGE(TAG, "Failed to create %s task!", taskName);
+            return false;
+        }
     }
-    
+
     return true;
 }
 
 const char* OneWireThermalSubsystem::getName() const {
-    return "OW_THERMAL_SUBSYS";
+    return _name;
 }
 
 void OneWireThermalSubsystem::discoverAndRegisterSensors(){
-    // 1. Поиск
-    const int deviceCount = dallasTemp->getDeviceCount();
-    ESP_LOGV(TAG, "Starting sensor discovery. Found %d DS18B20 devices on bus.", deviceCount);
+    ESP_LOGV(TAG, "Starting sensor discovery. DallasTemperature reports %d devices on bus.", dallasTemp->getDeviceCount());
+
+    // Первичное обнаружение - тот же инкрементальный поиск относительно пустого списка
+    rescanBus(false);
 
+    ESP_LOGV(TAG, "Sensor discovery on GPIO %u finished. %zu DS18B20 sensors registered.", _pin, ds18b20Sensors.size());
+}
+
+void OneWireThermalSubsystem::searchBus(std::vector<SensorId>& found) const {
     AbstractSensor::Address addr;
-    SensorManager& manager = SensorManager::getInstance();
+    oneWireBus->reset_search();
+    while (oneWireBus->search(addr)) {
+        if (OneWire::crc8(addr, 7) != addr[7]) {
+            ESP_LOGW(TAG, "Search returned address with invalid CRC: %s.", SensorManager::addressToString(addr).c_str());
+            continue;
+        }
+        if (!dallasTemp->validFamily(addr)) {
+            continue;
+        }
+        const SensorId id = sensorIdFromAddress(addr);
+        if (std::find(found.begin(), found.end(), id) == found.end()) {
+            found.push_back(id);
+        }
+    }
+}
 
-    // Очищаем внутренний список перед новым обнаружением (для переинициализации)
-    ds18b20Sensors.clear();
+DS18B20Sensor* OneWireThermalSubsystem::addSensor(const AbstractSensor::Address& addr) {
+    // 1. Полная hex-строка адреса
+    const SensorId id = sensorIdFromAddress(addr);
+    char fullAddressHex[SENSOR_ID_HEX_LENGTH + 1];
+    sensorIdToHex(id, fullAddressHex);
 
-    for (int i = 0; i < deviceCount; i++) {
-        if (dallasTemp->getAddress(addr, i)) {
+    // Один и тот же датчик не может обслуживаться двумя шинами
+    if (SensorManager::getInstance().isSensorRegistered(id)) {
+        ESP_LOGW(TAG, "Sensor %s on GPIO %u is already registered by another bus. Ignoring.", fullAddressHex, _pin);
+        return nullptr;
+    }
+
+    // 2. Имя из последних 4 символов адреса (16 hex-символов -> startPos = 12)
+    char nameBuffer[20];
+    sprintf(nameBuffer, "DS_%s_%d", fullAddressHex + SENSOR_ID_HEX_LENGTH - 4, _nextSensorIndex++);
 
-            // 1. Получаем полную строку адреса
-            const std::string fullAddressStr = SensorManager::addressToString(addr);
+    ESP_LOGV(TAG, "Device found on GPIO %u: %s (%s).", _pin, nameBuffer, fullAddressHex);
 
-            // 2. Вычисляем начальную позицию (длина строки - 4)
-            // 1-Wire адрес состоит из 16 символов (8 байт в шестнадцатеричной форме),
-            // поэтому startPos = 16 - 4 = 12.
-            const size_t startPos = fullAddressStr.length() > 4 ? fullAddressStr.length() - 4 : 0;
+    // 3. Создание и регистрация
+    auto newSensor = new DS18B20Sensor(
+        addr,
+        nameBuffer,
+        dallasTemp,
+        SensorZone::UNKNOWN
+    );
 
-            // 3. Извлекаем последние 4 символа
-            const std::string lastFourDigits = fullAddressStr.substr(startPos);
+    // Сохраненные настройки датчика (при первичном обнаружении и при hot-plug)
+    if (auto* configService = SsvcOpenConnect::getInstance().getSensorConfigService()) {
+        configService->read([&](const SensorConfigState& state) {
+            const auto zoneIt = state.sensor_zones.find(id);
+            if (zoneIt != state.sensor_zones.end()) {
+                newSensor->setZone(zoneIt->second);
+            }
+            const auto resolutionIt = state.sensor_resolutions.find(id);
+            if (resolutionIt != state.sensor_resolutions.end()) {
+                newSensor->requestResolution(resolutionIt->second);
+            }
+        });
+    } else {
+        ESP_LOGE(TAG, "Cannot apply saved configuration to %s: SensorConfigService not initialized.", nameBuffer);
+    }
+
+    // Регистрируем в абстрактном SensorManager (при отказе он уже удалил объект)
+    return SensorManager::getInstance().registerSensor(newSensor) ? newSensor : nullptr;
+}
+
+void OneWireThermalSubsystem::rescanBus(const bool emitEvent) {
+    if (!oneWireBus || !dallasTemp) {
+        return;
+    }
+    _phase = ConversionPhase::SCANNING;
+    _cyclesSinceRescan = 0;
+
+    const auto findById = [](const std::vector<DS18B20Sensor*>& list, const SensorId id) {
+        return std::find_if(list.begin(), list.end(), [id](const DS18B20Sensor* sensor) {
+            return sensor->getId() == id;
+        });
+    };
+    const auto isFound = [](const std::vector<SensorId>& found, const SensorId id) {
+        return std::find(found.begin(), found.end(), id) != found.end();
+    };
 
-            char nameBuffer[20];
-            sprintf(nameBuffer, "DS_%s_%d", lastFourDigits.c_str(), i + 1);
+    std::vector<SensorId> found;
+    searchBus(found);
 
-            ESP_LOGV(TAG, "Device found: %s at index %d.", nameBuffer, i);
+    // Пропажу подтверждаем повторным поиском: одиночный сбой поиска не должен выводить датчик из опроса
+    for (const DS18B20Sensor* sensor : ds18b20Sensors) {
+        if (!isFound(found, sensor->getId())) {
+            searchBus(found);
+            break;
+        }
+    }
 
-            // 2. Создание и регистрация
-            auto newSensor = new DS18B20Sensor(
-                addr,
-                nameBuffer,
-                dallasTemp,
-                SensorZone::UNKNOWN
-            );
+    std::vector<SensorId> added;
+    std::vector<SensorId> restored;
+    std::vector<SensorId> retired;
 
-            // Регистрируем в абстрактном SensorManager
-            manager.registerSensor(newSensor);
+    // 1. Пропавшие датчики выводим из опроса
+    std::vector<DS18B20Sensor*> missing;
+    for (DS18B20Sensor* sensor : ds18b20Sensors) {
+        if (!isFound(found, sensor->getId())) {
+            missing.push_back(sensor);
+            retired.push_back(sensor->getId());
+        }
+    }
 
-            // Сохраняем указатель в специфичном списке
-            ds18b20Sensors.push_back(newSensor);
-            
-            ESP_LOGV(TAG, "Sensor %s successfully registered and added to poll list.", nameBuffer);
-        } else {
-            ESP_LOGW(TAG, "Could not get address for device at index %d.", i);
+    // 2. Найденные адреса: возврат ранее пропавших или новые датчики
+    std::vector<DS18B20Sensor*> returning;
+    std::vector<DS18B20Sensor*> created;
+    for (const SensorId id : found) {
+        if (findById(ds18b20Sensors, id) != ds18b20Sensors.end()) {
+            continue; // Известный датчик, объект не трогаем
+        }
+        const auto retiredIt = findById(retiredSensors, id);
+        if (retiredIt != retiredSensors.end()) {
+            returning.push_back(*retiredIt);
+            restored.push_back(id);
+            continue;
+        }
+        AbstractSensor::Address addr;
+        sensorIdToAddress(id, addr);
+        if (DS18B20Sensor* sensor = addSensor(addr)) {
+            created.push_back(sensor);
+            added.push_back(id);
         }
     }
-    ESP_LOGV(TAG, "Sensor discovery finished. %zu DS18B20 sensors registered.", ds18b20Sensors.size());
+
+    if (missing.empty() && returning.empty() && created.empty()) {
+        _phase = ConversionPhase::IDLE;
+        ESP_LOGV(TAG, "Bus rescan on GPIO %u: no changes, %zu sensors active.", _pin, ds18b20Sensors.size());
+        return;
+    }
+
+    // 3. Применяем изменения списков (короткая блокировка, без обращений к шине)
+    xSemaphoreTake(_sensorsMutex, portMAX_DELAY);
+    for (DS18B20Sensor* sensor : missing) {
+        sensor->setPresent(false);
+        ds18b20Sensors.erase(std::find(ds18b20Sensors.begin(), ds18b20Sensors.end(), sensor));
+        retiredSensors.push_back(sensor);
+    }
+    for (DS18B20Sensor* sensor : returning) {
+        sensor->setPresent(true);
+        retiredSensors.erase(std::find(retiredSensors.begin(), retiredSensors.end(), sensor));
+        ds18b20Sensors.push_back(sensor);
+    }
+    ds18b20Sensors.insert(ds18b20Sensors.end(), created.begin(), created.end());
+    xSemaphoreGive(_sensorsMutex);
+
+    _phase = ConversionPhase::IDLE;
+    ESP_LOGI(TAG, "Bus rescan on GPIO %u: %zu added, %zu restored, %zu retired. %zu sensors active.",
+             _pin, added.size(), restored.size(), retired.size(), ds18b20Sensors.size());
+
+    if (!emitEvent) {
+        return;
+    }
+    EventSocket* socket = SsvcOpenConnect::getInstance().getESP32SvelteKit()->getSocket();
+    if (!socket) {
+        return;
+    }
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["pin"] = _pin;
+    const auto fill = [&root](const char* name, const std::vector<SensorId>& ids) {
+        const auto array = root[name].to<JsonArray>();
+        char hex[SENSOR_ID_HEX_LENGTH + 1];
+        for (const SensorId id : ids) {
+            sensorIdToHex(id, hex);
+            array.add(static_cast<const char*>(hex));
+        }
+    };
+    fill("added", added);
+    fill("restored", restored);
+    fill("retired", retired);
+    root["active"] = ds18b20Sensors.size();
+    socket->emitEvent(ONEWIRE_BUS_EVENT, root);
+}
+
+void OneWireThermalSubsystem::requestRescan() {
+    if (!_taskHandle) {
+        ESP_LOGE(TAG, "Bus task is not running. Rescan request ignored.");
+        return;
+    }
+    xTaskNotify(_taskHandle, NOTIFY_RESCAN, eSetBits);
+}
+
+size_t OneWireThermalSubsystem::getActiveSensorCount() const {
+    xSemaphoreTake(_sensorsMutex, portMAX_DELAY);
+    const size_t count = ds18b20Sensors.size();
+    xSemaphoreGive(_sensorsMutex);
+    return count;
+}
+
+OneWireBusStats OneWireThermalSubsystem::getBusStats() const {
+    taskENTER_CRITICAL(&_statsMux);
+    const OneWireBusStats stats = _busStats;
+    taskEXIT_CRITICAL(&_statsMux);
+    return stats;
+}
+
+void OneWireThermalSubsystem::readSensors(const std::function<void(const DS18B20Sensor*)>& reader) const {
+    if (!_sensorsMutex) {
+        return;
+    }
+    xSemaphoreTake(_sensorsMutex, portMAX_DELAY);
+    for (const auto* list : {&ds18b20Sensors, &retiredSensors}) {
+        for (const DS18B20Sensor* dsSensor : *list) {
+            reader(dsSensor);
+        }
+    }
+    xSemaphoreGive(_sensorsMutex);
 }
 
+size_t OneWireThermalSubsystem::getRetiredSensorCount() const {
+    xSemaphoreTake(_sensorsMutex, portMAX_DELAY);
+    const size_t count = retiredSensors.size();
+    xSemaphoreGive(_sensorsMutex);
+    return count;
+}
+
+void OneWireThermalSubsystem::requestRescanAll() {
+    for (OneWireThermalSubsystem* bus : _buses) {
+        bus->requestRescan();
+    }
+}
+
+bool OneWireThermalSubsystem::setSensorResolution(const SensorId id, const uint8_t bits) {
+    for (OneWireThermalSubsystem* bus : _buses) {
+        bool accepted = false;
+        if (bus->trySetSensorResolution(id, bits, accepted)) {
+            return accepted;
+        }
+    }
+    char hex[SENSOR_ID_HEX_LENGTH + 1];
+    sensorIdToHex(id, hex);
+    ESP_LOGW(TAG, "Cannot set resolution: sensor %s is not on any bus.", hex);
+    return false;
+}
+
+bool OneWireThermalSubsystem::trySetSensorResolution(const SensorId id, const uint8_t bits, bool& accepted) {
+    if (!_sensorsMutex) {
+        return false;
+    }
+    xSemaphoreTake(_sensorsMutex, portMAX_DELAY);
+    bool known = false;
+    // Пропавшему датчику разрешение тоже запоминаем: оно будет записано после его возврата
+    for (const auto* list : {&ds18b20Sensors, &retiredSensors}) {
+        for (DS18B20Sensor* dsSensor : *list) {
+            if (dsSensor->getId() == id) {
+                accepted = dsSensor->requestResolution(bits);
+                known = true;
+                break;
+            }
+        }
+        if (known) break;
+    }
+    xSemaphoreGive(_sensorsMutex);
+    return known;
+}
+
+uint16_t OneWireThermalSubsystem::prepareConversion() {
+    uint16_t waitMs = 0;
+    for (DS18B20Sensor* dsSensor : ds18b20Sensors) {
+        dsSensor->applyPendingResolution();
+        const uint16_t sensorWaitMs = dsSensor->getConversionTimeMs();
+        if (sensorWaitMs > waitMs) {
+            waitMs = sensorWaitMs;
+        }
+    }
+    return waitMs;
+}
 
 // --- Цикл Опроса RTOS ---
 
 void OneWireThermalSubsystem::poll() {
-    // 1. Фаза 1: Запрос температуры (специфика 1-Wire)
-    if (dallasTemp) {
-        ESP_LOGV(TAG, "Polling cycle started. Requesting temperatures for all %zu devices.", ds18b20Sensors.size());
+    // Вызывается из демона таймеров: только будим задачу шины
+    if (!_taskHandle) {
+        ESP_LOGE(TAG, "Bus task is not running. Poll request ignored.");
+        notifyAcquisitionComplete();
+        return;
+    }
+    if (_phase != ConversionPhase::IDLE) {
+        // Бит уведомления сохранится: цикл выполнится сразу после текущей операции
+        ESP_LOGD(TAG, "Poll requested while bus is busy (phase %d). Cycle queued.", static_cast<int>(_phase));
+    }
+    xTaskNotify(_taskHandle, NOTIFY_POLL, eSetBits);
+}
+
+void OneWireThermalSubsystem::busTask(void* param) {
+    auto* self = static_cast<OneWireThermalSubsystem*>(param);
+    for (;;) {
+        // Ждем запроса цикла от координатора или запроса поиска
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
 
-        dallasTemp->requestTemperatures(); 
-        
-        ESP_LOGV(TAG, "Temperature conversion initiated/completed.");
+        if (bits & NOTIFY_RESCAN) {
+            self->_rescanPending = true;
+        }
+        // Поиск выполняется только внутри цикла опроса: результат попадет в публикацию этого же цикла
+        if (bits & NOTIFY_POLL) {
+            if (self->_rescanPending || ++self->_cyclesSinceRescan >= RESCAN_INTERVAL_CYCLES) {
+                self->_rescanPending = false;
+                self->rescanBus(true);
+            }
+            self->runConversionCycle();
+            self->notifyAcquisitionComplete();
+        }
+    }
+}
+
+void OneWireThermalSubsystem::runConversionCycle() {
+    if (!dallasTemp) {
+        return;
     }
 
-    // 2. Фаза 2: Считывание и обновление состояния
-    // Итерируемся по внутреннему списку DS18B20Sensor*.
+    // 1. Фаза 1: Запрос температуры (без ожидания внутри библиотеки)
+    _phase = ConversionPhase::REQUESTING;
+    ESP_LOGV(TAG, "Polling cycle started. Requesting temperatures for all %zu devices.", ds18b20Sensors.size());
+    uint32_t busStart = millis();
+    // Ждем ровно столько, сколько нужно самому медленному датчику при его разрешении
+    const uint16_t waitMs = prepareConversion();
+    dallasTemp->requestTemperatures();
+    const uint32_t requestTime = millis() - busStart;
+
+    // 2. Ожидание преобразования: шина свободна, задача уступает процессор
+    _phase = ConversionPhase::CONVERTING;
+    _conversionTimeMs = waitMs;
+    vTaskDelay(pdMS_TO_TICKS(waitMs));
+
+    // 3. Фаза 2: Считывание и обновление состояния
+    _phase = ConversionPhase::READING;
+    busStart = millis();
     int readCount = 0;
+    uint16_t failedReads = 0;
     for (DS18B20Sensor* dsSensor : ds18b20Sensors) {
-        
-        // Вызываем readValue(), который использует dallasTemp внутри себя
-        dsSensor->readValue(); 
-        
-        // Логируем результат, используя getData()
-        const float temp = dsSensor->getData();
-        const std::string address = SensorManager::addressToString(dsSensor->getAddress());
-        
-        ESP_LOGV(TAG, "Read temp %.2f C for sensor %s.", temp, address.c_str());
-        
-        if (temp == DEVICE_DISCONNECTED_C) {
-             ESP_LOGW(TAG, "Sensor %s returned DEVICE_DISCONNECTED_C (Error: %.2f).", address.c_str(), temp);
+        // Вызываем readValue(): чтение scratchpad с повтором при ошибке CRC и учетом причин сбоя
+        dsSensor->readValue();
+
+        if (!dsSensor->isDataValid()) {
+            failedReads++;
         }
         readCount++;
     }
-    ESP_LOGV(TAG, "Polling cycle finished. %d sensor values processed.", readCount);
-}
\ No newline at end of file
+    const uint32_t readTime = millis() - busStart;
+    const uint32_t busTime = requestTime + readTime;
+
+    _lastBusTimeMs = busTime;
+    taskENTER_CRITICAL(&_statsMux);
+    _busStats.cycles++;
+    _busStats.lastRequestMs = requestTime;
+    _busStats.lastReadMs = readTime;
+    _busStats.maxBusMs = std::max(_busStats.maxBusMs, busTime);
+    _busStats.lastFailedReads = failedReads;
+    taskEXIT_CRITICAL(&_statsMux);
+
+    _phase = ConversionPhase::IDLE;
+    if (failedReads > 0) {
+        ESP_LOGW(TAG, "GPIO %u: %u of %d sensors returned no valid reading.", _pin, failedReads, readCount);
+    }
+    ESP_LOGV(TAG, "Polling cycle finished. %d sensor values processed, bus time %lu ms (conversion wait %u ms).",
+             readCount, busTime, waitMs);
+}
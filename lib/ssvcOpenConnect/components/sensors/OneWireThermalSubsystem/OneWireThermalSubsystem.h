@@ -19,45 +19,177 @@
  **/
 
 
+#include <atomic>
+#include <functional>
 #include <vector>
 #include "components/sensors/PollingSubsystem/PollingSubsystem.h"
 #include <OneWire.h>
 #include <DallasTemperature.h>
 #include "components/sensors/DS18B20Sensor/DS18B20Sensor.h"
 
+// Событие EventSocket об изменении состава шины
+#define ONEWIRE_BUS_EVENT "onewire_bus"
+
+// GPIO шин 1-Wire через запятую, например -D ONEWIRE_BUS_PINS=2,4
+#ifndef ONEWIRE_BUS_PINS
+#define ONEWIRE_BUS_PINS 2
+#endif
+
+/**
+ * @brief Тайминг и ошибки шины (обновляются задачей шины).
+ */
+struct OneWireBusStats {
+    uint32_t cycles = 0;          // Выполненных циклов преобразования
+    uint32_t lastRequestMs = 0;   // Отправка CONVERT T (с записью отложенных разрешений)
+    uint32_t lastReadMs = 0;      // Чтение scratchpad всех датчиков (с повторами)
+    uint32_t maxBusMs = 0;        // Максимум занятости шины за цикл (запрос + чтение)
+    uint16_t lastFailedReads = 0; // Датчиков без валидного показания в последнем цикле
+};
+
 /**
- * @brief Подсистема, управляющая 1-Wire опросом (DS18B20).
+ * @brief Подсистема, управляющая опросом одной шины 1-Wire (DS18B20).
+ * Создается по экземпляру на каждый GPIO; у каждой шины своя задача, поэтому
+ * шины преобразуют и читаются параллельно.
  */
 class OneWireThermalSubsystem final : public PollingSubsystem {
 public:
-    // Параметры специфичные для этой подсистемы
-    static constexpr uint8_t ONEWIRE_PIN = 2;
+    // Фоновый поиск новых/пропавших датчиков каждые N циклов опроса
+    static constexpr uint32_t RESCAN_INTERVAL_CYCLES = 30;
+
+    /**
+     * @brief Создает шины для всех GPIO из ONEWIRE_BUS_PINS и добавляет их в реестр.
+     * Подсистемы не инициализируются: это делает SensorCoordinator при регистрации.
+     */
+    static const std::vector<OneWireThermalSubsystem*>& createBuses();
+
+    // Все созданные шины
+    static const std::vector<OneWireThermalSubsystem*>& getBuses() { return _buses; }
 
-    static OneWireThermalSubsystem& getInstance();
+    /**
+     * @brief Задает разрешение датчика (9..12 бит) на той шине, где он найден.
+     * @return false, если датчик не найден ни на одной шине или разрешение вне диапазона.
+     */
+    static bool setSensorResolution(SensorId id, uint8_t bits);
+
+    // Внеочередной поиск устройств на всех шинах
+    static void requestRescanAll();
+
+    uint8_t getPin() const { return _pin; }
 
     // Реализация чистых виртуальных методов PollingSubsystem
     bool initialize() override;
-    void poll() override; // Здесь будет вызываться requestTemperatures и считывание
+    void poll() override; // Только будит задачу шины, не блокируется
 
     const char* getName() const override;
+    uint32_t getDeadlineMs() const override { return DEADLINE_MS; }
+
+    // Фазы конвейера преобразования
+    enum class ConversionPhase : uint8_t {
+        IDLE,       // Ожидание запроса от координатора
+        REQUESTING, // Отправка команды CONVERT T на шину
+        CONVERTING, // Датчики преобразуют, шина свободна, задача спит
+        READING,    // Чтение scratchpad каждого датчика
+        SCANNING,   // Поиск устройств на шине (hot-plug)
+    };
+
+    ConversionPhase getPhase() const { return _phase; }
+
+    // Время, фактически проведенное на шине в последнем цикле (запрос + чтение), мс
+    uint32_t getLastBusTimeMs() const { return _lastBusTimeMs; }
+
+    // Ожидание преобразования в последнем цикле: время самого медленного датчика, мс
+    uint32_t getConversionTimeMs() const { return _conversionTimeMs; }
+
+    /**
+     * @brief Запрашивает внеочередной поиск устройств. Выполняется задачей шины
+     * в начале следующего цикла опроса, вызов не блокируется.
+     */
+    void requestRescan();
+
+    size_t getActiveSensorCount() const;
+    size_t getRetiredSensorCount() const;
+
+    OneWireBusStats getBusStats() const;
+
+    /**
+     * @brief Обходит датчики шины (опрашиваемые и пропавшие) под мьютексом списков.
+     */
+    void readSensors(const std::function<void(const DS18B20Sensor*)>& reader) const;
 
 private:
-    // Константы для конструктора родителя
+    // Параметры задачи шины (имя задачи дополняется номером GPIO)
     static constexpr auto DEFAULT_TASK_NAME = "OneWireTask";
-    static constexpr TickType_t DEFAULT_POLL_INTERVAL = pdMS_TO_TICKS(1000);
+    static constexpr uint32_t TASK_STACK_SIZE = 6144;
+    static constexpr UBaseType_t TASK_PRIORITY = tskIDLE_PRIORITY + 1;
+
+    explicit OneWireThermalSubsystem(uint8_t pin);
+
+    static std::vector<OneWireThermalSubsystem*> _buses;
 
-    // Приватный конструктор, вызывающий родительский
-    OneWireThermalSubsystem()
-        : PollingSubsystem() {}
+    const uint8_t _pin;
+    char _name[24];
 
     OneWire* oneWireBus = nullptr;
     DallasTemperature* dallasTemp = nullptr;
 
+    // Опрашиваемые датчики. Изменяется только задачей шины (и initialize() до ее запуска)
     std::vector<DS18B20Sensor*> ds18b20Sensors;
+    // Пропавшие с шины датчики. Объекты не удаляются: при возврате датчик восстанавливается
+    std::vector<DS18B20Sensor*> retiredSensors;
+    // Защищает списки от чтения из других задач во время их изменения
+    SemaphoreHandle_t _sensorsMutex = nullptr;
+    // Порядковый номер для имени следующего обнаруженного датчика (общий для всех шин)
+    static std::atomic<int> _nextSensorIndex;
+
+    // Биты уведомления задачи шины
+    static constexpr uint32_t NOTIFY_POLL = 1 << 0;
+    static constexpr uint32_t NOTIFY_RESCAN = 1 << 1;
+
+    TaskHandle_t _taskHandle = nullptr;
+    volatile ConversionPhase _phase = ConversionPhase::IDLE;
+    volatile uint32_t _lastBusTimeMs = 0;
+    volatile uint32_t _conversionTimeMs = 0;
+    OneWireBusStats _busStats;
+    mutable portMUX_TYPE _statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Применяет отложенные смены разрешения и возвращает время ожидания самого медленного датчика
+    uint16_t prepareConversion();
+
+    uint32_t _cyclesSinceRescan = 0;
+    bool _rescanPending = false;
+
+    static void busTask(void* param);
+
+    // Один проход конвейера: запрос -> ожидание (yield) -> чтение
+    void runConversionCycle();
 
     // Вспомогательная функция, специфичная для 1-Wire
     void discoverAndRegisterSensors();
 
+    /**
+     * @brief Инкрементальный поиск: сравнивает найденные адреса с известными,
+     * добавляет новые датчики и выводит из опроса пропавшие, не трогая остальные объекты.
+     * @param emitEvent Отправить событие ONEWIRE_BUS_EVENT при изменении состава.
+     */
+    void rescanBus(bool emitEvent);
+
+    // Поиск 1-Wire: добавляет в found адреса DS18B20 с корректной CRC
+    void searchBus(std::vector<SensorId>& found) const;
+
+    // Создает и регистрирует новый датчик, применяя сохраненные зону и разрешение.
+    // nullptr, если адрес уже зарегистрирован (например, на другой шине)
+    DS18B20Sensor* addSensor(const AbstractSensor::Address& addr);
+
+    /**
+     * @brief Ставит в очередь смену разрешения, если датчик принадлежит этой шине.
+     * @param accepted Результат проверки диапазона разрешения.
+     * @return true, если датчик найден на этой шине.
+     */
+    bool trySetSensorResolution(SensorId id, uint8_t bits, bool& accepted);
+
+    // Допустимое время сбора: преобразование при 12 битах (750 мс) плюс чтение и поиск
+    static constexpr uint32_t DEADLINE_MS = 2000;
+
     static constexpr auto TAG = "ONEWIRE_SUB";
 };
 
@@ -20,6 +20,7 @@
 
 
 #include <stdint.h>
+#include <functional>
 #include "ESP32SvelteKit.h"
 
 #ifndef POLLING_SUBSYSTEM_TAG
@@ -32,10 +33,25 @@ public:
     // Установка инициализации должна быть выполнена в наследнике (например, в OneWireThermalSubsystem::initialize())
     virtual bool initialize() = 0;
 
-    // Чистый виртуальный метод для выполнения сбора данных.
-    // Вызывается ОДНОКРАТНО за цикл из SensorCoordinator.
+    // Чистый виртуальный метод для запуска сбора данных.
+    // Вызывается ОДНОКРАТНО за цикл из SensorCoordinator (в контексте демона таймеров),
+    // поэтому не должен блокироваться. По окончании сбора подсистема обязана вызвать
+    // notifyAcquisitionComplete(): синхронные подсистемы - прямо из poll(),
+    // асинхронные - из своей задачи.
     virtual void poll() = 0;
 
+    // Собственный период опроса подсистемы, мс. 0 - период координатора по умолчанию
+    // (аргумент SensorCoordinator::startPolling).
+    virtual uint32_t getPollPeriodMs() const { return 0; }
+
+    // Допустимое время от вызова poll() до готовности данных, мс. 0 - равно периоду.
+    // Превышение учитывается координатором как пропуск срока (deadline miss).
+    virtual uint32_t getDeadlineMs() const { return 0; }
+
+    // Колбэк завершения сбора, устанавливается SensorCoordinator при регистрации.
+    using AcquisitionCompleteCallback = std::function<void(PollingSubsystem*)>;
+    void setAcquisitionCompleteCallback(AcquisitionCompleteCallback cb) { _onAcquisitionComplete = std::move(cb); }
+
     // Виртуальный деструктор для корректного освобождения памяти.
     virtual ~PollingSubsystem() = default;
 
@@ -46,6 +62,14 @@ protected:
     // Защищенный конструктор по умолчанию, не требующий параметров RTOS.
     PollingSubsystem() = default;
 
+    // Сообщает координатору, что свежие показания готовы к публикации.
+    void notifyAcquisitionComplete() {
+        if (_onAcquisitionComplete) _onAcquisitionComplete(this);
+    }
+
+private:
+    AcquisitionCompleteCallback _onAcquisitionComplete;
+
 };
 
 #endif // SSVC_OPEN_CONNECT_POLLINGSUBSYSTEM_H
\ No newline at end of file
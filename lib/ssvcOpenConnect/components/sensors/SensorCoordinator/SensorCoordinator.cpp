@@ -16,7 +16,9 @@
  **/
 
 #include "SensorCoordinator.h"
+#include <algorithm>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "components/sensors/SensorManager/SensorManager.h"
 #include "core/AlarmMonitor/AlarmMonitor.h"
 #include "core/StatefulServices/SensorDataService/SensorDataService.h"
@@ -37,17 +39,54 @@ void SensorCoordinator::pollTimerCallback(const TimerHandle_t xTimer) {
     }
 }
 
-void SensorCoordinator::startPolling(const uint32_t periodMs) {
+namespace {
+    uint32_t gcd(uint32_t a, uint32_t b) {
+        while (b != 0) {
+            const uint32_t t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+}
+
+void SensorCoordinator::startPolling(const uint32_t defaultPeriodMs) {
+    if (_schedule.empty()) {
+        ESP_LOGW(TAG, "No polling subsystems registered. Polling not started.");
+        return;
+    }
     if (_pollTimerHandle) {
-        ESP_LOGV(TAG, "Polling timer already created. Restarting.");
         xTimerStop(_pollTimerHandle, 0);
-        xTimerChangePeriod(_pollTimerHandle, pdMS_TO_TICKS(periodMs), 0);
+    }
+
+    // Эффективные периоды и сроки; шаг таймера - НОД периодов, чтобы каждый срок попадал на шаг
+    uint32_t tickMs = 0;
+    const int64_t now = esp_timer_get_time();
+    for (ScheduledSubsystem& entry : _schedule) {
+        const uint32_t ownPeriodMs = entry.subsystem->getPollPeriodMs();
+        const uint32_t periodMs = ownPeriodMs != 0 ? ownPeriodMs : defaultPeriodMs;
+        const uint32_t deadlineMs = entry.subsystem->getDeadlineMs();
+        taskENTER_CRITICAL(&_scheduleMux);
+        entry.stats.periodMs = periodMs;
+        entry.stats.deadlineMs = deadlineMs != 0 ? deadlineMs : periodMs;
+        // Первый сбор - через период после старта, как и раньше
+        entry.nextDueUs = now + static_cast<int64_t>(periodMs) * 1000;
+        taskEXIT_CRITICAL(&_scheduleMux);
+        tickMs = gcd(tickMs, periodMs);
+        ESP_LOGV(TAG, "Subsystem %s: period %lu ms, deadline %lu ms.",
+                 entry.stats.name, periodMs, entry.stats.deadlineMs);
+    }
+    // Шаг не меньше тика FreeRTOS
+    _tickMs = std::max<uint32_t>(tickMs, portTICK_PERIOD_MS);
+    const TickType_t periodTicks = pdMS_TO_TICKS(_tickMs);
+
+    if (_pollTimerHandle) {
+        ESP_LOGV(TAG, "Polling timer already created. Restarting.");
+        xTimerChangePeriod(_pollTimerHandle, periodTicks, 0);
         xTimerStart(_pollTimerHandle, 0);
         return;
     }
 
-    const TickType_t periodTicks = pdMS_TO_TICKS(periodMs);
-
     // 1. Создание таймера
     _pollTimerHandle = xTimerCreate(
         SENSOR_POLL_TIMER_NAME,
@@ -64,48 +103,228 @@ void SensorCoordinator::startPolling(const uint32_t periodMs) {
     if (xTimerStart(_pollTimerHandle, 0) != pdPASS) {
         ESP_LOGE(TAG, "Failed to start FreeRTOS Sensor Poll Timer!");
     } else {
-        ESP_LOGV(TAG, "FreeRTOS Sensor Poll Timer started, interval: %lu ms", periodMs);
+        ESP_LOGV(TAG, "FreeRTOS Sensor Poll Timer started, tick: %lu ms, %zu subsystems.", _tickMs, _schedule.size());
     }
 }
 
 void SensorCoordinator::registerPollingSubsystem(PollingSubsystem* subsystem) {
-    if (subsystem) {
-        subsystem->initialize();
-        _pollingSubsystems.push_back(subsystem);
+    if (!subsystem) {
+        return;
+    }
+    if (_pollTimerHandle) {
+        // Размер расписания фиксируется при старте: индексы используются из задач подсистем
+        ESP_LOGE(TAG, "Cannot register %s: polling already started.", subsystem->getName());
+        return;
     }
+    const size_t index = _schedule.size();
+    subsystem->setAcquisitionCompleteCallback([this, index](PollingSubsystem*) {
+        onAcquisitionComplete(index);
+    });
+    subsystem->initialize();
+
+    ScheduledSubsystem entry;
+    entry.subsystem = subsystem;
+    entry.stats.name = subsystem->getName();
+    _schedule.push_back(entry);
+    _batches.resize(_schedule.size());
+    _dueScratch.reserve(_schedule.size());
 }
 
-void SensorCoordinator::executePollCycle() const
+void SensorCoordinator::executePollCycle()
 {
-    if (_pollingSubsystems.empty()) {
+    if (_schedule.empty()) {
         ESP_LOGV(TAG, "No polling subsystems registered. Skipping poll cycle.");
         return;
     }
-    ESP_LOGV(TAG, "Starting sensor poll cycle for %zu subsystems.", _pollingSubsystems.size());
-    // 1. СБОР ДАННЫХ (Вызов poll() у каждой подсистемы) ---
-    for (PollingSubsystem* subsystem : _pollingSubsystems) {
-        subsystem->poll();
+    const int64_t now = esp_timer_get_time();
+    // Срок, наступающий раньше середины следующего шага, считаем наступившим
+    const int64_t toleranceUs = static_cast<int64_t>(_tickMs) * 500;
+    uint32_t overruns = 0;
+
+    _dueScratch.clear();
+    taskENTER_CRITICAL(&_scheduleMux);
+    for (size_t i = 0; i < _schedule.size(); i++) {
+        ScheduledSubsystem& entry = _schedule[i];
+        if (now + toleranceUs < entry.nextDueUs) {
+            continue;
+        }
+        const int64_t periodUs = static_cast<int64_t>(entry.stats.periodMs) * 1000;
+        const int64_t jitterUs = now > entry.nextDueUs ? now - entry.nextDueUs : entry.nextDueUs - now;
+        entry.stats.lastJitterUs = static_cast<uint32_t>(jitterUs);
+        entry.stats.maxJitterUs = std::max(entry.stats.maxJitterUs, entry.stats.lastJitterUs);
+
+        // Следующий срок - от расписания, а не от факта запуска, чтобы опоздания не накапливались.
+        // Если пропущен целый период, расписание сдвигается на текущее время
+        entry.nextDueUs += periodUs;
+        if (entry.nextDueUs <= now) {
+            entry.nextDueUs = now + periodUs;
+        }
+
+        if (entry.inFlight) {
+            entry.stats.overruns++;
+            overruns++;
+            continue;
+        }
+        entry.inFlight = true;
+        entry.dispatchedUs = now;
+        entry.stats.dispatches++;
+        _dueScratch.push_back(i);
     }
-    //  2. ПУБЛИКАЦИЯ ДАННЫХ (Централизованно через SensorManager)
-    // SensorManager собирает данные из AbstractSensor'ов и обновляет SensorDataService.
-    SensorManager::getInstance().processReadingsAndPublish();
 
-    ESP_LOGV(TAG, "Sensor poll cycle finished. Data published.");
+    if (!_dueScratch.empty()) {
+        // Свободный слот есть всегда: у каждого активного цикла есть хотя бы одна занятая подсистема
+        for (size_t slot = 0; slot < _batches.size(); slot++) {
+            PendingBatch& batch = _batches[slot];
+            if (batch.pending != 0) {
+                continue;
+            }
+            batch.pending = static_cast<uint8_t>(_dueScratch.size());
+            batch.subsystems = batch.pending;
+            batch.startUs = now;
+            for (const size_t index : _dueScratch) {
+                _schedule[index].batch = static_cast<uint8_t>(slot);
+            }
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&_scheduleMux);
 
-    for (PollingSubsystem* subsystem : _pollingSubsystems) {
-        subsystem->poll();
+    if (overruns > 0) {
+        _skippedTicks += overruns;
+        ESP_LOGW(TAG, "%lu subsystem(s) still busy with previous acquisition. Skipping their slot.", overruns);
     }
+    if (_dueScratch.empty()) {
+        return;
+    }
+    ESP_LOGV(TAG, "Starting sensor poll cycle for %zu subsystems.", _dueScratch.size());
 
-    // 3. Проверка порогов после каждого обновления данных
-    AlarmMonitor::getInstance().checkAllSensors();
+    // 1. ACQUIRE (poll() только запускает сбор, результат придет в onAcquisitionComplete)
+    for (const size_t index : _dueScratch) {
+        _schedule[index].subsystem->poll();
+    }
+}
+
+void SensorCoordinator::onAcquisitionComplete(const size_t index)
+{
+    const int64_t now = esp_timer_get_time();
+    bool batchDone = false;
+    bool deadlineMissed = false;
+    PendingBatch completed;
 
-    // После того как данные собраны и опубликованы в SensorManager
+    taskENTER_CRITICAL(&_scheduleMux);
+    ScheduledSubsystem& entry = _schedule[index];
+    if (!entry.inFlight) {
+        taskEXIT_CRITICAL(&_scheduleMux);
+        return;
+    }
+    entry.inFlight = false;
+    entry.stats.lastAcquireUs = static_cast<uint32_t>(now - entry.dispatchedUs);
+    entry.stats.maxAcquireUs = std::max(entry.stats.maxAcquireUs, entry.stats.lastAcquireUs);
+    if (entry.stats.lastAcquireUs > entry.stats.deadlineMs * 1000) {
+        entry.stats.deadlineMisses++;
+        deadlineMissed = true;
+    }
+    PendingBatch& batch = _batches[entry.batch];
+    if (--batch.pending == 0) {
+        completed = batch;
+        batchDone = true;
+    }
+    const SubsystemScheduleStats stats = entry.stats;
+    taskEXIT_CRITICAL(&_scheduleMux);
+
+    ESP_LOGV(TAG, "Subsystem %s finished acquisition in %lu us.", stats.name, stats.lastAcquireUs);
+    if (deadlineMissed) {
+        ESP_LOGW(TAG, "Subsystem %s missed its deadline: %lu us > %lu ms.", stats.name, stats.lastAcquireUs, stats.deadlineMs);
+    }
+    if (batchDone) {
+        // Последняя подсистема цикла: публикуем в ее контексте
+        SensorManager& manager = SensorManager::getInstance();
+        manager.lockRegistry();
+        completePollCycle(completed, now);
+        manager.unlockRegistry();
+    }
+}
+
+void SensorCoordinator::completePollCycle(const PendingBatch& batch, const int64_t acquiredUs)
+{
+    PollCycleTiming timing;
+    timing.cycle = ++_cycleCounter;
+    timing.subsystems = batch.subsystems;
+
+    int64_t stageStart = esp_timer_get_time();
+    timing.acquireUs = static_cast<uint32_t>(acquiredUs - batch.startUs);
+
+    // 2. VALIDATE
+    stageValidate(timing);
+    int64_t now = esp_timer_get_time();
+    timing.validateUs = static_cast<uint32_t>(now - stageStart);
+    stageStart = now;
+
+    // 3. PUBLISH (однократно за цикл)
+    stagePublish();
+    now = esp_timer_get_time();
+    timing.publishUs = static_cast<uint32_t>(now - stageStart);
+    stageStart = now;
+
+    // 4. EVALUATE ALARMS
+    stageEvaluateAlarms();
+    now = esp_timer_get_time();
+    timing.alarmsUs = static_cast<uint32_t>(now - stageStart);
+    timing.totalUs = static_cast<uint32_t>(now - batch.startUs);
+
+    taskENTER_CRITICAL(&_timingMux);
+    _lastTiming = timing;
+    taskEXIT_CRITICAL(&_timingMux);
+
+    ESP_LOGD(TAG, "Cycle %lu: acquire %lu us, validate %lu us, publish %lu us, alarms %lu us, total %lu us (%u valid, %u invalid).",
+             timing.cycle, timing.acquireUs, timing.validateUs, timing.publishUs, timing.alarmsUs, timing.totalUs,
+             timing.validSensors, timing.invalidSensors);
+
+    notifyFirstScanDone();
+}
+
+void SensorCoordinator::stageValidate(PollCycleTiming& timing) const
+{
+    const SensorList registered = SensorManager::getInstance().getAllSensors();
+    for (const AbstractSensor* sensor : *registered) {
+        if (sensor->isDataValid()) {
+            timing.validSensors++;
+        } else {
+            timing.invalidSensors++;
+        }
+    }
+}
+
+void SensorCoordinator::stagePublish()
+{
+    // SensorManager собирает данные из AbstractSensor'ов и обновляет SensorDataService.
     SensorManager::getInstance().processReadingsAndPublish();
+}
 
-    // ВАЖНО: Вызываем уведомление.
-    // Т.к. метод const, нам нужно либо убрать const, либо использовать mutable для флага.
-    // Рекомендую убрать const у executePollCycle, так как он меняет состояние системы.
-    const_cast<SensorCoordinator*>(this)->notifyFirstScanDone();
+void SensorCoordinator::stageEvaluateAlarms()
+{
+    AlarmMonitor::getInstance().checkAllSensors();
+}
+
+std::vector<SubsystemScheduleStats> SensorCoordinator::getScheduleStats() const
+{
+    std::vector<SubsystemScheduleStats> result;
+    result.reserve(_schedule.size());
+    for (size_t i = 0; i < _schedule.size(); i++) {
+        taskENTER_CRITICAL(&_scheduleMux);
+        const SubsystemScheduleStats stats = _schedule[i].stats;
+        taskEXIT_CRITICAL(&_scheduleMux);
+        result.push_back(stats);
+    }
+    return result;
+}
+
+PollCycleTiming SensorCoordinator::getLastCycleTiming() const
+{
+    taskENTER_CRITICAL(&_timingMux);
+    const PollCycleTiming timing = _lastTiming;
+    taskEXIT_CRITICAL(&_timingMux);
+    return timing;
 }
 
 // Добавьте реализацию методов
@@ -22,10 +22,42 @@
  *   Disclaimer: Use at your own risk. High voltage safety precautions required.
  **/
 
+#include <atomic>
 #include <vector>
 #include "components/sensors/PollingSubsystem/PollingSubsystem.h"
 // PollingSubsystem теперь должен быть чистым интерфейсом (без RTOS-задачи)
 
+/**
+ * @brief Запись о стоимости одного цикла опроса по стадиям (микросекунды).
+ */
+struct PollCycleTiming {
+    uint32_t cycle = 0;          // Порядковый номер цикла
+    uint32_t acquireUs = 0;      // Старт цикла -> готовность последней подсистемы
+    uint32_t validateUs = 0;     // Проверка валидности показаний
+    uint32_t publishUs = 0;      // Обновление SensorDataService
+    uint32_t alarmsUs = 0;       // AlarmMonitor::checkAllSensors()
+    uint32_t totalUs = 0;        // Весь цикл целиком
+    uint16_t validSensors = 0;   // Датчиков с валидными данными
+    uint16_t invalidSensors = 0; // Датчиков с ошибкой чтения
+    uint8_t subsystems = 0;      // Подсистем, запущенных в этом цикле
+};
+
+/**
+ * @brief Статистика планировщика по одной подсистеме.
+ */
+struct SubsystemScheduleStats {
+    const char* name = nullptr;
+    uint32_t periodMs = 0;       // Эффективный период опроса
+    uint32_t deadlineMs = 0;     // Эффективный срок готовности данных
+    uint32_t dispatches = 0;     // Сколько раз запущен сбор
+    uint32_t overruns = 0;       // Сроки, пропущенные из-за незавершенного предыдущего сбора
+    uint32_t deadlineMisses = 0; // Сборы, завершившиеся позже срока
+    uint32_t lastJitterUs = 0;   // Отклонение запуска от расписания (модуль)
+    uint32_t maxJitterUs = 0;
+    uint32_t lastAcquireUs = 0;  // poll() -> готовность данных
+    uint32_t maxAcquireUs = 0;
+};
+
 class SensorCoordinator final {
 public:
     // --- Singleton Access ---
@@ -34,23 +66,26 @@ public:
     void operator=(const SensorCoordinator&) = delete;
 
     /**
-     * @brief Запускает Software Timer для периодического вызова executePollCycle.
-     * @param periodMs Интервал опроса в миллисекундах.
+     * @brief Запускает планировщик опроса. Каждая подсистема опрашивается со своим периодом
+     * (PollingSubsystem::getPollPeriodMs); шаг таймера равен НОД всех периодов.
+     * @param defaultPeriodMs Период для подсистем, не задавших собственный, мс.
      */
-    void startPolling(uint32_t periodMs);
+    void startPolling(uint32_t defaultPeriodMs);
 
     /**
      * @brief Регистрирует подсистему для включения в централизованный цикл опроса.
+     * Должна вызываться до startPolling().
      * @param subsystem Указатель на объект, реализующий PollingSubsystem.
      */
     void registerPollingSubsystem(PollingSubsystem* subsystem);
 
     /**
-     * @brief Выполняет полный цикл сбора и публикации данных.
-     * 1. Вызывает poll() у всех зарегистрированных подсистем (Сбор).
-     * 2. Запускает SensorManager::processReadingsAndPublish() (Публикация).
+     * @brief Шаг планировщика.
+     * Вызывает poll() у подсистем, для которых наступил срок, и сразу возвращается.
+     * Подсистемы, запущенные на одном шаге, образуют цикл: публикация выполняется
+     * в completePollCycle(), когда последняя из них сообщит о готовности данных.
      */
-    void executePollCycle() const;
+    void executePollCycle();
 
     // Тип функции для колбэка
     using OnFirstScanCallback = std::function<void()>;
@@ -60,14 +95,79 @@ public:
      */
     void onFirstScanComplete(OnFirstScanCallback cb);
 
+    /**
+     * @brief Возвращает копию записи о последнем завершенном цикле.
+     */
+    PollCycleTiming getLastCycleTiming() const;
+
+    /**
+     * @brief Количество сроков опроса, пропущенных из-за незавершенного предыдущего сбора
+     * (сумма overruns по всем подсистемам).
+     */
+    uint32_t getSkippedTicks() const { return _skippedTicks; }
+
+    /**
+     * @brief Копия статистики планировщика по всем подсистемам (в порядке регистрации).
+     */
+    std::vector<SubsystemScheduleStats> getScheduleStats() const;
+
+    // Текущий шаг таймера планировщика, мс
+    uint32_t getTickMs() const { return _tickMs; }
+
 private:
     SensorCoordinator() = default;
 
     TimerHandle_t _pollTimerHandle = nullptr;
     static void pollTimerCallback(TimerHandle_t xTimer);
 
-    // Вектор указателей на подсистемы, которые нужно опрашивать.
-    std::vector<PollingSubsystem*> _pollingSubsystems;
+    // Подсистема в расписании
+    struct ScheduledSubsystem {
+        PollingSubsystem* subsystem = nullptr;
+        int64_t nextDueUs = 0;      // Плановое время следующего запуска
+        int64_t dispatchedUs = 0;   // Фактическое время последнего запуска
+        bool inFlight = false;      // Сбор запущен и еще не завершен
+        uint8_t batch = 0;          // Слот цикла, в котором запущен сбор
+        SubsystemScheduleStats stats;
+    };
+
+    // Цикл: подсистемы, запущенные на одном шаге планировщика
+    struct PendingBatch {
+        uint8_t pending = 0;        // Сколько подсистем еще не сообщили о готовности
+        uint8_t subsystems = 0;
+        int64_t startUs = 0;
+    };
+
+    // Заполняется при регистрации, после startPolling() размер не меняется
+    std::vector<ScheduledSubsystem> _schedule;
+    // Активных циклов не больше, чем подсистем: слот на каждую
+    std::vector<PendingBatch> _batches;
+    // Индексы подсистем, запускаемых на текущем шаге
+    std::vector<size_t> _dueScratch;
+    // Защищает поля расписания между таймером и задачами подсистем
+    mutable portMUX_TYPE _scheduleMux = portMUX_INITIALIZER_UNLOCKED;
+
+    uint32_t _tickMs = 0;
+
+    // Вызывается подсистемой (из ее контекста) по окончании сбора
+    void onAcquisitionComplete(size_t index);
+
+    /**
+     * @brief Стадии после сбора: validate -> publish -> alarms.
+     * Выполняется в контексте подсистемы, завершившей сбор последней в цикле,
+     * под блокировкой реестра SensorManager (циклы разных периодов не пересекаются).
+     */
+    void completePollCycle(const PendingBatch& batch, int64_t acquiredUs);
+
+    // --- Стадии конвейера ---
+    void stageValidate(PollCycleTiming& timing) const;
+    static void stagePublish();
+    static void stageEvaluateAlarms();
+
+    // Учет времени по стадиям
+    uint32_t _cycleCounter = 0;
+    std::atomic<uint32_t> _skippedTicks{0};
+    PollCycleTiming _lastTiming;
+    mutable portMUX_TYPE _timingMux = portMUX_INITIALIZER_UNLOCKED;
 
     static constexpr auto TAG = "SENSOR_COORDINATOR";
 
@@ -0,0 +1,133 @@
+#include "SensorFilter.h"
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <cmath>
+
+SensorFilterSettings SensorFilter::_zoneSettings[SENSOR_ZONE_COUNT];
+// Начинаем с 1: нулевая версия у нового фильтра означает "еще не настроен"
+uint32_t SensorFilter::_settingsVersion = 1;
+portMUX_TYPE SensorFilter::_settingsMux = portMUX_INITIALIZER_UNLOCKED;
+
+float SensorFilter::apply(const SensorZone zone, const float raw, bool& rejected) {
+    rejected = false;
+
+    uint32_t version = 0;
+    const SensorFilterSettings settings = getZoneSettings(zone, version);
+    if (version != _version || zone != _zone) {
+        reset();
+        _version = version;
+        _zone = zone;
+    }
+    if (settings.isPassThrough()) {
+        return raw;
+    }
+
+    // 1. Отбраковка скачков: сравнение с последним принятым сырым значением
+    if (settings.maxStep > 0.0f && _hasOutput && std::fabs(raw - _lastAccepted) > settings.maxStep) {
+        if (++_rejects <= MAX_CONSECUTIVE_REJECTS) {
+            rejected = true;
+            return _output;
+        }
+        // Скачок держится несколько отсчетов подряд - это реальное изменение, фильтр начинает заново
+        reset();
+    }
+    _rejects = 0;
+    _lastAccepted = raw;
+
+    // 2. Медиана по окну
+    float value = raw;
+    if (settings.medianWindow > 1) {
+        const uint8_t window = settings.medianWindow;
+        if (_count < window) {
+            _window[(_head + _count) % window] = raw;
+            _count++;
+        } else {
+            _window[_head] = raw;
+            _head = (_head + 1) % window;
+        }
+        value = median();
+    }
+
+    // 3. EMA
+    if (settings.emaAlpha < 1.0f && _hasOutput) {
+        value = _output + settings.emaAlpha * (value - _output);
+    }
+
+    _output = value;
+    _hasOutput = true;
+    return value;
+}
+
+float SensorFilter::median() const {
+    // Сортировка вставками копии окна: не больше MAX_MEDIAN_WINDOW элементов
+    float sorted[SensorFilterSettings::MAX_MEDIAN_WINDOW];
+    for (uint8_t i = 0; i < _count; i++) {
+        const float v = _window[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    // При четном числе точек (окно еще заполняется) - среднее двух центральных
+    if (_count % 2 == 0) {
+        return (sorted[_count / 2 - 1] + sorted[_count / 2]) / 2.0f;
+    }
+    return sorted[_count / 2];
+}
+
+void SensorFilter::reset() {
+    _head = 0;
+    _count = 0;
+    _rejects = 0;
+    _hasOutput = false;
+    _output = 0.0f;
+    _lastAccepted = 0.0f;
+}
+
+void SensorFilter::setZoneSettings(const SensorZone zone, const SensorFilterSettings& settings) {
+    const auto index = static_cast<size_t>(zone);
+    if (index >= SENSOR_ZONE_COUNT) {
+        return;
+    }
+    taskENTER_CRITICAL(&_settingsMux);
+    if (_zoneSettings[index] != settings) {
+        _zoneSettings[index] = settings;
+        _settingsVersion++;
+    }
+    taskEXIT_CRITICAL(&_settingsMux);
+}
+
+SensorFilterSettings SensorFilter::getZoneSettings(const SensorZone zone) {
+    uint32_t version = 0;
+    return getZoneSettings(zone, version);
+}
+
+SensorFilterSettings SensorFilter::getZoneSettings(const SensorZone zone, uint32_t& version) {
+    const auto index = static_cast<size_t>(zone);
+    if (index >= SENSOR_ZONE_COUNT) {
+        return {};
+    }
+    taskENTER_CRITICAL(&_settingsMux);
+    const SensorFilterSettings settings = _zoneSettings[index];
+    version = _settingsVersion;
+    taskEXIT_CRITICAL(&_settingsMux);
+    return settings;
+}
@@ -0,0 +1,93 @@
+#ifndef SSVC_OPEN_CONNECT_SENSORFILTER_H
+#define SSVC_OPEN_CONNECT_SENSORFILTER_H
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include "components/Zone/SensorZone.h"
+
+// Число зон (индекс массива настроек - значение SensorZone)
+constexpr size_t SENSOR_ZONE_COUNT = static_cast<size_t>(SensorZone::DELETED) + 1;
+
+/**
+ * @brief Настройки фильтра для зоны. Значения по умолчанию отключают все ступени.
+ */
+struct SensorFilterSettings {
+    static constexpr uint8_t MAX_MEDIAN_WINDOW = 9;
+
+    uint8_t medianWindow = 1; // Окно медианы (нечетное, 1 - выключено)
+    float emaAlpha = 1.0f;    // Вес нового значения в EMA (1 - выключено)
+    float maxStep = 0.0f;     // Максимальный скачок между отсчетами (0 - выключено)
+
+    bool isPassThrough() const { return medianWindow <= 1 && emaAlpha >= 1.0f && maxStep <= 0.0f; }
+
+    bool operator==(const SensorFilterSettings& other) const {
+        return medianWindow == other.medianWindow && emaAlpha == other.emaAlpha && maxStep == other.maxStep;
+    }
+    bool operator!=(const SensorFilterSettings& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Фильтр показаний одного датчика: отбраковка скачков -> медиана по N -> EMA.
+ * Память фиксирована (окно медианы в самом объекте). Настройки берутся из общей
+ * таблицы по зоне датчика; при их смене или смене зоны состояние сбрасывается.
+ */
+class SensorFilter {
+public:
+    // Столько отсчетов подряд за порогом скачка считаются выбросами; следующий - реальным изменением
+    static constexpr uint8_t MAX_CONSECUTIVE_REJECTS = 3;
+
+    /**
+     * @brief Пропускает сырое значение через фильтр зоны.
+     * @param rejected true, если значение отброшено как скачок (возвращается прежний выход).
+     * @return Отфильтрованное значение.
+     */
+    float apply(SensorZone zone, float raw, bool& rejected);
+
+    void reset();
+
+    // --- Общая таблица настроек по зонам (заполняется SensorConfigService) ---
+    static void setZoneSettings(SensorZone zone, const SensorFilterSettings& settings);
+    static SensorFilterSettings getZoneSettings(SensorZone zone);
+
+private:
+    float _window[SensorFilterSettings::MAX_MEDIAN_WINDOW] = {};
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+    uint8_t _rejects = 0;
+    bool _hasOutput = false;
+    float _output = 0.0f;
+    float _lastAccepted = 0.0f;
+
+    // Версия таблицы и зона, с которыми работает текущее состояние
+    uint32_t _version = 0;
+    SensorZone _zone = SensorZone::UNKNOWN;
+
+    float median() const;
+
+    static SensorFilterSettings _zoneSettings[SENSOR_ZONE_COUNT];
+    // Увеличивается при каждом изменении таблицы
+    static uint32_t _settingsVersion;
+    static portMUX_TYPE _settingsMux;
+
+    static SensorFilterSettings getZoneSettings(SensorZone zone, uint32_t& version);
+};
+
+#endif //SSVC_OPEN_CONNECT_SENSORFILTER_H
@@ -0,0 +1,162 @@
+#include "SensorHistory.h"
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+void SensorHistory::addSample(const uint32_t timestampMs, const float value) {
+    taskENTER_CRITICAL(&_mux);
+
+    if (_count == 0) {
+        _baseMs = timestampMs;
+        _lastRebaseMs = timestampMs;
+        _ema = value;
+    } else {
+        _ema += EMA_ALPHA * (value - _ema);
+    }
+
+    // 1. Вытесняем самую старую точку
+    if (_count == CAPACITY) {
+        const SensorSample& oldest = _samples[_head];
+        const double t = relativeSeconds(oldest.timestampMs);
+        _sumT -= t;
+        _sumY -= oldest.value;
+        _sumTT -= t * t;
+        _sumTY -= t * oldest.value;
+        popExtremes(static_cast<uint8_t>(_head));
+        _head = (_head + 1) % CAPACITY;
+        _count--;
+    }
+
+    // 2. Записываем новую точку
+    const size_t index = physicalIndex(_count);
+    _samples[index].timestampMs = timestampMs;
+    _samples[index].value = value;
+    _count++;
+    pushExtremes(static_cast<uint8_t>(index), value);
+
+    // Сдвиг выполняется до добавления в суммы: rebase() пересчитывает их по всему окну
+    if (timestampMs - _lastRebaseMs > REBASE_INTERVAL_MS) {
+        rebase();
+        _lastRebaseMs = timestampMs;
+    } else {
+        const double t = relativeSeconds(timestampMs);
+        _sumT += t;
+        _sumY += value;
+        _sumTT += t * t;
+        _sumTY += t * value;
+    }
+
+    taskEXIT_CRITICAL(&_mux);
+}
+
+void SensorHistory::clear() {
+    taskENTER_CRITICAL(&_mux);
+    _head = 0;
+    _count = 0;
+    _ema = 0.0f;
+    _minHead = _minCount = 0;
+    _maxHead = _maxCount = 0;
+    _baseMs = 0;
+    _lastRebaseMs = 0;
+    _sumT = _sumY = _sumTT = _sumTY = 0.0;
+    taskEXIT_CRITICAL(&_mux);
+}
+
+SensorTrend SensorHistory::getTrend() const {
+    SensorTrend trend;
+    taskENTER_CRITICAL(&_mux);
+    if (_count > 0) {
+        const SensorSample& newest = _samples[physicalIndex(_count - 1)];
+        trend.count = static_cast<uint16_t>(_count);
+        trend.windowMs = newest.timestampMs - _samples[_head].timestampMs;
+        trend.last = newest.value;
+        trend.ema = _ema;
+        trend.min = _samples[_minQueue[_minHead]].value;
+        trend.max = _samples[_maxQueue[_maxHead]].value;
+
+        const auto n = static_cast<double>(_count);
+        const double denominator = n * _sumTT - _sumT * _sumT;
+        // Наклон определен, если точки разнесены во времени хотя бы на ~1 с
+        if (_count >= 2 && denominator > 1e-6) {
+            const double slopePerSecond = (n * _sumTY - _sumT * _sumY) / denominator;
+            trend.slopePerMin = static_cast<float>(slopePerSecond * 60.0);
+        }
+    }
+    taskEXIT_CRITICAL(&_mux);
+    return trend;
+}
+
+size_t SensorHistory::copySamples(SensorSample* out, const size_t maxCount) const {
+    taskENTER_CRITICAL(&_mux);
+    // Если места меньше, чем точек, отдаем самые свежие
+    const size_t copied = _count < maxCount ? _count : maxCount;
+    const size_t skip = _count - copied;
+    for (size_t i = 0; i < copied; i++) {
+        out[i] = _samples[physicalIndex(skip + i)];
+    }
+    taskEXIT_CRITICAL(&_mux);
+    return copied;
+}
+
+double SensorHistory::relativeSeconds(const uint32_t timestampMs) const {
+    // Беззнаковая разность корректна и при переполнении millis()
+    return static_cast<double>(timestampMs - _baseMs) / 1000.0;
+}
+
+void SensorHistory::pushExtremes(const uint8_t index, const float value) {
+    // Минимум: с хвоста убираем точки, которые больше новой - они уже не станут минимумом
+    while (_minCount > 0 &&
+           _samples[_minQueue[(_minHead + _minCount - 1) % CAPACITY]].value >= value) {
+        _minCount--;
+    }
+    _minQueue[(_minHead + _minCount) % CAPACITY] = index;
+    _minCount++;
+
+    while (_maxCount > 0 &&
+           _samples[_maxQueue[(_maxHead + _maxCount - 1) % CAPACITY]].value <= value) {
+        _maxCount--;
+    }
+    _maxQueue[(_maxHead + _maxCount) % CAPACITY] = index;
+    _maxCount++;
+}
+
+void SensorHistory::popExtremes(const uint8_t index) {
+    // Вытесняемая точка может быть только в голове очереди
+    if (_minCount > 0 && _minQueue[_minHead] == index) {
+        _minHead = (_minHead + 1) % CAPACITY;
+        _minCount--;
+    }
+    if (_maxCount > 0 && _maxQueue[_maxHead] == index) {
+        _maxHead = (_maxHead + 1) % CAPACITY;
+        _maxCount--;
+    }
+}
+
+void SensorHistory::rebase() {
+    // Редкая O(N) операция: база переносится на самую старую точку, суммы
+    // пересчитываются заново, что заодно убирает накопленную ошибку округления
+    _baseMs = _samples[_head].timestampMs;
+    _sumT = _sumY = _sumTT = _sumTY = 0.0;
+    for (size_t i = 0; i < _count; i++) {
+        const SensorSample& sample = _samples[physicalIndex(i)];
+        const double t = relativeSeconds(sample.timestampMs);
+        _sumT += t;
+        _sumY += sample.value;
+        _sumTT += t * t;
+        _sumTY += t * sample.value;
+    }
+}
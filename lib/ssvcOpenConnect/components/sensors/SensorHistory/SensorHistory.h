@@ -0,0 +1,109 @@
+#ifndef SSVC_OPEN_CONNECT_SENSORHISTORY_H
+#define SSVC_OPEN_CONNECT_SENSORHISTORY_H
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @brief Одна точка истории: время (millis) и значение.
+ */
+struct SensorSample {
+    uint32_t timestampMs = 0;
+    float value = 0.0f;
+};
+
+/**
+ * @brief Статистика по окну истории, поддерживаемая инкрементально.
+ */
+struct SensorTrend {
+    uint16_t count = 0;       // Точек в окне
+    uint32_t windowMs = 0;    // Длительность окна (от самой старой точки до последней)
+    float last = 0.0f;        // Последнее значение
+    float ema = 0.0f;         // Экспоненциальное скользящее среднее
+    float min = 0.0f;         // Минимум по окну
+    float max = 0.0f;         // Максимум по окну
+    float slopePerMin = 0.0f; // Наклон МНК, единиц в минуту (°C/мин для температуры)
+};
+
+/**
+ * @brief Кольцевой буфер точек с O(1) статистикой: EMA, min/max по окну
+ * (монотонные очереди) и наклон линейной регрессии (скользящие суммы).
+ * Память фиксирована: ~0.7 КБ на датчик.
+ */
+class SensorHistory {
+public:
+    static constexpr size_t CAPACITY = 64;
+    // Вес новой точки в EMA
+    static constexpr float EMA_ALPHA = 0.2f;
+    static_assert(CAPACITY <= 256, "Queue indices are stored as uint8_t");
+
+    /**
+     * @brief Добавляет точку. Самая старая точка вытесняется при заполнении буфера.
+     */
+    void addSample(uint32_t timestampMs, float value);
+
+    void clear();
+
+    /**
+     * @brief Согласованная копия статистики (безопасно из любой задачи).
+     */
+    SensorTrend getTrend() const;
+
+    /**
+     * @brief Копирует точки от старой к новой в out (не более maxCount).
+     * @return Количество скопированных точек.
+     */
+    size_t copySamples(SensorSample* out, size_t maxCount) const;
+
+private:
+    SensorSample _samples[CAPACITY];
+    size_t _head = 0;  // Индекс самой старой точки
+    size_t _count = 0;
+
+    float _ema = 0.0f;
+
+    // Монотонные очереди индексов буфера для min/max (сами очереди - тоже кольца)
+    uint8_t _minQueue[CAPACITY] = {};
+    uint8_t _maxQueue[CAPACITY] = {};
+    size_t _minHead = 0, _minCount = 0;
+    size_t _maxHead = 0, _maxCount = 0;
+
+    // Суммы для МНК. Время в секундах относительно _baseMs, чтобы сохранить точность double
+    uint32_t _baseMs = 0;
+    // Время последнего сдвига базы: окно может быть длиннее интервала сдвига,
+    // поэтому интервал отсчитывается от него, а не от _baseMs
+    uint32_t _lastRebaseMs = 0;
+    double _sumT = 0.0, _sumY = 0.0, _sumTT = 0.0, _sumTY = 0.0;
+
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Смещать базу времени не реже, чем раз в час (и при переполнении millis)
+    static constexpr uint32_t REBASE_INTERVAL_MS = 3600UL * 1000UL;
+
+    size_t physicalIndex(size_t logical) const { return (_head + logical) % CAPACITY; }
+    double relativeSeconds(uint32_t timestampMs) const;
+
+    void pushExtremes(uint8_t index, float value);
+    void popExtremes(uint8_t index);
+    void rebase();
+};
+
+#endif //SSVC_OPEN_CONNECT_SENSORHISTORY_H
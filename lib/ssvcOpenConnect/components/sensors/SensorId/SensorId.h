@@ -0,0 +1,154 @@
+#ifndef SSVC_OPEN_CONNECT_SENSORID_H
+#define SSVC_OPEN_CONNECT_SENSORID_H
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Внутренний идентификатор датчика: 8 байт 1-Wire адреса в порядке big-endian.
+ * Сортировка по SensorId совпадает с сортировкой hex-строк адресов, поэтому порядок
+ * ключей в JSON остается прежним. Hex-строка строится только на границе JSON/логов.
+ */
+using SensorId = uint64_t;
+
+// 0 не является корректным 1-Wire адресом (нулевой family code и CRC)
+constexpr SensorId INVALID_SENSOR_ID = 0;
+
+// Длина hex-представления без завершающего нуля
+constexpr size_t SENSOR_ID_HEX_LENGTH = 16;
+
+inline SensorId sensorIdFromAddress(const uint8_t (&addr)[8]) {
+    SensorId id = 0;
+    for (const uint8_t byte : addr) {
+        id = (id << 8) | byte;
+    }
+    return id;
+}
+
+inline void sensorIdToAddress(SensorId id, uint8_t (&addr)[8]) {
+    for (int i = 7; i >= 0; i--) {
+        addr[i] = static_cast<uint8_t>(id & 0xFF);
+        id >>= 8;
+    }
+}
+
+/**
+ * @brief Записывает 16 hex-символов (верхний регистр) и завершающий ноль. Без выделения памяти.
+ */
+inline void sensorIdToHex(SensorId id, char (&out)[SENSOR_ID_HEX_LENGTH + 1]) {
+    static constexpr char DIGITS[] = "0123456789ABCDEF";
+    for (int i = SENSOR_ID_HEX_LENGTH - 1; i >= 0; i--) {
+        out[i] = DIGITS[id & 0xF];
+        id >>= 4;
+    }
+    out[SENSOR_ID_HEX_LENGTH] = '\0';
+}
+
+/**
+ * @brief Разбирает ровно 16 hex-символов (любой регистр).
+ * @return false при неверной длине или символе.
+ */
+inline bool sensorIdFromHex(const char* str, const size_t length, SensorId& out) {
+    if (!str || length != SENSOR_ID_HEX_LENGTH) {
+        return false;
+    }
+    SensorId id = 0;
+    for (size_t i = 0; i < length; i++) {
+        const char c = str[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else return false;
+        id = (id << 4) | nibble;
+    }
+    out = id;
+    return true;
+}
+
+/**
+ * @brief Плоская карта SensorId -> V на отсортированном векторе.
+ * Поиск - двоичный, итерация - по возрастанию id. Для 8-10 датчиков это
+ * компактнее и быстрее std::map и не выделяет память на каждый узел.
+ */
+template <typename V>
+class SensorIdMap {
+public:
+    using value_type = std::pair<SensorId, V>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    iterator begin() { return _items.begin(); }
+    iterator end() { return _items.end(); }
+    const_iterator begin() const { return _items.begin(); }
+    const_iterator end() const { return _items.end(); }
+
+    size_t size() const { return _items.size(); }
+    bool empty() const { return _items.empty(); }
+    void clear() { _items.clear(); }
+    void reserve(const size_t n) { _items.reserve(n); }
+
+    iterator find(const SensorId id) {
+        const auto it = lowerBound(id);
+        return (it != _items.end() && it->first == id) ? it : _items.end();
+    }
+
+    const_iterator find(const SensorId id) const {
+        const auto it = std::lower_bound(_items.begin(), _items.end(), id, keyLess);
+        return (it != _items.end() && it->first == id) ? it : _items.end();
+    }
+
+    size_t count(const SensorId id) const { return find(id) != end() ? 1 : 0; }
+
+    // Как std::map::operator[]: вставляет значение по умолчанию, если ключа нет
+    V& operator[](const SensorId id) {
+        auto it = lowerBound(id);
+        if (it == _items.end() || it->first != id) {
+            it = _items.insert(it, value_type(id, V()));
+        }
+        return it->second;
+    }
+
+    iterator erase(const_iterator it) { return _items.erase(it); }
+
+    size_t erase(const SensorId id) {
+        const auto it = find(id);
+        if (it == _items.end()) return 0;
+        _items.erase(it);
+        return 1;
+    }
+
+    bool operator==(const SensorIdMap& other) const { return _items == other._items; }
+    bool operator!=(const SensorIdMap& other) const { return !(*this == other); }
+
+private:
+    std::vector<value_type> _items;
+
+    static bool keyLess(const value_type& item, const SensorId id) { return item.first < id; }
+
+    iterator lowerBound(const SensorId id) {
+        return std::lower_bound(_items.begin(), _items.end(), id, keyLess);
+    }
+};
+
+#endif //SSVC_OPEN_CONNECT_SENSORID_H
@@ -31,52 +31,85 @@ SensorManager& SensorManager::getInstance() {
     return instance;
 }
 
-void SensorManager::registerSensor(AbstractSensor* newSensor) {
+bool SensorManager::registerSensor(AbstractSensor* newSensor) {
     if (!newSensor) {
         ESP_LOGW(TAG, "Attempted to register a NULL sensor. Ignoring.");
-        return;
+        return false;
     }
 
-    // Преобразуем адрес в строковый ключ
-    const std::string key = addressToString(newSensor->getAddress());
+    lockRegistry();
+    const SensorList current = getAllSensors();
+    // Вставка с сохранением сортировки по SensorId
+    const auto it = lowerBound(*current, newSensor->getId());
 
     // Проверяем, что датчик с таким адресом еще не зарегистрирован
-    if (sensors.count(key)) {
-        ESP_LOGE(TAG, "Registration failed: Sensor with address %s already exists. Deleting new object.", key.c_str());
+    if (it != current->end() && (*it)->getId() == newSensor->getId()) {
+        unlockRegistry();
+        ESP_LOGE(TAG, "Registration failed: Sensor with address %s already exists. Deleting new object.", newSensor->getIdHex());
         delete newSensor; // Освобождаем память, так как дубликат не нужен
-        return;
+        return false;
     }
 
-    sensors[key] = newSensor;
+    // Новый снимок: прежний остается целым у тех, кто его сейчас обходит
+    auto updated = std::make_shared<std::vector<AbstractSensor*>>();
+    updated->reserve(current->size() + 1);
+    updated->insert(updated->end(), current->begin(), it);
+    updated->push_back(newSensor);
+    updated->insert(updated->end(), it, current->end());
+    const size_t total = updated->size();
+    // current удерживает прежний снимок, поэтому в критической секции память не освобождается
+    taskENTER_CRITICAL(&_snapshotMux);
+    _sensors = std::move(updated);
+    taskEXIT_CRITICAL(&_snapshotMux);
+    unlockRegistry();
     // Логируем тип датчика (используя getMeasurementType для информации)
     ESP_LOGV(TAG, "Registered sensor %s (Type: %d). Total sensors: %zu.",
-             key.c_str(), (int)newSensor->getMeasurementType(), sensors.size());
+             newSensor->getIdHex(), (int)newSensor->getMeasurementType(), total);
+    return true;
+}
+
+std::vector<AbstractSensor*>::const_iterator SensorManager::lowerBound(const std::vector<AbstractSensor*>& list,
+                                                                      const SensorId id) {
+    return std::lower_bound(list.begin(), list.end(), id,
+        [](const AbstractSensor* sensor, const SensorId key) { return sensor->getId() < key; });
 }
 
-const std::map<std::string, AbstractSensor*>& SensorManager::getAllSensors() const {
-    ESP_LOGV(TAG, "Retrieving all %zu registered sensors.", sensors.size());
-    return sensors;
+SensorList SensorManager::getAllSensors() const {
+    taskENTER_CRITICAL(&_snapshotMux);
+    SensorList snapshot = _sensors;
+    taskEXIT_CRITICAL(&_snapshotMux);
+    return snapshot;
+}
+
+AbstractSensor* SensorManager::getSensorById(const SensorId id) const {
+    // Объекты датчиков живут до cleanup(), поэтому указатель переживает снимок
+    const SensorList sensors = getAllSensors();
+    const auto it = lowerBound(*sensors, id);
+    if (it != sensors->end() && (*it)->getId() == id) {
+        return *it;
+    }
+    return nullptr;
 }
 
 AbstractSensor* SensorManager::getSensorByAddress(const AbstractSensor::Address& addr) const {
-    const std::string key = addressToString(addr);
-    if (sensors.count(key)) {
-        ESP_LOGV(TAG, "Found sensor by address %s.", key.c_str());
-        return sensors.at(key);
+    AbstractSensor* sensor = getSensorById(sensorIdFromAddress(addr));
+    if (sensor) {
+        ESP_LOGV(TAG, "Found sensor by address %s.", sensor->getIdHex());
+        return sensor;
     }
-    ESP_LOGW(TAG, "Sensor with address %s not found.", key.c_str());
+    ESP_LOGW(TAG, "Sensor with address %s not found.", addressToString(addr).c_str());
     return nullptr;
 }
 
 // возвращает количество зарегистрированных датчиков
 size_t SensorManager::getRegisteredSensorCount() const {
-    return sensors.size();
+    return getAllSensors()->size();
 }
 
 float SensorManager::getValueByAddress(const std::string& addressStr) const {
-    if (sensors.count(addressStr)) {
-        AbstractSensor* sensor = sensors.at(addressStr);
-        
+    SensorId id;
+    AbstractSensor* sensor = stringToId(addressStr, id) ? getSensorById(id) : nullptr;
+    if (sensor) {
         ESP_LOGV(TAG, "Requesting readValue() for sensor %s (Type: %d).",
                  addressStr.c_str(), (int)sensor->getMeasurementType());
         
@@ -91,112 +124,66 @@ float SensorManager::getValueByAddress(const std::string& addressStr) const {
     return SENSOR_ERROR_VALUE;
 }
 
-bool SensorManager::isSensorRegistered(const std::string& addressStr) const {
-    const bool exists = sensors.count(addressStr) > 0;
-    
-    ESP_LOGV(TAG, "Sensor registration check for %s: %s",
-             addressStr.c_str(), exists ? "True" : "False");
-
-    return exists;
+bool SensorManager::isSensorRegistered(const SensorId id) const {
+    return getSensorById(id) != nullptr;
 }
 
 bool SensorManager::assignZone(const AbstractSensor::Address& addr, SensorZone newZone) const {
-    // 1. Преобразуем адрес для логирования
-    const std::string addrStr = addressToString(addr);
-
-    // 2. Ищем датчик
+    // Ищем датчик
     AbstractSensor* sensor = getSensorByAddress(addr);
 
     if (sensor) {
         ESP_LOGV(TAG, "[ZONE_APPLY] Applying zone %d to sensor %s.",
-                 static_cast<int>(newZone), addrStr.c_str());
+                 static_cast<int>(newZone), sensor->getIdHex());
 
-        // 3. Устанавливаем зону
+        // Устанавливаем зону
         sensor->setZone(newZone);
         
         if (sensor->getZone() == newZone) {
             ESP_LOGV(TAG, "[ZONE_APPLY] Zone %d successfully VERIFIED on sensor %s.",
-                     static_cast<int>(newZone), addrStr.c_str());
+                     static_cast<int>(newZone), sensor->getIdHex());
         } else {
             ESP_LOGE(TAG, "[ZONE_APPLY] ZONE FAILED TO SET! Sensor %s still reports zone %d, expected %d.",
-                     addrStr.c_str(), static_cast<int>(sensor->getZone()), static_cast<int>(newZone));
+                     sensor->getIdHex(), static_cast<int>(sensor->getZone()), static_cast<int>(newZone));
         }
 
 
         return true;
     }
 
-    ESP_LOGW(TAG, "[ZONE_APPLY] Assign failed for sensor %s. Sensor object not found/registered.", addrStr.c_str());
+    ESP_LOGW(TAG, "[ZONE_APPLY] Assign failed for sensor %s. Sensor object not found/registered.", addressToString(addr).c_str());
     return false;
 }
 
-std::map<SensorZone, std::vector<AbstractSensor*>> SensorManager::getAllSensorsGroupedByZone() const {
-    ESP_LOGV(TAG, "Grouping all sensors by zone (No filter).");
-    std::map<SensorZone, std::vector<AbstractSensor*>> groupedSensors;
-    for (auto const& pair : sensors) {
-        groupedSensors[pair.second->getZone()].push_back(pair.second);
-    }
-    return groupedSensors;
-}
-
-
-// Новый метод с фильтрацией
-std::map<SensorZone, std::vector<AbstractSensor*>> SensorManager::getAllSensorsGroupedByZone(
-    const MeasuredValueType filterType) const
-{
-    ESP_LOGV(TAG, "Grouping sensors by zone with filter Type: %d.", (int)filterType);
-    std::map<SensorZone, std::vector<AbstractSensor*>> groupedSensors;
-    int filteredCount = 0;
-
-    for (auto const& pair : sensors) {
-        AbstractSensor* sensor = pair.second;
-
-        if (sensor->getMeasurementType() == filterType) {
-
-            // Если тип соответствует фильтру, группируем его по зоне
-            groupedSensors[sensor->getZone()].push_back(sensor);
-            filteredCount++;
-        }
-    }
-    ESP_LOGV(TAG, "Filtering complete. Found %d sensors matching filter Type: %d.", filteredCount, (int)filterType);
-    return groupedSensors;
+std::string SensorManager::addressToString(const AbstractSensor::Address& addr) {
+    char buffer[SENSOR_ID_HEX_LENGTH + 1];
+    sensorIdToHex(sensorIdFromAddress(addr), buffer);
+    return {buffer, SENSOR_ID_HEX_LENGTH};
 }
 
-std::string SensorManager::addressToString(const AbstractSensor::Address& addr) {
-    char buffer[17];
-    for (int i = 0; i < 8; i++) {
-        sprintf(&buffer[i * 2], "%02X", addr[i]);
+bool SensorManager::stringToAddress(const std::string& addrStr, AbstractSensor::Address& addr) {
+    SensorId id;
+    if (!stringToId(addrStr, id)) {
+        return false;
     }
-    return {buffer, 16};
+    sensorIdToAddress(id, addr);
+    return true;
 }
 
-bool SensorManager::stringToAddress(const std::string& addrStr, AbstractSensor::Address& addr) {
-    if (addrStr.length() != 16) {
+bool SensorManager::stringToId(const std::string& addrStr, SensorId& id) {
+    if (addrStr.length() != SENSOR_ID_HEX_LENGTH) {
         ESP_LOGE(TAG, "Address conversion failed: Length is %zu, expected 16.", addrStr.length());
         return false;
     }
-    for (int i = 0; i < 8; i++) {
-        char byteStr[3];
-        if (addrStr.copy(byteStr, 2, i * 2) != 2) return false;
-        byteStr[2] = '\0';
-
-        char* endptr;
-        const long val = strtol(byteStr, &endptr, 16);
-
-        if (*endptr != '\0' || val < 0 || val > 255) {
-             ESP_LOGE(TAG, "Address conversion failed: Invalid hex char in segment %d.", i);
-             return false;
-        }
-
-        addr[i] = static_cast<uint8_t>(val);
+    if (!sensorIdFromHex(addrStr.c_str(), addrStr.length(), id)) {
+        ESP_LOGE(TAG, "Address conversion failed: Invalid hex char in %s.", addrStr.c_str());
+        return false;
     }
-    ESP_LOGV(TAG, "Address %s converted successfully.", addrStr.c_str());
     return true;
 }
 
 void SensorManager::processReadingsAndPublish() const {
-    const auto groupedData = this->getAllSensorsGroupedByZone();
-    SensorDataService::getInstance()->updateSensorData(groupedData);
+    SensorDataService::getInstance()->updateSensorData(*getAllSensors());
     ESP_LOGV(TAG, "Sensor data gathered and published to SensorDataService.");
 }
 
@@ -208,12 +195,16 @@ SensorManager::~SensorManager() {
 
 void SensorManager::cleanup() {
     // Освобождение памяти, занятой объектами датчиков
-    const size_t count = sensors.size();
-    for (auto const& pair : sensors) {
+    const SensorList sensors = getAllSensors();
+    const size_t count = sensors->size();
+    for (AbstractSensor* sensor : *sensors) {
         // Логирование адреса удаляемого датчика
-        ESP_LOGV(TAG, "Deleting sensor object with address: %s", pair.first.c_str());
-        delete pair.second;
+        ESP_LOGV(TAG, "Deleting sensor object with address: %s", sensor->getIdHex());
+        delete sensor;
     }
-    sensors.clear();
+    SensorList empty = std::make_shared<const std::vector<AbstractSensor*>>();
+    taskENTER_CRITICAL(&_snapshotMux);
+    _sensors.swap(empty); // прежний снимок освобождается вне критической секции
+    taskEXIT_CRITICAL(&_snapshotMux);
     ESP_LOGW(TAG, "Cleanup complete. %zu sensor objects deleted.", count);
 }
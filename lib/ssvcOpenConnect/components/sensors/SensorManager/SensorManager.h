@@ -20,6 +20,7 @@
 
 #include <Arduino.h>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -28,6 +29,12 @@
 #include "components/sensors/AbstractSensor/AbstractSensor.h"
 #include "components/Zone/SensorZone.h"
 
+/**
+ * @brief Неизменяемый снимок реестра датчиков, отсортированный по SensorId.
+ * Держатель снимка может обходить его сколько угодно: регистрация создает новый снимок.
+ */
+typedef std::shared_ptr<const std::vector<AbstractSensor*>> SensorList;
+
 /**
  * @brief Абстрактный менеджер, не зависящий от конкретного типа датчиков.
  * Реализован как Одиночка (Singleton).
@@ -44,13 +51,20 @@ public:
     /**
      * @brief Регистрирует новый датчик в реестре.
      * @param newSensor Указатель на новый объект AbstractSensor*.
+     * @return false, если датчик с таким адресом уже зарегистрирован (объект удаляется).
      */
-    void registerSensor(AbstractSensor* newSensor);
+    bool registerSensor(AbstractSensor* newSensor);
 
     /**
-     * @brief Возвращает всех зарегистрированных датчиков (любого типа).
+     * @brief Возвращает всех зарегистрированных датчиков (любого типа),
+     * отсортированных по SensorId. Снимок безопасен при регистрации датчиков из задач шин.
      */
-    const std::map<std::string, AbstractSensor*>& getAllSensors() const;
+    SensorList getAllSensors() const;
+
+    /**
+     * @brief Ищет датчик по идентификатору (двоичный поиск, без выделения памяти).
+     */
+    AbstractSensor* getSensorById(SensorId id) const;
 
     /**
      * @brief Ищет датчик по его адресу (массив байт).
@@ -73,11 +87,11 @@ public:
     float getValueByAddress(const std::string& addressStr) const;
 
     /**
-     * @brief Проверяет, зарегистрирован ли датчик с данным строковым адресом.
-     * @param addressStr Строковый адрес датчика.
+     * @brief Проверяет, зарегистрирован ли датчик с данным идентификатором.
+     * @param id Идентификатор датчика.
      * @return True, если датчик зарегистрирован, false в противном случае.
      */
-    bool isSensorRegistered(const std::string& addressStr) const;
+    bool isSensorRegistered(SensorId id) const;
 
     // --- Metadata Management ---
 
@@ -86,40 +100,41 @@ public:
      */
     bool assignZone(const AbstractSensor::Address& addr, SensorZone newZone) const;
 
-    /**
-     * @brief Группирует все активные датчики по их SensorZone.
-     */
-    std::map<SensorZone, std::vector<AbstractSensor*>> getAllSensorsGroupedByZone() const;
-
-    /**
- * @brief Группирует все активные датчики по их SensorZone, применяя фильтр по типу измерения.
- * @param filterType Тип измерения, по которому нужно отфильтровать датчики.
- * @return Карта сгруппированных датчиков.
- */
-    std::map<SensorZone, std::vector<AbstractSensor*>> getAllSensorsGroupedByZone(
-        MeasuredValueType filterType) const;
-
-    // --- Static Helpers (для работы с 1-Wire адресами) ---
+    // --- Static Helpers (граница JSON: преобразование 1-Wire адресов и строк) ---
     static std::string addressToString(const AbstractSensor::Address& addr);
     static bool stringToAddress(const std::string& addrStr, AbstractSensor::Address& addr);
+    static bool stringToId(const std::string& addrStr, SensorId& id);
 
 
     /**
-     * @brief Выполняет считывание данных со всех зарегистрированных датчиков,
-     * группирует их по зонам и обновляет SensorDataService.
+     * @brief Передает показания всех зарегистрированных датчиков в SensorDataService.
      * Должен вызываться после того, как все подсистемы (Subsystems) завершили свои циклы.
      */
     void processReadingsAndPublish() const;
 
+    /**
+     * @brief Блокировка реестра. Регистрация датчиков (из задач подсистем) и обработка
+     * всего списка в конце цикла опроса выполняются под ней и не пересекаются.
+     */
+    void lockRegistry() const { xSemaphoreTake(_registryMutex, portMAX_DELAY); }
+    void unlockRegistry() const { xSemaphoreGive(_registryMutex); }
+
     // --- Lifecycle ---
     ~SensorManager();
 
 private:
     // Приватный конструктор для паттерна Одиночка
-    SensorManager() {}
+    SensorManager() : _sensors(std::make_shared<const std::vector<AbstractSensor*>>()),
+                      _registryMutex(xSemaphoreCreateMutex()) {}
+
+    // Основной реестр датчиков (владение указателями), отсортирован по SensorId.
+    // Копирование при записи: регистрация публикует новый вектор, читатели держат свой снимок.
+    // Указатель защищен _snapshotMux, а не _registryMutex: тот удерживается весь цикл опроса.
+    SensorList _sensors;
+    mutable portMUX_TYPE _snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+    SemaphoreHandle_t _registryMutex;
 
-    // Основной реестр датчиков (владение указателями)
-    std::map<std::string, AbstractSensor*> sensors;
+    static std::vector<AbstractSensor*>::const_iterator lowerBound(const std::vector<AbstractSensor*>& list, SensorId id);
 
     // Вспомогательная функция для освобождения памяти
     void cleanup();
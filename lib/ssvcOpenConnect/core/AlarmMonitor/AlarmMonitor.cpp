@@ -3,6 +3,10 @@
 //
 
 #include "AlarmMonitor.h"
+#include <esp_timer.h>
+#include <cmath>
+#include <cstring>
+#include "core/rectification/RectificationProcess.h"
 
 AlarmMonitor& AlarmMonitor::getInstance() {
     ESP_LOGV(TAG, "Singleton instance retrieved.");
@@ -10,9 +14,21 @@ AlarmMonitor& AlarmMonitor::getInstance() {
     return instance;
 }
 
-void AlarmMonitor::initialize(AlarmThresholdService* service) {
+void AlarmMonitor::initialize(AlarmThresholdService* service, AlarmRulesService* rulesService) {
     _thresholdService = service;
-    _last_alarm_states.clear();
+    _rulesService = rulesService;
+    rebuildTable(true);
+    rebuildRules();
+
+    if (_dispatchQueue == nullptr) {
+        _dispatchQueue = xQueueCreate(DISPATCH_QUEUE_LENGTH, sizeof(QueuedAlarm));
+        // Приоритет не выше задач шин 1-Wire: рассылка не вытесняет опрос
+        xTaskCreatePinnedToCore(dispatchTask, "AlarmDispatch", DISPATCH_TASK_STACK_SIZE, this,
+                                DISPATCH_TASK_PRIORITY, &_dispatchTaskHandle, APP_CPU_NUM);
+        if (_dispatchTaskHandle == nullptr) {
+            ESP_LOGE(TAG, "Failed to create alarm dispatch task.");
+        }
+    }
     if (_thresholdService) {
         // Лямбда-функция для передачи в addUpdateHandler
         auto update_cb = [this](const String& originId) {
@@ -23,6 +39,11 @@ void AlarmMonitor::initialize(AlarmThresholdService* service) {
 
         ESP_LOGI(TAG, "AlarmMonitor subscribed to Threshold Service updates (ID: %zu).", _updateHandlerId);
     }
+    if (_rulesService) {
+        _rulesHandlerId = _rulesService->addUpdateHandler([this](const String& originId) {
+            this->onRulesUpdated(originId);
+        }, false);
+    }
 
     ESP_LOGI(TAG, "AlarmMonitor initialized with threshold service.");
 }
@@ -33,34 +54,78 @@ void AlarmMonitor::subscribe(IAlarmSubscriber* subscriber) {
         return;
     }
 
+    const bool is_sync = subscriber->getDelivery() == AlarmDelivery::SYNC;
+    std::vector<IAlarmSubscriber*>& list = is_sync ? _syncSubscribers : _asyncSubscribers;
+    const SemaphoreHandle_t lock = is_sync ? _mutex : _asyncMutex;
+
+    if (is_sync) {
+        xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+    } else {
+        xSemaphoreTake(lock, portMAX_DELAY);
+    }
+
     // Проверяем, не подписан ли уже
-    const bool already_subscribed = std::find(_subscribers.begin(), _subscribers.end(), subscriber) != _subscribers.end();
+    const bool already_subscribed = std::find(list.begin(), list.end(), subscriber) != list.end();
+    if (!already_subscribed) {
+        insertByPriority(list, subscriber);
+    }
+    const size_t total = list.size();
+
+    if (is_sync) {
+        xSemaphoreGiveRecursive(lock);
+    } else {
+        xSemaphoreGive(lock);
+    }
 
     if (!already_subscribed) {
-        _subscribers.push_back(subscriber);
         // Логируем успешную подписку и общее количество
-        ESP_LOGI(TAG, "Subscriber 0x%p successfully added. Total subscribers: %zu.",
-                 static_cast<void*>(subscriber), _subscribers.size());
+        ESP_LOGI(TAG, "Subscriber 0x%p successfully added (%s, priority %u). Total %s subscribers: %zu.",
+                 static_cast<void*>(subscriber), is_sync ? "sync" : "async",
+                 subscriber->getDeliveryPriority(), is_sync ? "sync" : "async", total);
     } else {
         ESP_LOGD(TAG, "Subscriber 0x%p is already subscribed. Skipping.", static_cast<void*>(subscriber));
     }
 }
 
+void AlarmMonitor::insertByPriority(std::vector<IAlarmSubscriber*>& list, IAlarmSubscriber* subscriber) {
+    // После всех с тем же приоритетом: при равенстве сохраняется порядок подписки
+    const auto it = std::upper_bound(list.begin(), list.end(), subscriber,
+        [](const IAlarmSubscriber* a, const IAlarmSubscriber* b) {
+            return a->getDeliveryPriority() < b->getDeliveryPriority();
+        });
+    list.insert(it, subscriber);
+}
+
 // Файл: AlarmMonitor.cpp
 
 // Добавьте этот метод, который будет вызываться при изменении настроек
 void AlarmMonitor::onThresholdsUpdated(const String& originId) {
     ESP_LOGI(TAG, "Threshold settings changed (Origin: %s). Re-checking all sensors immediately.", originId.c_str());
+    resetAndRecheck();
+}
+
+void AlarmMonitor::onRulesUpdated(const String& originId) {
+    ESP_LOGI(TAG, "Alarm rules changed (Origin: %s). Re-checking immediately.", originId.c_str());
+    resetAndRecheck();
+}
 
-    for (IAlarmSubscriber* subscriber : _subscribers) {
+void AlarmMonitor::resetAndRecheck() {
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    for (IAlarmSubscriber* subscriber : _syncSubscribers) {
         subscriber->forceResetAlarm(); // <-- ВЫЗЫВАЕМ НОВЫЙ МЕТОД
     }
-    // Обнуляем предыдущие состояния, чтобы гарантировать, что НОВЫЙ уровень сработает
-    // даже если он совпадает со старым, но был пропущен из-за таймаута.
-    // Если этого не сделать, в _last_alarm_states могут остаться старые уровни,
+    xSemaphoreGiveRecursive(_mutex);
+    // Асинхронные подписчики получают сброс через очередь, после уже поставленных событий
+    enqueue({AlarmEvent{}, esp_timer_get_time(), true});
+
+    // Пересобираем таблицу с обнулением состояний, чтобы гарантировать, что НОВЫЙ уровень
+    // сработает даже если он совпадает со старым, но был пропущен из-за таймаута.
+    // Если этого не сделать, в таблице могут остаться старые уровни,
     // и новый уровень (например, CRITICAL) не сработает, если он уже был CRITICAL
     // до изменения порогов.
-    _last_alarm_states.clear();
+    rebuildTable(true);
+    // Подписчики сброшены целиком - активные правила тоже должны сработать заново
+    rebuildRules();
 
     // Принудительно запускаем проверку
     checkAllSensors();
@@ -73,168 +138,385 @@ void AlarmMonitor::unsubscribe(IAlarmSubscriber* subscriber) {
         return;
     }
 
-    const size_t old_size = _subscribers.size();
     // Используем erase-remove idiom для удаления указателя из вектора
-    _subscribers.erase(
-        std::remove(_subscribers.begin(), _subscribers.end(), subscriber),
-        _subscribers.end()
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    const size_t old_sync = _syncSubscribers.size();
+    _syncSubscribers.erase(
+        std::remove(_syncSubscribers.begin(), _syncSubscribers.end(), subscriber),
+        _syncSubscribers.end()
     );
+    const bool removed_sync = _syncSubscribers.size() < old_sync;
+    xSemaphoreGiveRecursive(_mutex);
+
+    // Под _asyncMutex: после возврата задача рассылки гарантированно не обращается к подписчику
+    xSemaphoreTake(_asyncMutex, portMAX_DELAY);
+    const size_t old_async = _asyncSubscribers.size();
+    _asyncSubscribers.erase(
+        std::remove(_asyncSubscribers.begin(), _asyncSubscribers.end(), subscriber),
+        _asyncSubscribers.end()
+    );
+    const bool removed_async = _asyncSubscribers.size() < old_async;
+    xSemaphoreGive(_asyncMutex);
 
     // Логируем результат отписки
-    if (_subscribers.size() < old_size) {
-        ESP_LOGI(TAG, "Subscriber 0x%p successfully removed. Total subscribers: %zu.",
-                 static_cast<void*>(subscriber), _subscribers.size());
+    if (removed_sync || removed_async) {
+        ESP_LOGI(TAG, "Subscriber 0x%p successfully removed.", static_cast<void*>(subscriber));
     } else {
         ESP_LOGD(TAG, "Subscriber 0x%p was not found in the list.", static_cast<void*>(subscriber));
     }
 }
 
 
-void AlarmMonitor::notifySubscribers(const AlarmEvent& event) const
+void AlarmMonitor::notifySubscribers(const AlarmEvent& event)
 {
     // Информационный лог о событии тревоги перед рассылкой
-    ESP_LOGW(TAG, "--- ALARM EVENT TRIGGERED --- Address: %s, Value: %.2f, Level: %d. Notifying %zu subscribers.",
-             SensorManager::addressToString(event.sensor->getAddress()).c_str(),
+    ESP_LOGW(TAG, "--- ALARM EVENT TRIGGERED --- %s: %s, Value: %.2f, Level: %d. Notifying %zu sync subscribers, queueing for async.",
+             event.sensor ? "Address" : "Rule",
+             event.sensor ? event.sensor->getIdHex() : event.rule_name,
              event.current_value,
              static_cast<int>(event.level),
-             _subscribers.size());
-
-    // Итерируемся по всем подписчикам и вызываем их метод onAlarmEvent
-    for (IAlarmSubscriber* subscriber : _subscribers) {
-        if (subscriber) {
-            // Подробный лог о рассылке каждому подписчику
-            ESP_LOGV(TAG, "Notifying subscriber 0x%p about event for sensor %s.",
-                     (void*)subscriber, SensorManager::addressToString(event.sensor->getAddress()).c_str());
-            subscriber->onAlarm(event);
+             _syncSubscribers.size());
+
+    // Синхронные подписчики (GPIO и т.п.) - прямо здесь, с минимальной задержкой
+    for (IAlarmSubscriber* subscriber : _syncSubscribers) {
+        subscriber->onAlarm(event);
+    }
+
+    enqueue({event, esp_timer_get_time(), false});
+}
+
+void AlarmMonitor::enqueue(const QueuedAlarm& item) {
+    // Без ожидания: цикл опроса не должен зависеть от скорости асинхронных подписчиков
+    const bool sent = _dispatchQueue != nullptr && xQueueSend(_dispatchQueue, &item, 0) == pdTRUE;
+    const auto depth = static_cast<uint16_t>(_dispatchQueue ? uxQueueMessagesWaiting(_dispatchQueue) : 0);
+
+    taskENTER_CRITICAL(&_statsMux);
+    if (sent) {
+        _dispatchStats.queued++;
+        if (depth > _dispatchStats.maxDepth) {
+            _dispatchStats.maxDepth = depth;
         }
+    } else {
+        _dispatchStats.dropped++;
+    }
+    taskEXIT_CRITICAL(&_statsMux);
+
+    if (!sent && _dispatchQueue != nullptr) {
+        ESP_LOGE(TAG, "Alarm dispatch queue is full. Event dropped for async subscribers.");
     }
 }
 
-void AlarmMonitor::checkAllSensors() {
-    if (!_thresholdService) {
-        ESP_LOGE(TAG, "Cannot check sensors: Threshold Service is NULL.");
+void AlarmMonitor::dispatchTask(void* param) {
+    auto* self = static_cast<AlarmMonitor*>(param);
+    QueuedAlarm item;
+    while (true) {
+        if (xQueueReceive(self->_dispatchQueue, &item, portMAX_DELAY) == pdTRUE) {
+            self->deliver(item);
+        }
+    }
+}
+
+void AlarmMonitor::deliver(const QueuedAlarm& item) {
+    xSemaphoreTake(_asyncMutex, portMAX_DELAY);
+    for (IAlarmSubscriber* subscriber : _asyncSubscribers) {
+        if (item.reset) {
+            subscriber->forceResetAlarm();
+        } else {
+            subscriber->onAlarm(item.event);
+        }
+    }
+    xSemaphoreGive(_asyncMutex);
+
+    if (item.reset) {
         return;
     }
+    const auto latency = static_cast<uint32_t>(esp_timer_get_time() - item.enqueuedUs);
+    taskENTER_CRITICAL(&_statsMux);
+    _dispatchStats.delivered++;
+    _dispatchStats.lastLatencyUs = latency;
+    if (latency > _dispatchStats.maxLatencyUs) {
+        _dispatchStats.maxLatencyUs = latency;
+    }
+    taskEXIT_CRITICAL(&_statsMux);
+}
 
-    // Подробный лог о начале цикла проверки
-    ESP_LOGI(TAG, "Starting sensor check cycle.");
+AlarmDispatchStats AlarmMonitor::getDispatchStats() const {
+    taskENTER_CRITICAL(&_statsMux);
+    AlarmDispatchStats stats = _dispatchStats;
+    taskEXIT_CRITICAL(&_statsMux);
+    stats.depth = static_cast<uint16_t>(_dispatchQueue ? uxQueueMessagesWaiting(_dispatchQueue) : 0);
+    return stats;
+}
 
-    // 1. Получаем доступ к текущим настройкам порогов
-    _thresholdService->read([&](const AlarmThresholdsState& thresholdsState) {
+void AlarmMonitor::rebuildTable(const bool resetStates) {
+    if (!_thresholdService) {
+        return;
+    }
 
-        // 2. Получаем все датчики
-        const SensorManager& sm = SensorManager::getInstance();
-        const auto& all_sensors = sm.getAllSensors();
-        ESP_LOGI(TAG, "Processing %zu sensors.", all_sensors.size());
+    const SensorManager& sm = SensorManager::getInstance();
+    const SensorList all_sensors = sm.getAllSensors();
 
-        for (const auto& pair : all_sensors) {
-            const std::string& addr_str = pair.first;
-            AbstractSensor* sensor = pair.second;
+    std::vector<CompiledAlarm> table;
+    table.reserve(all_sensors->size());
 
-            // 3. Проверяем, есть ли для этого датчика настройки
-            if (thresholdsState.sensor_thresholds.count(addr_str) == 0) {
-                ESP_LOGI(TAG, "Sensor %s skipped: No threshold settings found.", addr_str.c_str());
-                continue; // Настроек нет, пропускаем
+    _thresholdService->read([&](const AlarmThresholdsState& thresholdsState) {
+        for (AbstractSensor* sensor : *all_sensors) {
+            const auto settings_it = thresholdsState.sensor_thresholds.find(sensor->getId());
+            // Датчики без настроек и с выключенным мониторингом в таблицу не попадают
+            if (settings_it == thresholdsState.sensor_thresholds.end() || !settings_it->second.enabled) {
+                continue;
             }
+            const ThresholdSettings& settings = settings_it->second;
+
+            CompiledAlarm entry;
+            entry.sensor = sensor;
+            entry.id = sensor->getId();
+            entry.thresholds[static_cast<int>(AlarmLevel::MIN)] = settings.min_threshold;
+            entry.thresholds[static_cast<int>(AlarmLevel::DANGEROUS)] = settings.dangerous_threshold;
+            entry.thresholds[static_cast<int>(AlarmLevel::CRITICAL)] = settings.critical_threshold;
+            entry.hysteresis = settings.hysteresis;
+            entry.maxRate = settings.max_rate;
+            entry.debounce = settings.debounce;
+            table.push_back(entry);
+        }
+    });
 
-            const ThresholdSettings& settings = thresholdsState.sensor_thresholds.at(addr_str);
-            if (!settings.enabled) {
-                ESP_LOGI(TAG, "Sensor %s skipped: Monitoring is disabled.", addr_str.c_str());
-                continue; // Мониторинг для датчика выключен
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    if (!resetStates) {
+        // Обе таблицы отсортированы по SensorId - переносим состояние одним проходом
+        auto old_it = _table.cbegin();
+        for (CompiledAlarm& entry : table) {
+            while (old_it != _table.cend() && old_it->id < entry.id) {
+                ++old_it;
             }
-            // Подробный лог с настройками
-            ESP_LOGI(TAG, "Sensor %s: Thresh (Crit:%.2f, Dang:%.2f, Min:%.2f).",
-                     addr_str.c_str(), settings.critical_threshold, settings.dangerous_threshold, settings.min_threshold);
-            // 4. Сравнение
-            const float current_value = sensor->getData();
-
-
-            // 4.1. Проверка валидности данных
-         if (!sensor->isDataValid()) {
-
-             // Защита от ложной тревоги на старте:
-             // Если датчика еще нет в списке _last_alarm_states, это первый цикл.
-             const bool is_first_check = (_last_alarm_states.count(addr_str) == 0);
-
-             if (is_first_check) {
-                 // Инициализируем состояние как NORMAL, но не генерируем событие.
-                 _last_alarm_states[addr_str] = AlarmLevel::NORMAL;
-                 ESP_LOGI(TAG, "Sensor %s is in initial state (non-valid data). Skipping alarm check.", addr_str.c_str());
-                 return; // Пропускаем, чтобы избежать ложной тревоги MINIMUM
-             }
-
-             // Если код дошел сюда, это СБОЙ ВО ВРЕМЯ РАБОТЫ.
-             auto new_level = AlarmLevel::CRITICAL;
-             const AlarmLevel last_level = _last_alarm_states.count(addr_str) ?
-                              _last_alarm_states.at(addr_str) :
-                              AlarmLevel::NORMAL;
-
-             if (new_level != last_level) {
-                 ESP_LOGE(TAG, "SENSOR FAILURE DETECTED! Sensor %s transition: %d -> %d. Value: %.2f (Non-valid data)",
-                          addr_str.c_str(), static_cast<int>(last_level), static_cast<int>(new_level), current_value);
-
-                 _last_alarm_states[addr_str] = new_level;
-
-                 const AlarmEvent event = {
-                     sensor,
-                     current_value,
-                     FAILURE_THRESHOLD_VALUE, // <-- Используем символическое значение
-                     new_level,
-                     time(nullptr)
-                 };
-                 notifySubscribers(event);
-             }
-             continue; // Завершаем обработку
-         }
-
-            auto new_level = AlarmLevel::NORMAL;
-            float threshold_crossed = 0.0f;
-
-            // Логируем текущее значение
-            ESP_LOGI(TAG, "Sensor %s read value: %.2f.", addr_str.c_str(), current_value);
-
-            // --- Логика определения уровня тревоги ---
-            if (current_value >= settings.critical_threshold) {
-                new_level = AlarmLevel::CRITICAL;
-                threshold_crossed = settings.critical_threshold;
-            } else if (current_value >= settings.dangerous_threshold) {
-                new_level = AlarmLevel::DANGEROUS;
-                threshold_crossed = settings.dangerous_threshold;
-            } else if (current_value <= settings.min_threshold) {
-                new_level = AlarmLevel::MIN;
-                threshold_crossed = settings.min_threshold;
+            if (old_it != _table.cend() && old_it->id == entry.id) {
+                entry.level = old_it->level;
+                entry.candidate = old_it->candidate;
+                entry.cause = old_it->cause;
+                entry.candidateCause = old_it->candidateCause;
+                entry.candidateCount = old_it->candidateCount;
+                entry.primed = old_it->primed;
             }
-            // ----------------------------------------
-
-            // 5. Проверяем, изменился ли статус тревоги
-            const AlarmLevel last_level = _last_alarm_states.count(addr_str) ?
-                                          _last_alarm_states.at(addr_str) :
-                                          AlarmLevel::NORMAL; // Предполагаем NORMAL, если не было предыдущего состояния
-
-            // Логируем переход состояния
-            if (new_level != last_level) {
-                ESP_LOGI(TAG, "STATUS CHANGE! Sensor %s transition: %d -> %d. Value: %.2f (Crossed: %.2f)",
-                         addr_str.c_str(), static_cast<int>(last_level), static_cast<int>(new_level), current_value, threshold_crossed);
-
-                _last_alarm_states[addr_str] = new_level; // Обновляем состояние
-
-                // Генерируем событие и уведомляем подписчиков
-                AlarmEvent event = {
-                    sensor,
-                    current_value,
-                    threshold_crossed,
-                    new_level,
-                    time(nullptr)
-                };
-                notifySubscribers(event);
-
-            } else {
-                // Подробный лог, если состояние не изменилось
-                ESP_LOGI(TAG, "Sensor %s: State remains %d (Value: %.2f). No notification sent.",
-                         addr_str.c_str(), static_cast<int>(new_level), current_value);
+        }
+    }
+    _table.swap(table);
+    _compiledSensorCount = all_sensors->size();
+    const size_t monitored = _table.size();
+    xSemaphoreGiveRecursive(_mutex);
+
+    ESP_LOGI(TAG, "Alarm table compiled: %zu of %zu sensors monitored%s.",
+             monitored, all_sensors->size(), resetStates ? " (states reset)" : "");
+}
+
+void AlarmMonitor::rebuildRules() {
+    std::vector<CompiledRule> rules;
+    if (_rulesService) {
+        _rulesService->read([&](const AlarmRulesState& state) {
+            rules.reserve(state.rules.size());
+            for (size_t i = 0; i < state.rules.size(); i++) {
+                const AlarmRule& rule = state.rules[i];
+                if (!rule.isActive()) {
+                    continue;
+                }
+                CompiledRule compiled;
+                compiled.program = rule.program;
+                compiled.alarmLevel = rule.level;
+                compiled.debounce = rule.debounce;
+                compiled.index = static_cast<uint8_t>(i);
+                strncpy(compiled.name, rule.name.c_str(), sizeof(compiled.name) - 1);
+                rules.push_back(compiled);
             }
+        });
+    }
+
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    _rules.swap(rules);
+    const size_t active = _rules.size();
+    xSemaphoreGiveRecursive(_mutex);
+
+    if (_rulesService) {
+        ESP_LOGI(TAG, "Alarm rules compiled: %zu active.", active);
+    }
+}
+
+AlarmLevel AlarmMonitor::classify(const CompiledAlarm& entry, const float value) {
+    constexpr int LEVEL_MIN = static_cast<int>(AlarmLevel::MIN);
+    constexpr int LEVEL_DANGEROUS = static_cast<int>(AlarmLevel::DANGEROUS);
+    constexpr int LEVEL_CRITICAL = static_cast<int>(AlarmLevel::CRITICAL);
+
+    // Пороги сдвигаются на полосу гистерезиса в сторону уже подтвержденного уровня:
+    // чтобы уйти из CRITICAL, значение должно опуститься ниже critical - hysteresis и т.д.
+    const int current = static_cast<int>(entry.level);
+    const float h = entry.hysteresis;
+    const bool critical = value >= entry.thresholds[LEVEL_CRITICAL] - (current >= LEVEL_CRITICAL ? h : 0.0f);
+    const bool dangerous = value >= entry.thresholds[LEVEL_DANGEROUS] - (current >= LEVEL_DANGEROUS ? h : 0.0f);
+    const bool low = value <= entry.thresholds[LEVEL_MIN] + (current == LEVEL_MIN ? h : 0.0f);
+
+    return static_cast<AlarmLevel>(critical ? LEVEL_CRITICAL : dangerous ? LEVEL_DANGEROUS : (low ? LEVEL_MIN : 0));
+}
+
+bool AlarmMonitor::isRateExceeded(const CompiledAlarm& entry, float& slopePerMin) {
+    // Наклон МНК история ведет скользящими суммами - здесь только O(1) копия статистики
+    const SensorTrend trend = entry.sensor->getHistory().getTrend();
+    slopePerMin = trend.slopePerMin;
+    if (trend.windowMs < RATE_MIN_WINDOW_MS) {
+        return false;
+    }
+
+    const bool active = entry.cause == AlarmCause::RATE_OF_CHANGE && entry.level != AlarmLevel::NORMAL;
+    return slopePerMin >= entry.maxRate * (active ? 1.0f - RATE_HYSTERESIS_RATIO : 1.0f);
+}
+
+bool AlarmMonitor::debounce(DebounceState& entry, const AlarmLevel observed, const AlarmCause cause) {
+    if (observed == entry.level) {
+        // Уровень тот же - событие не нужно, но причина могла смениться (например, порог
+        // пересечен уже после тревоги по скорости), от нее зависит гистерезис скорости
+        entry.cause = cause;
+        entry.candidateCount = 0;
+        return false;
+    }
+    if (observed != entry.candidate || cause != entry.candidateCause) {
+        entry.candidate = observed;
+        entry.candidateCause = cause;
+        entry.candidateCount = 0;
+    }
+    if (++entry.candidateCount < entry.debounce) {
+        return false;
+    }
+    entry.level = observed;
+    entry.cause = cause;
+    entry.candidateCount = 0;
+    return true;
+}
+
+void AlarmMonitor::checkAllSensors() {
+    if (!_thresholdService) {
+        ESP_LOGE(TAG, "Cannot check sensors: Threshold Service is NULL.");
+        return;
+    }
+
+    // Появились новые датчики - пересобираем таблицу, сохраняя состояние уже известных
+    if (SensorManager::getInstance().getRegisteredSensorCount() != _compiledSensorCount) {
+        rebuildTable(false);
+    }
+
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    for (CompiledAlarm& entry : _table) {
+        const float current_value = entry.sensor->getData();
+        const bool valid = entry.sensor->isDataValid();
+
+        // Защита от ложной тревоги на старте: первый отсчет без валидных данных
+        // после сборки таблицы только отмечает датчик, но не идет в антидребезг.
+        const bool skip = !valid && !entry.primed;
+        entry.primed = true;
+        if (skip) {
+            continue;
         }
-    });
 
-    ESP_LOGD(TAG, "Sensor check cycle finished.");
-}
\ No newline at end of file
+        // Сбой чтения во время работы приравнивается к CRITICAL
+        AlarmLevel observed = AlarmLevel::CRITICAL;
+        AlarmCause cause = AlarmCause::SENSOR_FAILURE;
+        float slopePerMin = 0.0f;
+        if (valid) {
+            observed = classify(entry, current_value);
+            cause = AlarmCause::THRESHOLD;
+            // Быстрый рост поднимает DANGEROUS, пока абсолютные пороги еще не достигнуты
+            if (entry.maxRate > 0.0f && observed < AlarmLevel::DANGEROUS && isRateExceeded(entry, slopePerMin)) {
+                observed = AlarmLevel::DANGEROUS;
+                cause = AlarmCause::RATE_OF_CHANGE;
+            }
+        }
+        if (!debounce(entry, observed, cause)) {
+            continue;
+        }
+
+        AlarmEvent event = {
+            entry.sensor,
+            current_value,
+            entry.thresholds[static_cast<int>(entry.level)],
+            entry.level,
+            time(nullptr),
+            cause
+        };
+        if (cause == AlarmCause::SENSOR_FAILURE) {
+            event.threshold_value = FAILURE_THRESHOLD_VALUE; // <-- Используем символическое значение
+        } else if (cause == AlarmCause::RATE_OF_CHANGE) {
+            event.current_value = slopePerMin;
+            event.threshold_value = entry.maxRate;
+        }
+        notifySubscribers(event);
+    }
+
+    evaluateRules();
+    xSemaphoreGiveRecursive(_mutex);
+}
+
+void AlarmMonitor::fillRuleContext(RuleContext& context) {
+    // Снимок берется до отметки времени: иначе свежий снимок мог бы оказаться "из будущего"
+    const RectificationProcess::TelemetrySnapshot telemetry =
+        RectificationProcess::rectController().getTelemetrySnapshot();
+    for (float& value : context.vars) {
+        value = NAN;
+    }
+    context.nowMs = millis();
+
+    // Зона - максимум валидных показаний ее датчиков (fmax пропускает NaN)
+    const SensorList registered = SensorManager::getInstance().getAllSensors();
+    for (const AbstractSensor* sensor : *registered) {
+        if (!sensor->isDataValid()) {
+            continue;
+        }
+        RuleVar var;
+        switch (sensor->getZone()) {
+        case SensorZone::INLET_WATER: var = RuleVar::INLET_WATER; break;
+        case SensorZone::OUTLET_WATER: var = RuleVar::OUTLET_WATER; break;
+        case SensorZone::ACT: var = RuleVar::ACT; break;
+        default: continue;
+        }
+        float& slot = context.vars[static_cast<size_t>(var)];
+        slot = std::fmax(slot, sensor->getData());
+    }
+
+    if (telemetry.updatedMs == 0 || context.nowMs - telemetry.updatedMs > TELEMETRY_STALE_MS) {
+        return; // Контроллер молчит: правила по телеметрии не срабатывают
+    }
+    context.vars[static_cast<size_t>(RuleVar::TP1)] = telemetry.tp1;
+    context.vars[static_cast<size_t>(RuleVar::TP2)] = telemetry.tp2;
+    context.vars[static_cast<size_t>(RuleVar::TP1_TARGET)] = telemetry.tp1_target;
+    context.vars[static_cast<size_t>(RuleVar::TP2_TARGET)] = telemetry.tp2_target;
+    context.vars[static_cast<size_t>(RuleVar::MMHG)] = telemetry.mmhg;
+    context.vars[static_cast<size_t>(RuleVar::RELAY)] = telemetry.relay;
+    context.vars[static_cast<size_t>(RuleVar::SIGNAL)] = telemetry.signal;
+    context.vars[static_cast<size_t>(RuleVar::OPEN)] = telemetry.open;
+    context.vars[static_cast<size_t>(RuleVar::ALC)] = telemetry.alc;
+    context.vars[static_cast<size_t>(RuleVar::STAGE)] = static_cast<float>(telemetry.stage);
+}
+
+void AlarmMonitor::evaluateRules() {
+    if (_rules.empty()) {
+        return;
+    }
+
+    RuleContext context;
+    fillRuleContext(context);
+
+    for (CompiledRule& rule : _rules) {
+        const float result = rule.program.evaluate(context, rule.rateSlots);
+        const AlarmLevel observed = AlarmRuleProgram::isTrue(result) ? rule.alarmLevel : AlarmLevel::NORMAL;
+        if (!debounce(rule, observed, AlarmCause::RULE)) {
+            continue;
+        }
+
+        AlarmEvent event = {
+            nullptr,
+            result,
+            0.0f,
+            rule.level,
+            time(nullptr),
+            AlarmCause::RULE,
+            rule.index
+        };
+        strncpy(event.rule_name, rule.name, sizeof(event.rule_name) - 1);
+        notifySubscribers(event);
+    }
+}
@@ -9,43 +9,156 @@
 #include <memory>
 #include <algorithm>
 #include <Arduino.h>
+#include <freertos/queue.h>
 #include "core/IAlarmSubscriber/IAlarmSubscriber.h"
 #include "core/StatefulServices/AlarmThresholdService/AlarmThresholdService.h"
+#include "core/StatefulServices/AlarmRulesService/AlarmRulesService.h"
 #include "components/sensors/SensorManager/SensorManager.h"
 
+// Статистика асинхронной рассылки тревог
+struct AlarmDispatchStats {
+    uint32_t queued = 0;        // Событий поставлено в очередь
+    uint32_t delivered = 0;     // Событий разослано асинхронным подписчикам
+    uint32_t dropped = 0;       // Событий потеряно: очередь была заполнена
+    uint16_t depth = 0;         // Событий в очереди сейчас
+    uint16_t maxDepth = 0;      // Максимальная глубина очереди
+    uint32_t lastLatencyUs = 0; // От постановки в очередь до доставки последнему подписчику
+    uint32_t maxLatencyUs = 0;
+};
 
 class AlarmMonitor {
 public:
     static AlarmMonitor& getInstance();
 
-    // Метод для инициализации монитора
-    void initialize(AlarmThresholdService* service);
+    // Метод для инициализации монитора. rulesService может отсутствовать - тогда проверяются только пороги
+    void initialize(AlarmThresholdService* service, AlarmRulesService* rulesService = nullptr);
 
-    // Подписка/отписка
+    // Подписка/отписка. Подписчики упорядочиваются по getDeliveryPriority().
+    // Отписка асинхронного подписчика ждет окончания текущей рассылки.
     void subscribe(IAlarmSubscriber* subscriber);
     void unsubscribe(IAlarmSubscriber* subscriber);
 
-    // Главный метод, который будет вызываться после опроса датчиков
+    AlarmDispatchStats getDispatchStats() const;
+
+    static constexpr size_t DISPATCH_QUEUE_LENGTH = 16;
+
+    // Главный метод, который будет вызываться после опроса датчиков.
+    // Проходит по скомпилированной таблице: без поиска в картах, без выделения памяти
+    // и без логов, пока уровень ни одного датчика не меняется. Затем вычисляет правила.
     void checkAllSensors();
 
     void onThresholdsUpdated(const String& originId);
+    void onRulesUpdated(const String& originId);
 
 private:
-    AlarmMonitor() {} // Приватный конструктор
+    AlarmMonitor() : _mutex(xSemaphoreCreateRecursiveMutex()), _asyncMutex(xSemaphoreCreateMutex()) {} // Приватный конструктор
+
+    // Автомат антидребезга, общий для датчиков и правил
+    struct DebounceState {
+        uint8_t debounce = 1;
+
+        AlarmLevel level = AlarmLevel::NORMAL;     // Подтвержденный (последний разосланный) уровень
+        AlarmCause cause = AlarmCause::THRESHOLD;  // Причина подтвержденного уровня
+        AlarmLevel candidate = AlarmLevel::NORMAL; // Уровень, набирающий подтверждения
+        AlarmCause candidateCause = AlarmCause::THRESHOLD;
+        uint8_t candidateCount = 0;
+    };
+
+    // Скомпилированная запись таблицы тревог: пороги одного датчика и состояние его автомата.
+    // Таблица пересобирается только при изменении порогов или состава датчиков.
+    struct CompiledAlarm : DebounceState {
+        AbstractSensor* sensor = nullptr;
+        SensorId id = 0;
+        // Порог по индексу уровня: [MIN], [DANGEROUS], [CRITICAL]; [NORMAL] не используется
+        float thresholds[4] = {};
+        float hysteresis = 0.0f;
+        float maxRate = 0.0f;                      // °C/мин, 0 - скорость не контролируется
+        bool primed = false;                       // Был хотя бы один отсчет после сборки таблицы
+    };
+
+    // Включенное правило без ошибок компиляции: копия программы и состояние ее rate()
+    struct CompiledRule : DebounceState {
+        AlarmRuleProgram program;
+        RuleRateSlot rateSlots[AlarmRuleProgram::MAX_RATE_SLOTS];
+        AlarmLevel alarmLevel = AlarmLevel::DANGEROUS; // Уровень, на который переходит сработавшее правило
+        uint8_t index = 0;                             // Номер в списке AlarmRulesService
+        char name[ALARM_RULE_NAME_LENGTH] = {};
+    };
+
+    // Пересобирает таблицу из настроек порогов и реестра датчиков.
+    // resetStates = false переносит уровни датчиков из старой таблицы.
+    void rebuildTable(bool resetStates);
+
+    // Пересобирает правила из AlarmRulesService; состояния правил всегда сбрасываются
+    void rebuildRules();
+
+    // Сбрасывает все тревоги у подписчиков и состояния автоматов, затем сразу перепроверяет
+    void resetAndRecheck();
+
+    // Собирает значения переменных правил: зоны из реестра датчиков, телеметрию из RectificationProcess
+    static void fillRuleContext(RuleContext& context);
 
-    // Внутреннее состояние каждого датчика, чтобы избежать "дребезга" уведомлений
-    std::map<std::string, AlarmLevel> _last_alarm_states;
+    // Вычисляет правила и рассылает подтвержденные переходы. Вызывается под _mutex.
+    void evaluateRules();
 
-    void notifySubscribers(const AlarmEvent& event) const;
+    // Классифицирует отсчет с учетом гистерезиса относительно подтвержденного уровня
+    static AlarmLevel classify(const CompiledAlarm& entry, float value);
+
+    // Проверяет наклон истории датчика против maxRate (с гистерезисом RATE_HYSTERESIS_RATIO).
+    // slopePerMin получает текущий наклон. Наклон уже поддерживается историей инкрементально.
+    static bool isRateExceeded(const CompiledAlarm& entry, float& slopePerMin);
+
+    // Учитывает отсчет в антидребезге. Возвращает true, если уровень подтвержден и изменился.
+    static bool debounce(DebounceState& entry, AlarmLevel observed, AlarmCause cause);
+
+    // Синхронные подписчики получают событие сразу, асинхронные - через очередь рассылки
+    void notifySubscribers(const AlarmEvent& event);
+
+    // Элемент очереди рассылки. reset = true передает forceResetAlarm в том же порядке, что и события
+    struct QueuedAlarm {
+        AlarmEvent event;
+        int64_t enqueuedUs;
+        bool reset;
+    };
+    void enqueue(const QueuedAlarm& item);
+    static void dispatchTask(void* param);
+    void deliver(const QueuedAlarm& item);
+
+    static void insertByPriority(std::vector<IAlarmSubscriber*>& list, IAlarmSubscriber* subscriber);
+
+    std::vector<CompiledAlarm> _table;  // Отсортирована по SensorId, как и реестр SensorManager
+    size_t _compiledSensorCount = 0;    // Размер реестра на момент сборки таблицы
+    std::vector<CompiledRule> _rules;   // Под _mutex
+    SemaphoreHandle_t _mutex;           // Таблица: проверка идет и из цикла опроса, и из обработчиков настроек
 
     AlarmThresholdService* _thresholdService = nullptr; // Указатель на сервис с настройками
-    std::vector<IAlarmSubscriber*> _subscribers;
+    AlarmRulesService* _rulesService = nullptr;
+    std::vector<IAlarmSubscriber*> _syncSubscribers;  // Под _mutex
+    std::vector<IAlarmSubscriber*> _asyncSubscribers; // Под _asyncMutex: только задача рассылки
+    SemaphoreHandle_t _asyncMutex;
+
+    QueueHandle_t _dispatchQueue = nullptr;
+    TaskHandle_t _dispatchTaskHandle = nullptr;
+    AlarmDispatchStats _dispatchStats;
+    mutable portMUX_TYPE _statsMux = portMUX_INITIALIZER_UNLOCKED;
     update_handler_id_t _updateHandlerId = 0; // ID обработчика для отписки
+    update_handler_id_t _rulesHandlerId = 0;
 
     static constexpr auto TAG = "ALARM_MONITOR";
 
+    static constexpr uint32_t DISPATCH_TASK_STACK_SIZE = 6144;
+    static constexpr UBaseType_t DISPATCH_TASK_PRIORITY = tskIDLE_PRIORITY + 1;
+
     // Значение, которое используется для отслеживания неудачных измерений
     static constexpr float FAILURE_THRESHOLD_VALUE = -999.0f;
+
+    // Наклон считается только по окну не короче этого: на паре точек он слишком шумный
+    static constexpr uint32_t RATE_MIN_WINDOW_MS = 20000;
+    // Тревога по скорости снимается, когда наклон опустится ниже maxRate * (1 - ratio)
+    static constexpr float RATE_HYSTERESIS_RATIO = 0.25f;
+
+    // Телеметрия контроллера старше этого считается недоступной (NaN в правилах)
+    static constexpr uint32_t TELEMETRY_STALE_MS = 10000;
 };
 
 #endif //SSVC_OPEN_CONNECT_ALARMMONITOR_H
\ No newline at end of file
@@ -0,0 +1,462 @@
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include "AlarmRuleProgram.h"
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+struct NamedVar {
+    const char* name;
+    RuleVar var;
+};
+
+const NamedVar VARIABLES[] = {
+    {"inlet_water", RuleVar::INLET_WATER},
+    {"outlet_water", RuleVar::OUTLET_WATER},
+    {"act", RuleVar::ACT},
+    {"tp1", RuleVar::TP1},
+    {"tp2", RuleVar::TP2},
+    {"tp1_target", RuleVar::TP1_TARGET},
+    {"tp2_target", RuleVar::TP2_TARGET},
+    {"mmhg", RuleVar::MMHG},
+    {"relay", RuleVar::RELAY},
+    {"signal", RuleVar::SIGNAL},
+    {"open", RuleVar::OPEN},
+    {"alc", RuleVar::ALC},
+    {"stage", RuleVar::STAGE},
+};
+
+struct NamedConst {
+    const char* name;
+    float value;
+};
+
+// Номера этапов совпадают с RectificationProcess::RectificationStage
+const NamedConst CONSTANTS[] = {
+    {"waiting", 1},
+    {"tp1_waiting", 2},
+    {"delayed_start", 3},
+    {"heads", 4},
+    {"late_heads", 5},
+    {"hearts", 6},
+    {"tails", 7},
+    {"on", 1},
+    {"off", 0},
+    {"true", 1},
+    {"false", 0},
+};
+
+enum class Tok {
+    END, NUMBER, IDENT, LPAREN, RPAREN, COMMA,
+    PLUS, MINUS, STAR, SLASH,
+    LT, LE, GT, GE, EQ, NE,
+    AND, OR, NOT, WHILE,
+    INVALID
+};
+
+} // namespace
+
+/**
+ * @brief Рекурсивный спуск по выражению с выдачей постфиксного кода.
+ * Приоритеты (от низкого): while, or, and, not, сравнение, + -, * /, унарный минус.
+ */
+class AlarmRuleCompiler {
+public:
+    AlarmRuleCompiler(const std::string& source, AlarmRuleProgram& out) : _src(source), _out(out) {}
+
+    bool run(std::string& error) {
+        _out._code.clear();
+        _out._rateSlots = 0;
+        next();
+        if (_tok == Tok::END) {
+            fail("empty expression");
+        } else {
+            parseWhile();
+            if (_tok != Tok::END) {
+                fail("unexpected token");
+            }
+        }
+        if (!_error.empty()) {
+            error = _error;
+            _out._code.clear();
+            _out._rateSlots = 0;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const std::string& _src;
+    AlarmRuleProgram& _out;
+    size_t _pos = 0;
+    size_t _tokStart = 0;
+    Tok _tok = Tok::END;
+    float _number = 0.0f;
+    std::string _ident;
+    size_t _depth = 0;
+    // Вложенность скобок, вызовов и унарных операторов. Разбор рекурсивный, а правило
+    // компилируется в задаче httpd со стеком 8 КБ, поэтому глубина ограничена до emit()
+    size_t _nesting = 0;
+    std::string _error;
+
+    void fail(const char* message) {
+        if (_error.empty()) {
+            _error = std::string(message) + " at " + std::to_string(_tokStart);
+        }
+    }
+
+    bool enterNested() {
+        if (++_nesting > AlarmRuleProgram::MAX_STACK) {
+            fail("expression is nested too deeply");
+            return false;
+        }
+        return true;
+    }
+
+    bool accept(const Tok tok) {
+        if (_tok != tok) {
+            return false;
+        }
+        next();
+        return true;
+    }
+
+    void next() {
+        while (_pos < _src.size() && std::isspace(static_cast<unsigned char>(_src[_pos]))) {
+            _pos++;
+        }
+        _tokStart = _pos;
+        if (_pos >= _src.size()) {
+            _tok = Tok::END;
+            return;
+        }
+
+        const char c = _src[_pos];
+        const char n = _pos + 1 < _src.size() ? _src[_pos + 1] : '\0';
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && std::isdigit(static_cast<unsigned char>(n)))) {
+            char* end = nullptr;
+            _number = std::strtof(_src.c_str() + _pos, &end);
+            _pos = end - _src.c_str();
+            _tok = Tok::NUMBER;
+            return;
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            const size_t start = _pos;
+            while (_pos < _src.size() &&
+                   (std::isalnum(static_cast<unsigned char>(_src[_pos])) || _src[_pos] == '_')) {
+                _pos++;
+            }
+            _ident = _src.substr(start, _pos - start);
+            _tok = _ident == "and" ? Tok::AND
+                 : _ident == "or" ? Tok::OR
+                 : _ident == "not" ? Tok::NOT
+                 : _ident == "while" ? Tok::WHILE
+                 : Tok::IDENT;
+            return;
+        }
+        // Знак минуса U+2212, который попадает в выражения при копировании из документов
+        if (static_cast<unsigned char>(c) == 0xE2 && _src.compare(_pos, 3, "\xE2\x88\x92") == 0) {
+            _pos += 3;
+            _tok = Tok::MINUS;
+            return;
+        }
+
+        _pos++;
+        switch (c) {
+        case '(': _tok = Tok::LPAREN; return;
+        case ')': _tok = Tok::RPAREN; return;
+        case ',': _tok = Tok::COMMA; return;
+        case '+': _tok = Tok::PLUS; return;
+        case '-': _tok = Tok::MINUS; return;
+        case '*': _tok = Tok::STAR; return;
+        case '/': _tok = Tok::SLASH; return;
+        case '<': _tok = n == '=' ? (_pos++, Tok::LE) : Tok::LT; return;
+        case '>': _tok = n == '=' ? (_pos++, Tok::GE) : Tok::GT; return;
+        case '=': _tok = n == '=' ? (_pos++, Tok::EQ) : Tok::INVALID; return;
+        case '!': _tok = n == '=' ? (_pos++, Tok::NE) : Tok::NOT; return;
+        case '&': _tok = n == '&' ? (_pos++, Tok::AND) : Tok::INVALID; return;
+        case '|': _tok = n == '|' ? (_pos++, Tok::OR) : Tok::INVALID; return;
+        default: _tok = Tok::INVALID; return;
+        }
+    }
+
+    // Выдает инструкцию и отслеживает глубину стека: pops операндов снимается, результат кладется
+    void emit(const RuleOp op, const size_t pops, const uint8_t arg = 0, const float value = 0.0f) {
+        if (!_error.empty()) {
+            return;
+        }
+        if (_out._code.size() >= AlarmRuleProgram::MAX_INSTRUCTIONS) {
+            fail("expression is too long");
+            return;
+        }
+        _out._code.push_back({op, arg, value});
+        _depth = _depth - pops + 1;
+        if (_depth > AlarmRuleProgram::MAX_STACK) {
+            fail("expression is nested too deeply");
+        }
+    }
+
+    void parseWhile() {
+        parseOr();
+        while (_error.empty() && accept(Tok::WHILE)) {
+            parseOr();
+            emit(RuleOp::AND, 2);
+        }
+    }
+
+    void parseOr() {
+        parseAnd();
+        while (_error.empty() && accept(Tok::OR)) {
+            parseAnd();
+            emit(RuleOp::OR, 2);
+        }
+    }
+
+    void parseAnd() {
+        parseNot();
+        while (_error.empty() && accept(Tok::AND)) {
+            parseNot();
+            emit(RuleOp::AND, 2);
+        }
+    }
+
+    void parseNot() {
+        if (accept(Tok::NOT)) {
+            if (enterNested()) {
+                parseNot();
+                emit(RuleOp::NOT, 1);
+            }
+            _nesting--;
+            return;
+        }
+        parseComparison();
+    }
+
+    void parseComparison() {
+        parseSum();
+        RuleOp op;
+        switch (_tok) {
+        case Tok::LT: op = RuleOp::LT; break;
+        case Tok::LE: op = RuleOp::LE; break;
+        case Tok::GT: op = RuleOp::GT; break;
+        case Tok::GE: op = RuleOp::GE; break;
+        case Tok::EQ: op = RuleOp::EQ; break;
+        case Tok::NE: op = RuleOp::NE; break;
+        default: return;
+        }
+        next();
+        parseSum();
+        emit(op, 2);
+    }
+
+    void parseSum() {
+        parseTerm();
+        while (_error.empty() && (_tok == Tok::PLUS || _tok == Tok::MINUS)) {
+            const RuleOp op = _tok == Tok::PLUS ? RuleOp::ADD : RuleOp::SUB;
+            next();
+            parseTerm();
+            emit(op, 2);
+        }
+    }
+
+    void parseTerm() {
+        parseUnary();
+        while (_error.empty() && (_tok == Tok::STAR || _tok == Tok::SLASH)) {
+            const RuleOp op = _tok == Tok::STAR ? RuleOp::MUL : RuleOp::DIV;
+            next();
+            parseUnary();
+            emit(op, 2);
+        }
+    }
+
+    void parseUnary() {
+        if (accept(Tok::MINUS)) {
+            if (enterNested()) {
+                parseUnary();
+                emit(RuleOp::NEG, 1);
+            }
+            _nesting--;
+            return;
+        }
+        parsePrimary();
+    }
+
+    void parsePrimary() {
+        if (!_error.empty()) {
+            return;
+        }
+        if (_tok == Tok::NUMBER) {
+            emit(RuleOp::PUSH, 0, 0, _number);
+            next();
+            return;
+        }
+        if (accept(Tok::LPAREN)) {
+            if (enterNested()) {
+                parseWhile();
+                if (!accept(Tok::RPAREN)) {
+                    fail("')' expected");
+                }
+            }
+            _nesting--;
+            return;
+        }
+        if (_tok != Tok::IDENT) {
+            fail("value expected");
+            return;
+        }
+
+        const std::string name = _ident;
+        const size_t nameStart = _tokStart;
+        next();
+        if (accept(Tok::LPAREN)) {
+            if (enterNested()) {
+                parseCall(name);
+            }
+            _nesting--;
+            return;
+        }
+        for (const NamedVar& v : VARIABLES) {
+            if (name == v.name) {
+                emit(RuleOp::LOAD, 0, static_cast<uint8_t>(v.var));
+                return;
+            }
+        }
+        for (const NamedConst& c : CONSTANTS) {
+            if (name == c.name) {
+                emit(RuleOp::PUSH, 0, 0, c.value);
+                return;
+            }
+        }
+        _tokStart = nameStart;
+        fail(("unknown name '" + name + "'").c_str());
+    }
+
+    void parseCall(const std::string& name) {
+        size_t args = 0;
+        if (_tok != Tok::RPAREN) {
+            do {
+                parseWhile();
+                args++;
+            } while (_error.empty() && accept(Tok::COMMA));
+        }
+        if (!accept(Tok::RPAREN)) {
+            fail("')' expected");
+            return;
+        }
+
+        if (name == "abs" && args == 1) {
+            emit(RuleOp::ABS, 1);
+        } else if (name == "min" && args == 2) {
+            emit(RuleOp::MIN, 2);
+        } else if (name == "max" && args == 2) {
+            emit(RuleOp::MAX, 2);
+        } else if (name == "rate" && args == 1) {
+            if (_out._rateSlots >= AlarmRuleProgram::MAX_RATE_SLOTS) {
+                fail("too many rate() calls");
+                return;
+            }
+            emit(RuleOp::RATE, 1, _out._rateSlots++);
+        } else {
+            fail(("unknown function '" + name + "' or wrong number of arguments").c_str());
+        }
+    }
+};
+
+bool AlarmRuleProgram::compile(const std::string& source, AlarmRuleProgram& out, std::string& error) {
+    if (source.size() > MAX_SOURCE_LENGTH) {
+        error = "expression is longer than " + std::to_string(MAX_SOURCE_LENGTH) + " characters";
+        out._code.clear();
+        out._rateSlots = 0;
+        return false;
+    }
+    return AlarmRuleCompiler(source, out).run(error);
+}
+
+bool AlarmRuleProgram::isTrue(const float value) {
+    return value != 0.0f && !std::isnan(value);
+}
+
+float AlarmRuleProgram::evaluate(const RuleContext& context, RuleRateSlot* slots) const {
+    // Глубина стека проверена при компиляции
+    float stack[MAX_STACK];
+    size_t sp = 0;
+
+    for (const RuleInstr& instr : _code) {
+        switch (instr.op) {
+        case RuleOp::PUSH:
+            stack[sp++] = instr.value;
+            break;
+        case RuleOp::LOAD:
+            stack[sp++] = context.vars[instr.arg];
+            break;
+        case RuleOp::RATE: {
+            RuleRateSlot& slot = slots[instr.arg];
+            const float x = stack[sp - 1];
+            const uint32_t dt = context.nowMs - slot.prevMs;
+            if (std::isnan(x)) {
+                slot.hasPrev = false;
+                slot.lastRate = NAN;
+            } else if (!slot.hasPrev) {
+                slot.hasPrev = true;
+                slot.prevValue = x;
+                slot.prevMs = context.nowMs;
+                slot.lastRate = NAN;
+            } else if (dt >= RATE_MIN_INTERVAL_MS) {
+                slot.lastRate = (x - slot.prevValue) * 60000.0f / static_cast<float>(dt);
+                slot.prevValue = x;
+                slot.prevMs = context.nowMs;
+            }
+            stack[sp - 1] = slot.lastRate;
+            break;
+        }
+        case RuleOp::NEG: stack[sp - 1] = -stack[sp - 1]; break;
+        case RuleOp::NOT: stack[sp - 1] = isTrue(stack[sp - 1]) ? 0.0f : 1.0f; break;
+        case RuleOp::ABS: stack[sp - 1] = std::fabs(stack[sp - 1]); break;
+        default: {
+            // Бинарные операции
+            const float b = stack[--sp];
+            const float a = stack[sp - 1];
+            float r;
+            switch (instr.op) {
+            case RuleOp::ADD: r = a + b; break;
+            case RuleOp::SUB: r = a - b; break;
+            case RuleOp::MUL: r = a * b; break;
+            case RuleOp::DIV: r = b != 0.0f ? a / b : NAN; break;
+            case RuleOp::LT: r = a < b ? 1.0f : 0.0f; break;
+            case RuleOp::LE: r = a <= b ? 1.0f : 0.0f; break;
+            case RuleOp::GT: r = a > b ? 1.0f : 0.0f; break;
+            case RuleOp::GE: r = a >= b ? 1.0f : 0.0f; break;
+            case RuleOp::EQ: r = a == b ? 1.0f : 0.0f; break;
+            case RuleOp::NE: r = (!std::isnan(a) && !std::isnan(b) && a != b) ? 1.0f : 0.0f; break;
+            case RuleOp::AND: r = isTrue(a) && isTrue(b) ? 1.0f : 0.0f; break;
+            case RuleOp::OR: r = isTrue(a) || isTrue(b) ? 1.0f : 0.0f; break;
+            case RuleOp::MIN: r = std::fmin(a, b); break;
+            case RuleOp::MAX: r = std::fmax(a, b); break;
+            default: r = NAN; break;
+            }
+            stack[sp - 1] = r;
+            break;
+        }
+        }
+    }
+    return sp > 0 ? stack[sp - 1] : NAN;
+}
@@ -0,0 +1,127 @@
+#ifndef SSVC_OPEN_CONNECT_ALARMRULEPROGRAM_H
+#define SSVC_OPEN_CONNECT_ALARMRULEPROGRAM_H
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Длина имени правила вместе с завершающим нулем (имя передается в AlarmEvent)
+#define ALARM_RULE_NAME_LENGTH 24
+
+/**
+ * @brief Переменные, доступные в выражениях правил.
+ * Зоны - максимум валидных показаний датчиков зоны,
+ * остальное - телеметрия контроллера SSVC (RectificationProcess).
+ * Недоступное значение - NaN: любое сравнение с ним ложно.
+ */
+enum class RuleVar : uint8_t {
+    INLET_WATER,
+    OUTLET_WATER,
+    ACT,
+    TP1,
+    TP2,
+    TP1_TARGET,
+    TP2_TARGET,
+    MMHG,
+    RELAY,
+    SIGNAL,
+    OPEN,
+    ALC,
+    STAGE,   // RectificationProcess::RectificationStage как число
+    COUNT
+};
+
+/**
+ * @brief Значения переменных на момент вычисления.
+ */
+struct RuleContext {
+    float vars[static_cast<size_t>(RuleVar::COUNT)];
+    uint32_t nowMs;
+};
+
+/**
+ * @brief Состояние одного вызова rate() внутри правила (предыдущий отсчет).
+ */
+struct RuleRateSlot {
+    float prevValue = 0.0f;
+    float lastRate = 0.0f;
+    uint32_t prevMs = 0;
+    bool hasPrev = false;
+};
+
+enum class RuleOp : uint8_t {
+    PUSH, LOAD, RATE,
+    ADD, SUB, MUL, DIV, NEG,
+    LT, LE, GT, GE, EQ, NE,
+    AND, OR, NOT,
+    ABS, MIN, MAX
+};
+
+struct RuleInstr {
+    RuleOp op;
+    uint8_t arg;  // RuleVar для LOAD, номер слота для RATE
+    float value;  // Константа для PUSH
+};
+
+/**
+ * @brief Скомпилированное выражение правила: постфиксный байткод для стековой машины.
+ *
+ * Компиляция выполняется один раз при сохранении правила. Вычисление идет за
+ * ограниченное время (не более MAX_INSTRUCTIONS шагов, без ветвлений) на стеке
+ * фиксированного размера и без выделения памяти.
+ *
+ * Язык: числа, переменные (RuleVar), константы этапов (heads, hearts, ...) и on/off,
+ * + - * /, сравнения < <= > >= == !=, and/or/not (&&, ||, !), while (то же, что and),
+ * функции abs(x), min(a, b), max(a, b), rate(x) - скорость изменения x в единицах в минуту.
+ */
+class AlarmRuleProgram {
+public:
+    static constexpr size_t MAX_INSTRUCTIONS = 48;
+    static constexpr size_t MAX_STACK = 16;
+    static constexpr size_t MAX_RATE_SLOTS = 4;
+    static constexpr size_t MAX_SOURCE_LENGTH = 160;
+    // Интервал, чаще которого rate() не пересчитывается (повторные проверки из обработчиков настроек)
+    static constexpr uint32_t RATE_MIN_INTERVAL_MS = 1000;
+
+    /**
+     * @brief Компилирует выражение.
+     * @param error Описание ошибки с позицией, если компиляция не удалась.
+     */
+    static bool compile(const std::string& source, AlarmRuleProgram& out, std::string& error);
+
+    /**
+     * @brief Вычисляет выражение. slots - массив не менее getRateSlots() элементов.
+     * @return Результат (для логических выражений 1 или 0, NaN - значение недоступно).
+     */
+    float evaluate(const RuleContext& context, RuleRateSlot* slots) const;
+
+    static bool isTrue(float value);
+
+    uint8_t getRateSlots() const { return _rateSlots; }
+    size_t size() const { return _code.size(); }
+
+private:
+    std::vector<RuleInstr> _code;
+    uint8_t _rateSlots = 0;
+
+    friend class AlarmRuleCompiler;
+};
+
+#endif //SSVC_OPEN_CONNECT_ALARMRULEPROGRAM_H
@@ -0,0 +1,234 @@
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include "AlarmJournal.h"
+#include <esp_timer.h>
+
+AlarmJournal& AlarmJournal::getInstance() {
+    static AlarmJournal instance;
+    return instance;
+}
+
+void AlarmJournal::begin(FS* fs) {
+    if (_taskHandle != nullptr) {
+        return;
+    }
+    _fs = fs;
+    _fileMutex = xSemaphoreCreateMutex();
+    _queue = xQueueCreate(QUEUE_LENGTH, sizeof(AlarmJournalRecord));
+
+    if (!_fs || !_fileMutex || !_queue || !openOrCreate()) {
+        ESP_LOGE(TAG, "Alarm journal is not available: cannot open %s.", ALARM_JOURNAL_FILE);
+        return;
+    }
+
+    xTaskCreatePinnedToCore(
+        writerTask,
+        "AlarmJournal",
+        4096,
+        this,
+        1, // Ниже задач опроса и связи: запись во флеш может подождать
+        &_taskHandle,
+        APP_CPU_NUM
+    );
+
+    AlarmMonitor::getInstance().subscribe(this);
+    ESP_LOGI(TAG, "Alarm journal ready: %u of %u records, next seq %lu.",
+             _header.count, _header.capacity, _header.nextSeq);
+}
+
+bool AlarmJournal::openOrCreate() {
+    if (_fs->exists(ALARM_JOURNAL_FILE)) {
+        File file = _fs->open(ALARM_JOURNAL_FILE, "r");
+        FileHeader header{};
+        const bool valid = file &&
+            file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+            header.magic == MAGIC && header.version == VERSION &&
+            header.capacity == CAPACITY && header.recordSize == sizeof(AlarmJournalRecord) &&
+            header.head < CAPACITY && header.count <= CAPACITY &&
+            file.size() == slotOffset(CAPACITY);
+        file.close();
+        if (valid) {
+            _header = header;
+            return true;
+        }
+        ESP_LOGW(TAG, "Journal %s has an unexpected format. Recreating.", ALARM_JOURNAL_FILE);
+    }
+
+    File file = _fs->open(ALARM_JOURNAL_FILE, "w");
+    if (!file) {
+        return false;
+    }
+
+    _header = {};
+    _header.magic = MAGIC;
+    _header.version = VERSION;
+    _header.capacity = CAPACITY;
+    _header.recordSize = sizeof(AlarmJournalRecord);
+    _header.nextSeq = 1;
+
+    // Файл создается сразу полного размера: дальше запись идет только по месту (r+)
+    bool ok = file.write(reinterpret_cast<const uint8_t*>(&_header), sizeof(_header)) == sizeof(_header);
+    const AlarmJournalRecord empty{};
+    for (uint16_t slot = 0; ok && slot < CAPACITY; slot++) {
+        ok = file.write(reinterpret_cast<const uint8_t*>(&empty), sizeof(empty)) == sizeof(empty);
+    }
+    file.close();
+    return ok;
+}
+
+void AlarmJournal::onAlarm(const AlarmEvent& event) {
+    AlarmJournalRecord record{};
+    record.sensorId = event.sensor ? event.sensor->getId() : 0;
+    record.timestamp = static_cast<uint32_t>(event.timestamp);
+    record.value = event.current_value;
+    record.threshold = event.threshold_value;
+    record.level = static_cast<uint8_t>(event.level);
+    record.cause = static_cast<uint8_t>(event.cause);
+    record.rule = event.rule_index;
+
+    // Без ожидания: при переполнении очереди событие теряется только для журнала
+    if (_queue == nullptr || xQueueSend(_queue, &record, 0) != pdTRUE) {
+        _dropped++;
+    }
+}
+
+void AlarmJournal::writerTask(void* param) {
+    auto* self = static_cast<AlarmJournal*>(param);
+    AlarmJournalRecord batch[BATCH_SIZE];
+    const TickType_t window = pdMS_TO_TICKS(BATCH_WINDOW_MS);
+
+    while (true) {
+        if (xQueueReceive(self->_queue, &batch[0], portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        size_t count = 1;
+
+        // Добираем пакет: всплеск переходов уходит во флеш одной записью
+        const TickType_t started = xTaskGetTickCount();
+        while (count < BATCH_SIZE) {
+            const TickType_t elapsed = xTaskGetTickCount() - started;
+            const TickType_t wait = elapsed < window ? window - elapsed : 0;
+            if (xQueueReceive(self->_queue, &batch[count], wait) != pdTRUE) {
+                break;
+            }
+            count++;
+        }
+
+        self->flush(batch, count);
+    }
+}
+
+void AlarmJournal::flush(AlarmJournalRecord* batch, const size_t count) {
+    const int64_t started = esp_timer_get_time();
+
+    xSemaphoreTake(_fileMutex, portMAX_DELAY);
+    File file = _fs->open(ALARM_JOURNAL_FILE, "r+");
+    if (!file) {
+        xSemaphoreGive(_fileMutex);
+        ESP_LOGE(TAG, "Cannot open %s for writing. %zu records lost.", ALARM_JOURNAL_FILE, count);
+        return;
+    }
+
+    bool ok = true;
+    size_t done = 0;
+    while (ok && done < count) {
+        // Непрерывный участок до конца кольца пишется одним вызовом
+        const size_t untilWrap = CAPACITY - _header.head;
+        const size_t run = count - done < untilWrap ? count - done : untilWrap;
+        for (size_t i = 0; i < run; i++) {
+            batch[done + i].seq = _header.nextSeq++;
+        }
+
+        const size_t bytes = run * sizeof(AlarmJournalRecord);
+        ok = file.seek(slotOffset(_header.head)) &&
+             file.write(reinterpret_cast<const uint8_t*>(&batch[done]), bytes) == bytes;
+
+        _header.head = static_cast<uint16_t>((_header.head + run) % CAPACITY);
+        const size_t total = _header.count + run;
+        _header.count = static_cast<uint16_t>(total < CAPACITY ? total : CAPACITY);
+        done += run;
+    }
+
+    ok = ok && file.seek(0) &&
+         file.write(reinterpret_cast<const uint8_t*>(&_header), sizeof(_header)) == sizeof(_header);
+    file.close();
+
+    _written += count;
+    _flushes++;
+    _lastFlushUs = static_cast<uint32_t>(esp_timer_get_time() - started);
+    xSemaphoreGive(_fileMutex);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Write to %s failed (%zu records).", ALARM_JOURNAL_FILE, count);
+    }
+}
+
+size_t AlarmJournal::read(const uint32_t afterSeq, const uint32_t fromTime, const uint32_t toTime,
+                          AlarmJournalRecord* out, const size_t maxCount) const {
+    if (!_fs || !_fileMutex || maxCount == 0) {
+        return 0;
+    }
+
+    xSemaphoreTake(_fileMutex, portMAX_DELAY);
+    File file = _fs->open(ALARM_JOURNAL_FILE, "r");
+    if (!file) {
+        xSemaphoreGive(_fileMutex);
+        return 0;
+    }
+
+    // Номера в кольце идут подряд: курсор сразу дает позицию, без просмотра старых записей
+    const uint32_t oldestSeq = _header.nextSeq - _header.count;
+    const uint32_t skip = afterSeq >= oldestSeq ? afterSeq - oldestSeq + 1 : 0;
+    const uint16_t oldestSlot = static_cast<uint16_t>((_header.head + CAPACITY - _header.count) % CAPACITY);
+
+    size_t found = 0;
+    for (uint32_t index = skip; index < _header.count && found < maxCount; index++) {
+        const uint16_t slot = static_cast<uint16_t>((oldestSlot + index) % CAPACITY);
+        // Чтение идет подряд; позиционироваться нужно только в начале и на переходе кольца
+        if ((index == skip || slot == 0) && !file.seek(slotOffset(slot))) {
+            break;
+        }
+        AlarmJournalRecord record;
+        if (file.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) != sizeof(record)) {
+            break;
+        }
+        if (record.timestamp >= fromTime && record.timestamp <= toTime) {
+            out[found++] = record;
+        }
+    }
+    file.close();
+    xSemaphoreGive(_fileMutex);
+    return found;
+}
+
+AlarmJournalStats AlarmJournal::getStats() const {
+    AlarmJournalStats stats;
+    stats.dropped = _dropped.load();
+    stats.capacity = CAPACITY;
+    if (!_fileMutex) {
+        return stats;
+    }
+    xSemaphoreTake(_fileMutex, portMAX_DELAY);
+    stats.written = _written;
+    stats.flushes = _flushes;
+    stats.lastFlushUs = _lastFlushUs;
+    stats.count = _header.count;
+    stats.nextSeq = _header.nextSeq;
+    xSemaphoreGive(_fileMutex);
+    return stats;
+}
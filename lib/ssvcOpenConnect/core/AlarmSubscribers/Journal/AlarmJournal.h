@@ -0,0 +1,136 @@
+#ifndef SSVC_OPEN_CONNECT_ALARMJOURNAL_H
+#define SSVC_OPEN_CONNECT_ALARMJOURNAL_H
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <Arduino.h>
+#include <atomic>
+#include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#include "core/IAlarmSubscriber/IAlarmSubscriber.h"
+#include "core/AlarmMonitor/AlarmMonitor.h"
+
+#define ALARM_JOURNAL_FILE "/alarm_journal.bin"
+
+/**
+ * @brief Одна запись журнала тревог. Размер фиксирован - файл журнала является
+ * кольцом из таких записей.
+ */
+struct AlarmJournalRecord {
+    SensorId sensorId;
+    uint32_t seq;        // Сквозной номер записи, монотонно растет (курсор для постраничного чтения)
+    uint32_t timestamp;  // Unix-время события, с
+    float value;
+    float threshold;
+    uint8_t level;       // AlarmLevel
+    uint8_t cause;       // AlarmCause
+    uint8_t rule;        // Номер правила для cause == RULE (sensorId тогда 0)
+    uint8_t reserved[5];
+};
+static_assert(sizeof(AlarmJournalRecord) == 32, "Journal record layout is part of the on-flash format");
+
+struct AlarmJournalStats {
+    uint32_t written = 0;     // Записей сохранено с момента запуска
+    uint32_t dropped = 0;     // Событий потеряно из-за переполнения очереди
+    uint32_t flushes = 0;     // Пакетных записей во флеш
+    uint32_t lastFlushUs = 0; // Длительность последней пакетной записи
+    uint16_t count = 0;       // Записей в журнале
+    uint16_t capacity = 0;
+    uint32_t nextSeq = 0;
+};
+
+/**
+ * @brief Журнал переходов тревог на LittleFS.
+ *
+ * onAlarm только кладет запись в очередь (без ожидания) - путь тревоги не задерживается.
+ * Низкоприоритетная задача собирает записи пакетами и пишет их в кольцевой файл
+ * фиксированного размера: заголовок + CAPACITY записей, старые перезаписываются.
+ */
+class AlarmJournal final : public IAlarmSubscriber {
+public:
+    static AlarmJournal& getInstance();
+
+    static constexpr uint16_t CAPACITY = 512;       // Записей в кольце (16 КБ на флеше)
+    static constexpr size_t QUEUE_LENGTH = 32;      // Событий в ожидании записи
+    static constexpr uint32_t BATCH_WINDOW_MS = 2000; // Сколько ждать добора пакета после первого события
+    static constexpr size_t MAX_PAGE = 50;          // Предел записей в одном ответе read()
+
+    /**
+     * @brief Открывает (или создает) файл журнала, запускает задачу записи и подписывается на AlarmMonitor.
+     */
+    void begin(FS* fs);
+
+    void onAlarm(const AlarmEvent& event) override;
+    // onAlarm только ставит запись в свою очередь - синхронная доставка не добавляет задержки
+    // и не зависит от очереди рассылки
+    AlarmDelivery getDelivery() const override { return AlarmDelivery::SYNC; }
+    uint8_t getDeliveryPriority() const override { return 64; }
+
+    /**
+     * @brief Читает записи с seq > afterSeq и временем в [fromTime, toTime], от старых к новым.
+     * @param out Буфер не меньше maxCount записей.
+     * @return Количество прочитанных записей (не более maxCount).
+     */
+    size_t read(uint32_t afterSeq, uint32_t fromTime, uint32_t toTime,
+                AlarmJournalRecord* out, size_t maxCount) const;
+
+    AlarmJournalStats getStats() const;
+
+private:
+    AlarmJournal() = default;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t capacity;
+        uint16_t recordSize;
+        uint16_t head;     // Слот, в который пойдет следующая запись
+        uint16_t count;
+        uint16_t reserved;
+        uint32_t nextSeq;
+    };
+    static_assert(sizeof(FileHeader) == 20, "Journal header layout is part of the on-flash format");
+
+    static constexpr uint32_t MAGIC = 0x524A4C41; // "ALJR"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t BATCH_SIZE = 16;
+
+    FS* _fs = nullptr;
+    QueueHandle_t _queue = nullptr;
+    TaskHandle_t _taskHandle = nullptr;
+    SemaphoreHandle_t _fileMutex = nullptr; // Файл и _header: задача записи против read()
+
+    FileHeader _header{};
+    std::atomic<uint32_t> _dropped{0};
+    uint32_t _written = 0;
+    uint32_t _flushes = 0;
+    uint32_t _lastFlushUs = 0;
+
+    static void writerTask(void* param);
+    void flush(AlarmJournalRecord* batch, size_t count);
+
+    bool openOrCreate();
+    static size_t slotOffset(uint16_t slot) { return sizeof(FileHeader) + slot * sizeof(AlarmJournalRecord); }
+
+    static constexpr auto TAG = "ALARM_JOURNAL";
+};
+
+#endif //SSVC_OPEN_CONNECT_ALARMJOURNAL_H
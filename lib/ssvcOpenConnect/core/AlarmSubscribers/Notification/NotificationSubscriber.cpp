@@ -21,6 +21,22 @@
 NotificationSubscriber::NotificationSubscriber(ESP32SvelteKit* svelteKit)
     : _sveltekit(svelteKit) // Инициализация члена класса
 {
+    for (int8_t& head : _wheel) {
+        head = -1;
+    }
+
+    // Таймер колеса работает постоянно: тик без тревог - один пустой просмотр ячейки
+    _wheelTimer = xTimerCreate(
+        "ReAlarmWheel",
+        pdMS_TO_TICKS(WHEEL_TICK_MS),
+        pdTRUE, // pdTRUE для периодического
+        this,
+        wheelTimerCallback
+    );
+    if (_wheelTimer == nullptr || xTimerStart(_wheelTimer, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start re-notification timer. Alarms will be notified once.");
+    }
+
     // Подписка на AlarmMonitor остается
     AlarmMonitor::getInstance().subscribe(this);
     ESP_LOGI(TAG, "AlarmLogger subscribed to AlarmMonitor events.");
@@ -30,134 +46,192 @@ NotificationSubscriber::~NotificationSubscriber() {
     // Отписка от AlarmMonitor
     AlarmMonitor::getInstance().unsubscribe(this);
 
-    if (_reAlarmTimer != nullptr) {
-        // Сначала останавливаем, если активен
-        if (xTimerIsTimerActive(_reAlarmTimer) != pdFALSE) {
-            xTimerStop(_reAlarmTimer, 0);
-        }
-        xTimerDelete(_reAlarmTimer, 0);
-        _reAlarmTimer = nullptr;
-        ESP_LOGI(TAG, "ReAlarmTimer deleted.");
+    if (_wheelTimer != nullptr) {
+        xTimerStop(_wheelTimer, 0);
+        xTimerDelete(_wheelTimer, 0);
+        _wheelTimer = nullptr;
+        ESP_LOGI(TAG, "Re-notification timer deleted.");
     }
 }
 
 // NotificationSubscriber.cpp
 void NotificationSubscriber::forceResetAlarm() {
-    if (_reAlarmTimer != nullptr && xTimerIsTimerActive(_reAlarmTimer) != pdFALSE) {
-        xTimerStop(_reAlarmTimer, 0);
-        ESP_LOGW(TAG, "Alarm timer FORCIBLY STOPPED due to threshold update."); // <-- Лог
+    taskENTER_CRITICAL(&_alarmMux);
+    for (int8_t& head : _wheel) {
+        head = -1;
     }
-    _isAlarmActive = false;
-    _lastActiveAlarm = {}; // Очистка кэша (если нужно, но необязательно, т.к. таймер остановлен)
+    for (ReAlarmSlot& slot : _slots) {
+        slot.used = false;
+        slot.next = -1;
+    }
+    taskEXIT_CRITICAL(&_alarmMux);
+    ESP_LOGW(TAG, "All re-notifications FORCIBLY CLEARED due to threshold update."); // <-- Лог
 }
 
-
-void NotificationSubscriber::reAlarmTimerAction() const
-{
-    if (!_isAlarmActive) {
-        if (_reAlarmTimer != nullptr && xTimerIsTimerActive(_reAlarmTimer) != pdFALSE) {
-            xTimerStop(_reAlarmTimer, 0);
-        }
-        ESP_LOGW(TAG, "Re-notification timer fired, but alarm is not active. Timer stopped.");
-        return;
+uint32_t NotificationSubscriber::intervalTicks(const AlarmLevel level) {
+    switch (level) {
+    case AlarmLevel::CRITICAL: return CRITICAL_INTERVAL_TICKS;
+    case AlarmLevel::DANGEROUS: return DANGEROUS_INTERVAL_TICKS;
+    default: return MIN_INTERVAL_TICKS;
     }
+}
 
-    const AbstractSensor* sensor = _lastActiveAlarm.sensor;
-    if (sensor == nullptr) {
-        ESP_LOGE(TAG, "Re-notification failed: Sensor pointer is NULL.");
-        return;
+int NotificationSubscriber::findSlot(const AlarmEvent& event) const {
+    for (size_t i = 0; i < MAX_TRACKED; i++) {
+        const ReAlarmSlot& slot = _slots[i];
+        if (!slot.used) {
+            continue;
+        }
+        // Датчик определяется указателем, правило - номером (у правил sensor == nullptr)
+        const bool same = event.sensor != nullptr
+            ? slot.event.sensor == event.sensor
+            : slot.event.sensor == nullptr && slot.event.rule_index == event.rule_index;
+        if (same) {
+            return static_cast<int>(i);
+        }
     }
-
-    const float current_value = sensor->getData();
-
-    ESP_LOGW(TAG, "reAlarmTimerAction(): [ALARM_LOGGER] Re-notification triggered by timer for sensor %s. Actual value: %.2f C (Cached: %.2f C).",
-             sensor->getName().c_str(), current_value, _lastActiveAlarm.current_value);
-
-    AlarmEvent currentEvent = _lastActiveAlarm; // Копируем старое событие
-    currentEvent.current_value = current_value;  // Обновляем только значение на актуальное
-    currentEvent.timestamp = time(nullptr);     // Обновляем время
-
-    sendNotification(currentEvent);
+    return -1;
 }
 
-void NotificationSubscriber::onAlarm(const AlarmEvent& event) {
-    const bool eventIsAlarm = event.level != AlarmLevel::NORMAL;
+void NotificationSubscriber::link(const int index) {
+    ReAlarmSlot& slot = _slots[index];
+    int8_t& head = _wheel[slot.dueTick % WHEEL_SIZE];
+    slot.next = head;
+    head = static_cast<int8_t>(index);
+}
 
-    // 1. Инициализация таймера при первом вызове
-    if (_reAlarmTimer == nullptr) {
-        _reAlarmTimer = xTimerCreate(
-            "ReAlarmTimer",
-            RE_NOTIFICATION_INTERVAL_MS,
-            pdTRUE, // pdTRUE для периодического
-            (void*)this,
-            reAlarmTimerCallback
-        );
-        ESP_LOGI(TAG, "ReAlarmTimer created.");
+void NotificationSubscriber::unlink(const int index) {
+    int8_t* cursor = &_wheel[_slots[index].dueTick % WHEEL_SIZE];
+    while (*cursor >= 0) {
+        if (*cursor == index) {
+            *cursor = _slots[index].next;
+            _slots[index].next = -1;
+            return;
+        }
+        cursor = &_slots[*cursor].next;
     }
+}
 
-    // 2. Логика управления тревогами
-    if (eventIsAlarm) {
-        // Тревога активна (CRITICAL/DANGEROUS/MIN)
+void NotificationSubscriber::onAlarm(const AlarmEvent& event) {
+    const char* source = event.sensor ? event.sensor->getName().c_str() : event.rule_name;
 
-        // Отправляем первое уведомление немедленно
+    if (event.level != AlarmLevel::NORMAL) {
+        // Тревога активна (CRITICAL/DANGEROUS/MIN): первое уведомление - немедленно
         sendNotification(event);
 
-        // Сохраняем событие для повторных уведомлений
-        _lastActiveAlarm = event;
-        _isAlarmActive = true;
-
-        // Запускаем таймер, если он еще не запущен
-        if (xTimerIsTimerActive(_reAlarmTimer) == pdFALSE) {
-            xTimerStart(_reAlarmTimer, 0);
-            ESP_LOGI(TAG, "Alarm timer started for periodic re-notifications.");
+        // Перевзводим слот источника: смена уровня меняет и интервал повтора
+        taskENTER_CRITICAL(&_alarmMux);
+        int index = findSlot(event);
+        if (index >= 0) {
+            unlink(index);
+        } else {
+            for (size_t i = 0; i < MAX_TRACKED && index < 0; i++) {
+                if (!_slots[i].used) {
+                    index = static_cast<int>(i);
+                }
+            }
         }
-
-    } else {
-        // Тревога сброшена (NORMAL)
-
-        // Останавливаем таймер
-        if (xTimerIsTimerActive(_reAlarmTimer) != pdFALSE) {
-            xTimerStop(_reAlarmTimer, 0);
-            ESP_LOGI(TAG, "Alarm timer stopped: alarm level is NORMAL.");
+        if (index >= 0) {
+            ReAlarmSlot& slot = _slots[index];
+            slot.used = true;
+            slot.event = event;
+            slot.generation++;
+            slot.dueTick = _tick + intervalTicks(event.level);
+            link(index);
         }
+        taskEXIT_CRITICAL(&_alarmMux);
 
-        _isAlarmActive = false;
-        // О сбросе тревоги уведомляем только если это был переход из состояния тревоги
-        if (_lastActiveAlarm.level != AlarmLevel::NORMAL) {
-            // Здесь можно отправить специальное уведомление о сбросе,
-            // но по ТЗ нужно только периодически уведомлять о превышении,
-            // поэтому просто очищаем состояние.
-            ESP_LOGI(TAG, "Alarm reset for sensor %s.", event.sensor->getName().c_str());
+        if (index < 0) {
+            ESP_LOGW(TAG, "All %zu re-notification slots are busy: '%s' will not be repeated.",
+                     static_cast<size_t>(MAX_TRACKED), source);
         }
+        return;
+    }
+
+    // Тревога сброшена (NORMAL): освобождаем слот источника
+    taskENTER_CRITICAL(&_alarmMux);
+    const int index = findSlot(event);
+    if (index >= 0) {
+        unlink(index);
+        _slots[index].used = false;
+    }
+    taskEXIT_CRITICAL(&_alarmMux);
+
+    if (index >= 0) {
+        ESP_LOGI(TAG, "Alarm reset for %s '%s'.", event.sensor ? "sensor" : "rule", source);
     }
 }
 
-void NotificationSubscriber::reAlarmTimerCallback(TimerHandle_t xTimer) {
+void NotificationSubscriber::wheelTimerCallback(TimerHandle_t xTimer) {
     auto* self = static_cast<NotificationSubscriber*>(pvTimerGetTimerID(xTimer));
-    if (!self || !self->_isAlarmActive) return;
+    if (!self) return;
+    self->onWheelTick();
+}
 
-    const float current_value = self->_lastActiveAlarm.sensor->getData();
-    const float threshold = self->_lastActiveAlarm.threshold_value;
-    const AlarmLevel level = self->_lastActiveAlarm.level;
+void NotificationSubscriber::onWheelTick() {
+    taskENTER_CRITICAL(&_alarmMux);
+    const uint32_t now = ++_tick;
+    taskEXIT_CRITICAL(&_alarmMux);
+
+    // Интервалы короче оборота колеса: все слоты ячейки now должны сработать именно сейчас.
+    // Слоты обрабатываются по одному - уведомление отправляется вне критической секции.
+    while (true) {
+        taskENTER_CRITICAL(&_alarmMux);
+        const int index = _wheel[now % WHEEL_SIZE];
+        if (index < 0) {
+            taskEXIT_CRITICAL(&_alarmMux);
+            break;
+        }
+        ReAlarmSlot& slot = _slots[index];
+        unlink(index);
+        slot.dueTick = now + intervalTicks(slot.event.level);
+        link(index);
+        AlarmEvent event = slot.event;
+        const uint16_t generation = slot.generation;
+        taskEXIT_CRITICAL(&_alarmMux);
+
+        if (isStillViolating(event)) {
+            event.timestamp = time(nullptr);
+            sendNotification(event);
+            continue;
+        }
 
-    // Если текущее значение больше не нарушает порог, который вызвал эту тревогу
-    // Проверяем, нарушен ли порог
-    const bool still_violating = (
-        (level == AlarmLevel::MIN && current_value <= threshold) ||
-        ((level == AlarmLevel::DANGEROUS || level == AlarmLevel::CRITICAL) && current_value >= threshold)
-    );
+        // Значение вернулось в норму раньше, чем пришло событие NORMAL (или оно потерялось)
+        taskENTER_CRITICAL(&_alarmMux);
+        const bool released = slot.used && slot.generation == generation;
+        if (released) {
+            unlink(index);
+            slot.used = false;
+        }
+        taskEXIT_CRITICAL(&_alarmMux);
+        if (released && event.sensor != nullptr) {
+            ESP_LOGI(TAG, "Timer check: Sensor %s recovered (Val: %.2f). Re-notification stopped.",
+                     event.sensor->getName().c_str(), event.current_value);
+        }
+    }
+}
 
-    if (!still_violating) {
-        ESP_LOGI(self->TAG, "Timer check: Sensor %s recovered (Val: %.2f). Stopping timer.",
-                 self->_lastActiveAlarm.sensor->getName().c_str(), current_value);
-        self->_isAlarmActive = false;
-        xTimerStop(xTimer, 0);
-        return;
+bool NotificationSubscriber::isStillViolating(AlarmEvent& event) {
+    // Правило само по себе не перепроверяется: оно остается в тревоге до события NORMAL
+    if (event.cause == AlarmCause::RULE) {
+        return true;
+    }
+    if (event.sensor == nullptr) {
+        return false;
+    }
+
+    // Для тревоги по скорости сравниваем наклон истории (°C/мин), а не само значение
+    event.current_value = event.cause == AlarmCause::RATE_OF_CHANGE
+        ? event.sensor->getHistory().getTrend().slopePerMin
+        : event.sensor->getData();
+    if (event.cause == AlarmCause::SENSOR_FAILURE) {
+        return !event.sensor->isDataValid();
     }
 
-    AlarmEvent currentEvent = self->_lastActiveAlarm;
-    currentEvent.current_value = current_value;
-    self->sendNotification(currentEvent);
+    const float threshold = event.threshold_value;
+    return (event.level == AlarmLevel::MIN && event.current_value <= threshold) ||
+           ((event.level == AlarmLevel::DANGEROUS || event.level == AlarmLevel::CRITICAL) &&
+            event.current_value >= threshold);
 }
 
 void NotificationSubscriber::sendNotification(const AlarmEvent& event) const
@@ -189,7 +263,18 @@ void NotificationSubscriber::sendNotification(const AlarmEvent& event) const
     // (на основе символического порога).
     const bool is_sensor_failure = (event.level == AlarmLevel::CRITICAL && event.threshold_value < -998.0f);
 
-    if (is_sensor_failure) {
+    if (event.cause == AlarmCause::RULE) {
+        // Сообщение о СОСТАВНОМ ПРАВИЛЕ: датчика нет, значение - результат выражения
+        snprintf(message_buffer, sizeof(message_buffer),
+                 "%s: Правило '%s' сработало! Value: %.2f",
+                 level_str, event.rule_name, event.current_value);
+    } else if (event.cause == AlarmCause::RATE_OF_CHANGE) {
+        // Сообщение о БЫСТРОМ РОСТЕ: значения события - в °C/мин
+        snprintf(message_buffer, sizeof(message_buffer),
+                 "%s: Быстрый рост! Датчик '%s': %.2f C/мин (порог %.2f), T=%.2f",
+                 level_str, event.sensor->getName().c_str(), event.current_value, event.threshold_value,
+                 event.sensor->getData());
+    } else if (is_sensor_failure) {
         // Сообщение о СБОЕ ДАТЧИКА
         snprintf(message_buffer, sizeof(message_buffer),
             "%s: КРИТИЧЕСКИЙ СБОЙ! Датчик '%s' неисправен или отключен. Value: %.2f",
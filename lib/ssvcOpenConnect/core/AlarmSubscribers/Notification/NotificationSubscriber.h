@@ -25,6 +25,14 @@
 #include "NotificationService.h"
 #include <freertos/timers.h>
 
+/**
+ * @brief Уведомления о тревогах с повторами для каждого источника отдельно.
+ *
+ * Каждый датчик (или правило) в тревоге занимает слот в колесе таймеров: ячейка колеса -
+ * секунда, слот лежит в ячейке своего следующего повтора. Один периодический таймер FreeRTOS
+ * раз в WHEEL_TICK_MS обходит только текущую ячейку, поэтому стоимость тика не зависит
+ * от числа активных тревог. Интервал повтора зависит от уровня тревоги.
+ */
 class NotificationSubscriber final : public IAlarmSubscriber {
 public:
     // Измените конструктор для приема указателя на ESP32SvelteKit
@@ -34,19 +42,45 @@ public:
     void forceResetAlarm() override;
 
 private:
-    // Интервал повторного уведомления
-    static constexpr TickType_t RE_NOTIFICATION_INTERVAL_MS = 10000 / portTICK_PERIOD_MS;
+    static constexpr uint32_t WHEEL_TICK_MS = 1000;
+    static constexpr size_t WHEEL_SIZE = 64;   // Ячеек: больше самого длинного интервала повтора
+    static constexpr size_t MAX_TRACKED = 24;  // Одновременно отслеживаемых тревог
+
+    // Интервалы повтора в тиках колеса
+    static constexpr uint32_t CRITICAL_INTERVAL_TICKS = 10;
+    static constexpr uint32_t DANGEROUS_INTERVAL_TICKS = 30;
+    static constexpr uint32_t MIN_INTERVAL_TICKS = 60;
+    static_assert(MIN_INTERVAL_TICKS < WHEEL_SIZE, "A re-notification must fit into one wheel turn");
 
     ESP32SvelteKit* _sveltekit; // Сохраняем указатель для использования в onAlarm
     static constexpr auto TAG = "ALARM_LOGGER";
 
-    TimerHandle_t _reAlarmTimer = nullptr; // Хэндл таймера FreeRTOS
-    AlarmEvent _lastActiveAlarm{};           // Сохраняем последнее активное событие тревоги
-    bool _isAlarmActive = false;           // Флаг, что тревога активна (уровень != NORMAL)
+    // Тревога одного источника, ожидающая повторного уведомления
+    struct ReAlarmSlot {
+        AlarmEvent event{};
+        uint32_t dueTick = 0;    // Тик следующего повтора; слот лежит в ячейке dueTick % WHEEL_SIZE
+        uint16_t generation = 0; // Меняется при каждом перевзводе: таймер не освобождает чужой слот
+        int8_t next = -1;        // Следующий слот той же ячейки, -1 - конец списка
+        bool used = false;
+    };
+
+    TimerHandle_t _wheelTimer = nullptr;
+    ReAlarmSlot _slots[MAX_TRACKED];
+    int8_t _wheel[WHEEL_SIZE];  // Голова списка слотов каждой ячейки
+    uint32_t _tick = 0;
+    portMUX_TYPE _alarmMux = portMUX_INITIALIZER_UNLOCKED; // Слоты и колесо: задача рассылки против таймера
+
+    static void wheelTimerCallback(TimerHandle_t xTimer);
+    void onWheelTick();
+
+    // Операции над колесом - только под _alarmMux
+    int findSlot(const AlarmEvent& event) const;
+    void link(int index);
+    void unlink(int index);
+    static uint32_t intervalTicks(AlarmLevel level);
 
-    // Статическая функция-коллбэк для таймера FreeRTOS
-    static void reAlarmTimerCallback(TimerHandle_t xTimer); // <-- Должен принимать TimerHandle_t
-    void reAlarmTimerAction() const;
+    // Обновляет current_value события по актуальным данным и проверяет, нарушен ли еще порог
+    static bool isStillViolating(AlarmEvent& event);
 
     // Вспомогательный метод для отправки фактического уведомления
     void sendNotification(const AlarmEvent& event) const;
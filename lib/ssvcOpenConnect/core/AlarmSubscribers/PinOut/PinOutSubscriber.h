@@ -34,6 +34,9 @@ public:
  ~PinOutSubscriber() override;
  void onAlarm(const AlarmEvent& event) override;
  void forceResetAlarm() override;
+ // Переключение пинов - мгновенно, прямо из цикла проверки и раньше остальных
+ AlarmDelivery getDelivery() const override { return AlarmDelivery::SYNC; }
+ uint8_t getDeliveryPriority() const override { return 0; }
 
 private:
  static constexpr int DANGEROUS_PIN = GPIO_NUM_11;
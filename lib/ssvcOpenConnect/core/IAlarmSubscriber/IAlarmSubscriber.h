@@ -20,14 +20,33 @@
 
 #include "components/sensors/AbstractSensor/AbstractSensor.h"
 #include "core/StatefulServices/AlarmThresholdService/AlarmThresholdService.h" // Для AlarmLevel
+#include "core/AlarmRules/AlarmRuleProgram.h" // Для ALARM_RULE_NAME_LENGTH
+
+// Причина, по которой датчик перешел на уровень тревоги
+enum class AlarmCause {
+    THRESHOLD,      // Значение пересекло порог min/dangerous/critical
+    RATE_OF_CHANGE, // Скорость роста превысила max_rate (current/threshold - в °C/мин)
+    SENSOR_FAILURE, // Нет валидных данных (threshold_value = -999)
+    RULE            // Составное правило (sensor = nullptr, current_value - результат выражения)
+};
 
 // Структура, описывающая событие тревоги
 struct AlarmEvent {
-    const AbstractSensor* sensor; // Указатель на сам датчик
+    const AbstractSensor* sensor; // Указатель на сам датчик; nullptr для событий правил
     float current_value;
     float threshold_value;
     AlarmLevel level;
     time_t timestamp;
+    AlarmCause cause = AlarmCause::THRESHOLD;
+    // Только для cause == RULE: номер правила в AlarmRulesService и его имя
+    uint8_t rule_index = 0;
+    char rule_name[ALARM_RULE_NAME_LENGTH] = {};
+};
+
+// Способ доставки событий подписчику
+enum class AlarmDelivery {
+    SYNC,  // Прямо из цикла проверки: только для быстрых действий без ожидания (GPIO, постановка в очередь)
+    ASYNC  // Из задачи рассылки AlarmMonitor: сеть, флеш и все, что может блокироваться
 };
 
 // Абстрактный класс (интерфейс) для всех подписчиков
@@ -39,6 +58,11 @@ public:
 
     virtual void forceResetAlarm() {}
 
+    virtual AlarmDelivery getDelivery() const { return AlarmDelivery::ASYNC; }
+
+    // Порядок доставки одного события: меньшее значение получает событие раньше
+    virtual uint8_t getDeliveryPriority() const { return 128; }
+
 };
 
 #endif //SSVC_OPEN_CONNECT_IALARMSUBSCRIBER_H
@@ -41,6 +41,7 @@ void SsvcOpenConnect::begin(PsychicHttpServer& server,
     _telegramSettingsService = new TelegramSettingsService(_server, _esp32sveltekit);
     TelegramSettingsService::setInstance(_telegramSettingsService);
     _alarmThresholdService = new AlarmThresholdService(_server, _esp32sveltekit);
+    _alarmRulesService = new AlarmRulesService(_server, _esp32sveltekit);
     _sensorDataService = new SensorDataService(_server, _esp32sveltekit);
     SensorDataService::setInstance(_sensorDataService);
     _sensorConfigService = new SensorConfigService(_server, _esp32sveltekit);
@@ -59,17 +60,24 @@ void SsvcOpenConnect::begin(PsychicHttpServer& server,
     // Теперь вызываем begin() для остальных сервисов
     _telegramSettingsService->begin();
     _alarmThresholdService->begin();
+    _alarmRulesService->begin();
     _sensorDataService->begin();
     _sensorConfigService->begin();
 
-    AlarmMonitor::getInstance().initialize(_alarmThresholdService);
+    AlarmMonitor::getInstance().initialize(_alarmThresholdService, _alarmRulesService);
 
-    SensorCoordinator::getInstance().registerPollingSubsystem(
-        &OneWireThermalSubsystem::getInstance()
-    );
+    // Каждая шина 1-Wire (ONEWIRE_BUS_PINS) - отдельная подсистема со своей задачей
+    for (OneWireThermalSubsystem* bus : OneWireThermalSubsystem::createBuses()) {
+        SensorCoordinator::getInstance().registerPollingSubsystem(bus);
+    }
     SensorCoordinator::getInstance().startPolling(SENSOR_POLL_INTERVAL_MS);
 
     _sensorConfigService->addUpdateHandler([&](const String& originId) {
+        // Разрешения и фильтры, пришедшие через /rest/zones или MQTT, отдаем задаче шины и фильтрам датчиков
+        _sensorConfigService->read([](const SensorConfigState& state) {
+            state.applyResolutionsToSensors();
+            state.applyFiltersToSensors();
+        });
         _sensorDataService->triggerZoneDataRecalculation();
         AlarmMonitor::getInstance().checkAllSensors();
     });
@@ -81,6 +89,7 @@ void SsvcOpenConnect::begin(PsychicHttpServer& server,
 
     _notificationSubscriber = new NotificationSubscriber(_esp32sveltekit);
     _pinOutSubscriber = new PinOutSubscriber();
+    AlarmJournal::getInstance().begin(_esp32sveltekit->getFS());
 
     rProcess.begin(
       _ssvcConnector, _ssvcSettings, *_ssvcMqttSettingsService);
@@ -20,6 +20,7 @@
 #include "core/StatefulServices/SensorDataService/SensorDataService.h"
 #include "core/StatefulServices/TelemetryService/TelemetryService.h"
 #include "core/StatefulServices/TelegramSettingsService/TelegramSettingsService.h"
+#include "core/StatefulServices/AlarmRulesService/AlarmRulesService.h"
 #include "components/Led/StatusLed.h"
 
 
@@ -30,6 +31,7 @@
 
 #include "core/AlarmSubscribers/Notification//NotificationSubscriber.h"
 #include "core/AlarmSubscribers/PinOut/PinOutSubscriber.h"
+#include "core/AlarmSubscribers/Journal/AlarmJournal.h"
 #include "components/sensors/SensorCoordinator/SensorCoordinator.h"
 #include "external/MqttBridge/MqttBridge.h"
 
@@ -70,6 +72,7 @@ private:
   SensorDataService* _sensorDataService = nullptr;
   SsvcMqttSettingsService* _ssvcMqttSettingsService = nullptr;
   AlarmThresholdService* _alarmThresholdService = nullptr;
+  AlarmRulesService* _alarmRulesService = nullptr;
   SensorConfigService* _sensorConfigService = nullptr;
   TelemetryService* _telemetryService = nullptr;
   ProfileService* _profileService = nullptr;
@@ -0,0 +1,120 @@
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include "AlarmRulesService.h"
+
+
+static auto TAG = "ALARM_RULES_SVC";
+
+static const char* levelToString(const AlarmLevel level) {
+    switch (level) {
+    case AlarmLevel::MIN: return "min";
+    case AlarmLevel::CRITICAL: return "critical";
+    default: return "dangerous";
+    }
+}
+
+static AlarmLevel levelFromString(const char* name) {
+    if (name != nullptr && strcmp(name, "min") == 0) {
+        return AlarmLevel::MIN;
+    }
+    if (name != nullptr && strcmp(name, "critical") == 0) {
+        return AlarmLevel::CRITICAL;
+    }
+    return AlarmLevel::DANGEROUS;
+}
+
+static bool areRulesEqual(const AlarmRule& a, const AlarmRule& b) {
+    return a.name == b.name &&
+           a.expr == b.expr &&
+           a.level == b.level &&
+           a.enabled == b.enabled &&
+           a.debounce == b.debounce;
+}
+
+void AlarmRulesState::read(const AlarmRulesState& state, const JsonObject& root) {
+    const auto rules = root["rules"].to<JsonArray>();
+    for (const AlarmRule& rule : state.rules) {
+        auto obj = rules.add<JsonObject>();
+        obj["name"] = rule.name;
+        obj["expr"] = rule.expr;
+        obj["level"] = levelToString(rule.level);
+        obj["enabled"] = rule.enabled;
+        obj["debounce"] = rule.debounce;
+        if (!rule.error.empty()) {
+            obj["error"] = rule.error;
+        }
+    }
+}
+
+StateUpdateResult AlarmRulesState::update(const JsonObject& root, AlarmRulesState& state) {
+    if (!root["rules"].is<JsonArray>()) {
+        ESP_LOGW(TAG, "UPDATE rejected: 'rules' field is missing or not a JSON array.");
+        return StateUpdateResult::ERROR;
+    }
+    const JsonArray incoming = root["rules"];
+    if (incoming.size() > MAX_RULES) {
+        ESP_LOGW(TAG, "UPDATE rejected: %zu rules, at most %zu allowed.",
+                 incoming.size(), static_cast<size_t>(MAX_RULES));
+        return StateUpdateResult::ERROR;
+    }
+
+    std::vector<AlarmRule> rules;
+    rules.reserve(incoming.size());
+    for (JsonVariant item : incoming) {
+        if (!item.is<JsonObject>()) {
+            ESP_LOGW(TAG, "Rule skipped: not a JSON object.");
+            continue;
+        }
+        AlarmRule rule;
+        rule.name = item["name"] | "";
+        rule.expr = item["expr"] | "";
+        rule.level = levelFromString(item["level"] | "dangerous");
+        rule.enabled = item["enabled"] | true;
+        rule.debounce = static_cast<uint8_t>(std::min(std::max(item["debounce"] | 2, 1), 10));
+
+        if (rule.name.empty()) {
+            rule.name = "rule" + std::to_string(rules.size() + 1);
+        }
+        // Имя уходит в AlarmEvent фиксированным буфером
+        if (rule.name.size() >= ALARM_RULE_NAME_LENGTH) {
+            size_t length = ALARM_RULE_NAME_LENGTH - 1;
+            // Не разрезаем многобайтовый символ UTF-8
+            while (length > 0 && (static_cast<uint8_t>(rule.name[length]) & 0xC0) == 0x80) {
+                length--;
+            }
+            rule.name.resize(length);
+        }
+
+        if (!AlarmRuleProgram::compile(rule.expr, rule.program, rule.error)) {
+            ESP_LOGW(TAG, "Rule '%s' is not compiled: %s.", rule.name.c_str(), rule.error.c_str());
+        }
+        rules.push_back(std::move(rule));
+    }
+
+    bool changed = rules.size() != state.rules.size();
+    for (size_t i = 0; !changed && i < rules.size(); i++) {
+        changed = !areRulesEqual(rules[i], state.rules[i]);
+    }
+    if (!changed) {
+        return StateUpdateResult::UNCHANGED;
+    }
+
+    state.rules.swap(rules);
+    ESP_LOGI(TAG, "Alarm rules updated: %zu rules.", state.rules.size());
+    return StateUpdateResult::CHANGED;
+}
@@ -0,0 +1,98 @@
+#ifndef SSVC_OPEN_CONNECT_ALARMRULESSERVICE_H
+#define SSVC_OPEN_CONNECT_ALARMRULESSERVICE_H
+
+/**
+*   SSVC Open Connect
+ *
+ *   A firmware for ESP32 to interface with SSVC 0059 distillation controller
+ *   via UART protocol. Features a responsive SvelteKit web interface for
+ *   monitoring and controlling the distillation process.
+ *   https://github.com/SSVC0059/ssvc_open_connect
+ *
+ *   Copyright (C) 2024 SSVC Open Connect Contributors
+ *
+ *   This software is independent and not affiliated with SSVC0059 company.
+ *   All Rights Reserved. This software may be modified and distributed under
+ *   the terms of the LGPL v3 license. See the LICENSE file for details.
+ *
+ *   Disclaimer: Use at your own risk. High voltage safety precautions required.
+ **/
+
+#include <string>
+#include <vector>
+
+#include "ArduinoJson.h"
+
+#include "ESP32SvelteKit.h"
+#include "StatefulService.h"
+
+#include "core/AlarmRules/AlarmRuleProgram.h"
+#include "core/StatefulServices/AlarmThresholdService/AlarmThresholdService.h" // Для AlarmLevel
+
+#define ALARM_RULES_ENDPOINT "/rest/alarms/rules"
+#define ALARM_RULES_FILE "/config/alarm_rules.json"
+
+/**
+ * @brief Составное правило тревоги: выражение над зонами и телеметрией контроллера.
+ * Правило срабатывает (переходит на level), пока выражение истинно.
+ */
+struct AlarmRule {
+    std::string name;
+    std::string expr;
+    AlarmLevel level = AlarmLevel::DANGEROUS;
+    bool enabled = true;
+    // Сколько подряд идущих проверок выражение должно быть истинным (ложным), чтобы тревога была принята (снята)
+    uint8_t debounce = 2;
+
+    // Результат компиляции expr: пустая программа и текст ошибки, если выражение неверно
+    AlarmRuleProgram program;
+    std::string error;
+
+    bool isActive() const { return enabled && error.empty(); }
+};
+
+class AlarmRulesState {
+public:
+    static constexpr size_t MAX_RULES = 16;
+
+    std::vector<AlarmRule> rules;
+
+    static void read(const AlarmRulesState& state, const JsonObject& root);
+
+    /**
+     * @brief Заменяет список правил и компилирует выражения.
+     * Правила с ошибкой сохраняются (с полем "error" в ответе), но не вычисляются.
+     */
+    static StateUpdateResult update(const JsonObject& root, AlarmRulesState& state);
+};
+
+class AlarmRulesService : public StatefulService<AlarmRulesState> {
+public:
+    AlarmRulesService(PsychicHttpServer* server, ESP32SvelteKit* sveltekit) :
+        _httpEndpoint(
+            AlarmRulesState::read,
+            AlarmRulesState::update,
+            this,
+            server,
+            ALARM_RULES_ENDPOINT,
+            sveltekit->getSecurityManager()
+            ),
+        _fsPersistence(AlarmRulesState::read,
+            AlarmRulesState::update,
+            this,
+            sveltekit->getFS(),
+            ALARM_RULES_FILE)
+    {
+    }
+
+    void begin() {
+        _fsPersistence.readFromFS();
+        _httpEndpoint.begin();
+    }
+
+private:
+    HttpEndpoint<AlarmRulesState> _httpEndpoint;
+    FSPersistence<AlarmRulesState> _fsPersistence;
+};
+
+#endif //SSVC_OPEN_CONNECT_ALARMRULESSERVICE_H
@@ -32,7 +32,10 @@ static bool areThresholdsEqual(const ThresholdSettings& a, const ThresholdSettin
     return a.enabled == b.enabled &&
            (std::abs(a.min_threshold - b.min_threshold) < EPSILON) &&
            (std::abs(a.dangerous_threshold - b.dangerous_threshold) < EPSILON) &&
-           (std::abs(a.critical_threshold - b.critical_threshold) < EPSILON);
+           (std::abs(a.critical_threshold - b.critical_threshold) < EPSILON) &&
+           (std::abs(a.hysteresis - b.hysteresis) < EPSILON) &&
+           a.debounce == b.debounce &&
+           (std::abs(a.max_rate - b.max_rate) < EPSILON);
 }
 
 // Читает состояние в JSON для отправки клиенту или сохранения
@@ -44,13 +47,15 @@ void AlarmThresholdsState::read(const AlarmThresholdsState& state, const JsonObj
     const auto thresholds = root["thresholds"].to<JsonObject>();
 
     int count = 0;
+    char addressHex[SENSOR_ID_HEX_LENGTH + 1];
     for (const auto& pair : state.sensor_thresholds) {
+        sensorIdToHex(pair.first, addressHex);
         // Создаем объект для настроек каждого датчика
-        auto sensor_obj = thresholds[pair.first].to<JsonObject>();
+        auto sensor_obj = thresholds[static_cast<const char*>(addressHex)].to<JsonObject>();
         // Сериализуем данные
         pair.second.toJson(sensor_obj);
         ESP_LOGD(TAG, "Serializing settings for sensor %s: Enabled=%s, Critical=%.2f",
-                 pair.first.c_str(), pair.second.enabled ? "True" : "False", pair.second.critical_threshold);
+                 addressHex, pair.second.enabled ? "True" : "False", pair.second.critical_threshold);
         count++;
     }
     ESP_LOGI(TAG, "Finished JSON serialization. Total sensors serialized: %d", count);
@@ -74,20 +79,23 @@ StateUpdateResult AlarmThresholdsState::update(const JsonObject& root, AlarmThre
     bool changed = false;
     const JsonObject thresholds = root["thresholds"];
 
-    // 1. Создаем временный набор для хранения адресов датчиков из входящего JSON
-    std::set<std::string> incoming_addresses;
     int updated_count = 0;
 
-    // 2. Обрабатываем входящие данные: обновляем/добавляем настройки и заполняем incoming_addresses
+    // Обрабатываем входящие данные: обновляем/добавляем настройки
     for (JsonPair kv : thresholds) {
         if (kv.value().is<JsonObject>()) {
-            std::string sensor_addr = kv.key().c_str();
+            const char* sensor_addr = kv.key().c_str();
+            SensorId sensor_id;
+            if (!sensorIdFromHex(sensor_addr, kv.key().size(), sensor_id)) {
+                ESP_LOGW(TAG, "Key '%s' update skipped: Not a 16-character hex sensor address.", sensor_addr);
+                continue;
+            }
 
             // Если это НЕ ранний boot (система полностью инициализирована)
             // И датчик НЕ зарегистрирован, тогда пропускаем обновление.
             // В случае isEarlyBoot == true, мы загружаем настройки в любом случае.
-            if (!isEarlyBoot && !SensorManager::getInstance().isSensorRegistered(sensor_addr)) {
-                ESP_LOGW(TAG, "Sensor %s update skipped: Not registered in SensorManager.", sensor_addr.c_str());
+            if (!isEarlyBoot && !SensorManager::getInstance().isSensorRegistered(sensor_id)) {
+                ESP_LOGW(TAG, "Sensor %s update skipped: Not registered in SensorManager.", sensor_addr);
                 continue; // Пропускаем, если система уже загружена, но датчик отсутствует
             }
             // -----------------------------------------------------------
@@ -95,33 +103,27 @@ StateUpdateResult AlarmThresholdsState::update(const JsonObject& root, AlarmThre
             const JsonObject settings_obj = kv.value().as<JsonObject>();
             if (!settings_obj.isNull()) {
 
-                // Включаем адрес в список, только если это не ранний бут.
-                // Во время раннего бута этот список не нужен для очистки.
-                if (!isEarlyBoot) {
-                   incoming_addresses.insert(sensor_addr);
-                }
-
                 const ThresholdSettings new_settings = ThresholdSettings::fromJson(settings_obj);
-                auto it = state.sensor_thresholds.find(sensor_addr);
+                auto it = state.sensor_thresholds.find(sensor_id);
 
                 if (isEarlyBoot) {
                     // НА РАННЕМ БУТЕ: Мы просто восстанавливаем состояние из файла.
                     // Не устанавливаем changed = true, чтобы избежать записи в ФС.
-                    state.sensor_thresholds[sensor_addr] = new_settings;
+                    state.sensor_thresholds[sensor_id] = new_settings;
                     updated_count++;
                 }
                 else if (it == state.sensor_thresholds.end() || !areThresholdsEqual(it->second, new_settings)) {
                     // В ОБЫЧНОМ РЕЖИМЕ: Настройки изменились или это новый датчик -> обновляем состояние и ставим changed
-                    state.sensor_thresholds[sensor_addr] = new_settings;
+                    state.sensor_thresholds[sensor_id] = new_settings;
                     changed = true;
                     updated_count++;
-                    ESP_LOGD(TAG, "Sensor %s settings CHANGED/ADDED. Crit: %.2f", sensor_addr.c_str(), new_settings.critical_threshold);
+                    ESP_LOGD(TAG, "Sensor %s settings CHANGED/ADDED. Crit: %.2f", sensor_addr, new_settings.critical_threshold);
                 } else {
                     // В ОБЫЧНОМ РЕЖИМЕ: Настройки не изменились -> пропускаем
-                    ESP_LOGV(TAG, "Sensor %s settings UNCHANGED.", sensor_addr.c_str());
+                    ESP_LOGV(TAG, "Sensor %s settings UNCHANGED.", sensor_addr);
                 }
             } else {
-                ESP_LOGW(TAG, "Sensor %s update skipped: Settings object is null.", sensor_addr.c_str());
+                ESP_LOGW(TAG, "Sensor %s update skipped: Settings object is null.", sensor_addr);
             }
 
         } else {
@@ -136,14 +138,14 @@ StateUpdateResult AlarmThresholdsState::update(const JsonObject& root, AlarmThre
     if (!isEarlyBoot)
     {
         for (auto it = state.sensor_thresholds.begin(); it != state.sensor_thresholds.end(); ) {
-            const std::string& current_addr = it->first;
-
             // Проверяем, если датчик отключен (не зарегистрирован)
-            const bool unregistered = !SensorManager::getInstance().isSensorRegistered(current_addr);
+            const bool unregistered = !SensorManager::getInstance().isSensorRegistered(it->first);
 
-            // Очищаем, если он не зарегистрирован ИЛИ отсутствует во входящем запросе (только не в режиме раннего бута)
+            // Очищаем, если он не зарегистрирован (только не в режиме раннего бута)
             if (unregistered) {
-                ESP_LOGW(TAG, "Sensor %s deleted: Absent from request OR unregistered.", current_addr.c_str());
+                char current_addr[SENSOR_ID_HEX_LENGTH + 1];
+                sensorIdToHex(it->first, current_addr);
+                ESP_LOGW(TAG, "Sensor %s deleted: Absent from request OR unregistered.", current_addr);
                 it = state.sensor_thresholds.erase(it);
                 changed = true;
                 deleted_count++;
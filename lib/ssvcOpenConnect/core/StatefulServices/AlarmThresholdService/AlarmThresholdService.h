@@ -20,6 +20,7 @@
 
 #include <string>
 #include <map>
+#include <algorithm>
 #include <set>
 
 #include "ArduinoJson.h"
@@ -48,6 +49,14 @@ struct ThresholdSettings {
     float min_threshold = 0.0f;
     float dangerous_threshold = 50.0f;
     float critical_threshold = 80.0f;
+    // Полоса возврата: уровень снимается, только когда значение отошло от порога
+    // на hysteresis (вниз для DANGEROUS/CRITICAL, вверх для MIN)
+    float hysteresis = 0.0f;
+    // Сколько подряд идущих отсчетов должны дать новый уровень, прежде чем он будет принят
+    uint8_t debounce = 1;
+    // Предельная скорость роста, °C/мин (наклон регрессии по истории датчика); 0 - не контролируется.
+    // Превышение поднимает уровень DANGEROUS раньше, чем будет пересечен абсолютный порог.
+    float max_rate = 0.0f;
 
     // Функция для сериализации в JSON
     void toJson(const JsonObject& obj) const {
@@ -55,6 +64,9 @@ struct ThresholdSettings {
         obj["min"] = min_threshold;
         obj["dangerous"] = dangerous_threshold;
         obj["critical"] = critical_threshold;
+        obj["hysteresis"] = hysteresis;
+        obj["debounce"] = debounce;
+        obj["max_rate"] = max_rate;
     }
 
     // Функция для десериализации из JSON
@@ -64,15 +76,21 @@ struct ThresholdSettings {
         settings.min_threshold = obj["min"] | 0.0f;
         settings.dangerous_threshold = obj["dangerous"] | 80.0f;
         settings.critical_threshold = obj["critical"] | 100.0f;
+        // Пороги, сохраненные прежней прошивкой, не содержат этих ключей: для них сохраняется
+        // прежнее поведение - уровень меняется сразу по первому отсчету и без полосы возврата.
+        // Отрицательная полоса сделала бы уровень "липким" с обратной стороны
+        settings.hysteresis = std::max(0.0f, obj["hysteresis"] | 0.0f);
+        settings.debounce = static_cast<uint8_t>(std::min(std::max(obj["debounce"] | 1, 1), 10));
+        settings.max_rate = std::max(0.0f, obj["max_rate"] | 0.0f);
         return settings;
     }
 };
 
 // Класс состояния, который будет управляться StatefulService
-// Хранит карту: "адрес_датчика" -> ThresholdSettings
+// Хранит карту: SensorId -> ThresholdSettings (в JSON ключ - hex-адрес датчика)
 class AlarmThresholdsState {
 public:
-    std::map<std::string, ThresholdSettings> sensor_thresholds;
+    SensorIdMap<ThresholdSettings> sensor_thresholds;
 
     // --- Функции для интеграции с StatefulService ---
     // Читает состояние в JSON для отправки клиенту или сохранения
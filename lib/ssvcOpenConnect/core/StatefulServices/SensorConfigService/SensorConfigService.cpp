@@ -1,4 +1,6 @@
 #include "SensorConfigService.h"
+#include <algorithm>
+#include "components/sensors/OneWireThermalSubsystem/OneWireThermalSubsystem.h"
 
 /**
 *   SSVC Open Connect
@@ -17,11 +19,39 @@
  *   Disclaimer: Use at your own risk. High voltage safety precautions required.
  **/
 
+// Набор адресов из входящего JSON (датчиков немного, линейный поиск достаточен)
+static bool containsId(const std::vector<SensorId>& ids, const SensorId id) {
+    return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+
 void SensorConfigState::read(const SensorConfigState& state, const JsonObject& root) {
+    char addressHex[SENSOR_ID_HEX_LENGTH + 1];
+
     // Создаем вложенный объект "zones"
     const auto zones_obj = root["zones"].to<JsonObject>();
     for (const auto& pair : state.sensor_zones) {
-        zones_obj[pair.first] = static_cast<int>(pair.second);
+        sensorIdToHex(pair.first, addressHex);
+        zones_obj[static_cast<const char*>(addressHex)] = static_cast<int>(pair.second);
+    }
+
+    const auto resolutions_obj = root["resolutions"].to<JsonObject>();
+    for (const auto& pair : state.sensor_resolutions) {
+        sensorIdToHex(pair.first, addressHex);
+        resolutions_obj[static_cast<const char*>(addressHex)] = pair.second;
+    }
+
+    const auto filters_obj = root["filters"].to<JsonObject>();
+    for (size_t i = 0; i < SENSOR_ZONE_COUNT; i++) {
+        const SensorFilterSettings& settings = state.zone_filters[i];
+        const auto zone = static_cast<SensorZone>(i);
+        if (settings.isPassThrough() || zone == SensorZone::DELETED) {
+            continue;
+        }
+        const std::string zoneName = SensorZoneHelper::toString(zone);
+        const auto filter_obj = filters_obj[zoneName.c_str()].to<JsonObject>();
+        filter_obj["median"] = settings.medianWindow;
+        filter_obj["ema_alpha"] = settings.emaAlpha;
+        filter_obj["max_step"] = settings.maxStep;
     }
 }
 StateUpdateResult SensorConfigState::update(const JsonObject& root, SensorConfigState& state){
@@ -29,17 +59,33 @@ StateUpdateResult SensorConfigState::update(const JsonObject& root, SensorConfig
     // Определяем фазу загрузки: если SensorManager пуст, то это, скорее всего, ранний boot.
     const bool isEarlyBoot = SensorManager::getInstance().getRegisteredSensorCount() == 0;
 
-    if (!root["zones"].is<JsonObject>()) return StateUpdateResult::UNCHANGED;
-
     bool changed = false;
+
+    // Разрешения и фильтры обрабатываются независимо: запрос может содержать только "zones"
+    if (root["resolutions"].is<JsonObject>()) {
+        changed |= updateResolutions(root["resolutions"], state, isEarlyBoot);
+    }
+    if (root["filters"].is<JsonObject>()) {
+        changed |= updateFilters(root["filters"], state);
+    }
+
+    if (!root["zones"].is<JsonObject>()) {
+        return changed ? StateUpdateResult::CHANGED : StateUpdateResult::UNCHANGED;
+    }
+
     const JsonObject zones = root["zones"];
 
     // 1. Создаем временный набор для входящих адресов
-    std::set<std::string> incoming_addresses;
+    std::vector<SensorId> incoming_addresses;
 
     // 2. Обновление/добавление зон
     for (JsonPair kv : zones) {
-        const std::string addr_str = kv.key().c_str();
+        const char* addr_str = kv.key().c_str();
+        SensorId sensor_id;
+        if (!sensorIdFromHex(addr_str, kv.key().size(), sensor_id)) {
+            ESP_LOGW(TAG, "Invalid sensor address received: %s", addr_str);
+            continue;
+        }
         auto newZone = SensorZone::UNKNOWN;
         bool validZone = false;
 
@@ -59,17 +105,18 @@ StateUpdateResult SensorConfigState::update(const JsonObject& root, SensorConfig
             } catch (const std::invalid_argument& e) {
                 // Логгирование ошибки, если строка зоны недействительна
                 ESP_LOGW(TAG, "Invalid zone name received for %s: %s",
-                         addr_str.c_str(), zoneName.c_str());
+                         addr_str, zoneName.c_str());
             }
         }
 
         if (validZone) {
             // Проверка на фактическое изменение перед установкой 'changed = true'
-            if (state.sensor_zones.count(addr_str) == 0 || state.sensor_zones.at(addr_str) != newZone) {
-                state.sensor_zones[addr_str] = newZone;
+            const auto it = state.sensor_zones.find(sensor_id);
+            if (it == state.sensor_zones.end() || it->second != newZone) {
+                state.sensor_zones[sensor_id] = newZone;
                 changed = true; // Зона изменилась, отмечаем для сохранения!
             }
-            incoming_addresses.insert(addr_str);
+            incoming_addresses.push_back(sensor_id);
         }
     }
 
@@ -79,15 +126,15 @@ StateUpdateResult SensorConfigState::update(const JsonObject& root, SensorConfig
     {
         int deleted_count = 0;
         for (auto it = state.sensor_zones.begin(); it != state.sensor_zones.end(); ) {
-            const std::string& current_addr = it->first;
-
             // Проверяем, если датчик отключен (не зарегистрирован) ИЛИ отсутствует во входящем запросе
-            const bool unregistered = !SensorManager::getInstance().isSensorRegistered(current_addr);
-            const bool not_in_incoming = incoming_addresses.count(current_addr) == 0;
+            const bool unregistered = !SensorManager::getInstance().isSensorRegistered(it->first);
+            const bool not_in_incoming = !containsId(incoming_addresses, it->first);
 
             if (unregistered || not_in_incoming) {
+                char current_addr[SENSOR_ID_HEX_LENGTH + 1];
+                sensorIdToHex(it->first, current_addr);
                 ESP_LOGD(TAG, "Zone %s deleted: Unregistered (%d) OR absent from request (%d).",
-                         current_addr.c_str(), unregistered, not_in_incoming);
+                         current_addr, unregistered, not_in_incoming);
                 it = state.sensor_zones.erase(it);
                 changed = true;
                 deleted_count++;
@@ -103,44 +150,172 @@ StateUpdateResult SensorConfigState::update(const JsonObject& root, SensorConfig
     return StateUpdateResult::UNCHANGED;
 }
 
+bool SensorConfigState::updateResolutions(const JsonObject& resolutions, SensorConfigState& state,
+                                          const bool isEarlyBoot) {
+    bool changed = false;
+    std::vector<SensorId> incoming_addresses;
+
+    for (JsonPair kv : resolutions) {
+        const char* addr_str = kv.key().c_str();
+        SensorId sensor_id;
+        if (!sensorIdFromHex(addr_str, kv.key().size(), sensor_id)) {
+            ESP_LOGW(TAG, "Invalid sensor address received: %s", addr_str);
+            continue;
+        }
+        if (!kv.value().is<int>()) {
+            ESP_LOGW(TAG, "Invalid resolution received for %s: not a number.", addr_str);
+            continue;
+        }
+        const int bits = kv.value().as<int>();
+        if (!DS18B20Sensor::isValidResolution(bits)) {
+            ESP_LOGW(TAG, "Invalid resolution received for %s: %d bit.", addr_str, bits);
+            continue;
+        }
+
+        const auto it = state.sensor_resolutions.find(sensor_id);
+        if (it == state.sensor_resolutions.end() || it->second != bits) {
+            state.sensor_resolutions[sensor_id] = static_cast<uint8_t>(bits);
+            changed = true;
+        }
+        incoming_addresses.push_back(sensor_id);
+    }
+
+    // Та же политика удаления, что и для зон: только после загрузки датчиков
+    if (!isEarlyBoot) {
+        for (auto it = state.sensor_resolutions.begin(); it != state.sensor_resolutions.end(); ) {
+            if (!SensorManager::getInstance().isSensorRegistered(it->first) ||
+                !containsId(incoming_addresses, it->first)) {
+                it = state.sensor_resolutions.erase(it);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    return changed;
+}
+
+bool SensorConfigState::updateFilters(const JsonObject& filters, SensorConfigState& state) {
+    SensorFilterSettings incoming[SENSOR_ZONE_COUNT];
+
+    for (JsonPair kv : filters) {
+        const std::string zoneName = kv.key().c_str();
+        auto zone = SensorZone::UNKNOWN;
+        try {
+            zone = SensorZoneHelper::fromString(zoneName);
+        } catch (const std::invalid_argument& e) {
+            ESP_LOGW(TAG, "Invalid zone name in filters: %s", zoneName.c_str());
+            continue;
+        }
+        if (!kv.value().is<JsonObject>()) {
+            ESP_LOGW(TAG, "Invalid filter settings for zone %s: not an object.", zoneName.c_str());
+            continue;
+        }
+        const JsonObject filter_obj = kv.value().as<JsonObject>();
+        SensorFilterSettings& settings = incoming[static_cast<size_t>(zone)];
+
+        const int window = filter_obj["median"] | 1;
+        if (window >= 1 && window <= SensorFilterSettings::MAX_MEDIAN_WINDOW && window % 2 == 1) {
+            settings.medianWindow = static_cast<uint8_t>(window);
+        } else {
+            ESP_LOGW(TAG, "Invalid median window for zone %s: %d (odd, 1..%u).",
+                     zoneName.c_str(), window, SensorFilterSettings::MAX_MEDIAN_WINDOW);
+        }
+
+        const float alpha = filter_obj["ema_alpha"] | 1.0f;
+        if (alpha > 0.0f && alpha <= 1.0f) {
+            settings.emaAlpha = alpha;
+        } else {
+            ESP_LOGW(TAG, "Invalid EMA alpha for zone %s: %.3f (0..1].", zoneName.c_str(), alpha);
+        }
+
+        const float step = filter_obj["max_step"] | 0.0f;
+        if (step >= 0.0f) {
+            settings.maxStep = step;
+        } else {
+            ESP_LOGW(TAG, "Invalid max step for zone %s: %.2f.", zoneName.c_str(), step);
+        }
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < SENSOR_ZONE_COUNT; i++) {
+        if (state.zone_filters[i] != incoming[i]) {
+            state.zone_filters[i] = incoming[i];
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void SensorConfigState::applyFiltersToSensors() const {
+    for (size_t i = 0; i < SENSOR_ZONE_COUNT; i++) {
+        SensorFilter::setZoneSettings(static_cast<SensorZone>(i), zone_filters[i]);
+    }
+}
+
 void SensorConfigState::applyZonesToSensors() const {
     const SensorManager& sm = SensorManager::getInstance();
     int applied_count = 0;
 
     // Итерируемся по всем зонам, которые хранятся в состоянии
     for (const auto& pair : sensor_zones) {
-        const std::string& addr_str = pair.first;
-        const SensorZone zone = pair.second;
-
-        // Пытаемся преобразовать строку в адрес и применить зону
-        AbstractSensor::Address addrBytes;
-        if (SensorManager::stringToAddress(addr_str, addrBytes)) {
-            // Фактически применяем зону через SensorManager
-            if (sm.assignZone(addrBytes, zone)) {
-                applied_count++;
-            }
+        AbstractSensor* sensor = sm.getSensorById(pair.first);
+        if (sensor) {
+            sensor->setZone(pair.second);
+            applied_count++;
         }
     }
     ESP_LOGI(TAG, "[ZONE_APPLY] Applied %d saved zones to sensors.", applied_count);
 }
 
-bool SensorConfigService::setZoneForSensor(const std::string& addressStr, const SensorZone newZone) {
+void SensorConfigState::applyResolutionsToSensors() const {
+    int applied_count = 0;
+
+    for (const auto& pair : sensor_resolutions) {
+        if (OneWireThermalSubsystem::setSensorResolution(pair.first, pair.second)) {
+            applied_count++;
+        }
+    }
+    ESP_LOGI(TAG, "[RESOLUTION_APPLY] Applied %d saved resolutions to sensors.", applied_count);
+}
+
+bool SensorConfigService::setResolutionForSensor(const SensorId sensorId, const uint8_t bits) {
+    const String originId = "HTTP_RESOLUTION_UPDATE";
+
+    // Сначала передаем разрешение на шину датчика: так проверяются и адрес, и диапазон
+    if (!OneWireThermalSubsystem::setSensorResolution(sensorId, bits)) {
+        return false;
+    }
+
+    this->update([=](SensorConfigState& state) {
+        const auto it = state.sensor_resolutions.find(sensorId);
+        if (it != state.sensor_resolutions.end() && it->second == bits) {
+            return StateUpdateResult::UNCHANGED;
+        }
+        state.sensor_resolutions[sensorId] = bits;
+        return StateUpdateResult::CHANGED;
+    }, originId);
+
+    return true;
+}
+
+bool SensorConfigService::setZoneForSensor(const SensorId sensorId, const SensorZone newZone) {
     const String originId = "HTTP_ZONE_UPDATE";
 
     // Немедленно обновляем состояние живого объекта датчика (SensorManager)
-    AbstractSensor::Address addrBytes;
-    if (SensorManager::stringToAddress(addressStr, addrBytes)) {
-        (void)SensorManager::getInstance().assignZone(addrBytes, newZone);
+    if (AbstractSensor* sensor = SensorManager::getInstance().getSensorById(sensorId)) {
+        sensor->setZone(newZone);
     }
 
     const StateUpdateResult result = this->update([=](SensorConfigState& state) { // CAPTURE BY VALUE [=]
-        if (state.sensor_zones.count(addressStr) &&
-            state.sensor_zones.at(addressStr) == newZone)
+        const auto it = state.sensor_zones.find(sensorId);
+        if (it != state.sensor_zones.end() && it->second == newZone)
         {
 
             return StateUpdateResult::UNCHANGED;
         }
-        state.sensor_zones[addressStr] = newZone;
+        state.sensor_zones[sensorId] = newZone;
         return StateUpdateResult::CHANGED;
 
     }, originId);
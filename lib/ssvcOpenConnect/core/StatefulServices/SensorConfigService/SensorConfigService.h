@@ -27,6 +27,7 @@
 #include "StatefulService.h"
 #include "components/Zone/SensorZone.h"
 #include "components/sensors/SensorManager/SensorManager.h"
+#include "components/sensors/SensorFilter/SensorFilter.h"
 
 #include "core/StatefulServices/SensorConfigService/SensorConfigHelper.h"
 
@@ -36,11 +37,16 @@
 #define SENSOR_ZONE_SET_TOPIC "openconnect/sensor/set"
 /**
  * @brief Класс состояния для хранения настроек зон.
- * Хранит карту: "адрес_датчика" -> SensorZone
+ * Хранит карты: SensorId -> SensorZone и SensorId -> разрешение (бит).
+ * В JSON ключом служит hex-адрес датчика.
  */
 class SensorConfigState {
 public:
-    std::map<std::string, SensorZone> sensor_zones;
+    SensorIdMap<SensorZone> sensor_zones;
+    // Разрешение DS18B20 (9..12 бит). Датчики без записи работают с разрешением, сохраненным в них самих
+    SensorIdMap<uint8_t> sensor_resolutions;
+    // Фильтр показаний по зонам (индекс - SensorZone). В JSON - только включенные фильтры
+    SensorFilterSettings zone_filters[SENSOR_ZONE_COUNT];
 
     // Читает состояние в JSON для отправки клиенту или сохранения
     static void read(const SensorConfigState& state, const JsonObject& root);
@@ -53,7 +59,23 @@ public:
      */
     void applyZonesToSensors() const;
 
+    /**
+     * @brief Передает сохраненные разрешения в 1-Wire подсистему
+     */
+    void applyResolutionsToSensors() const;
+
+    /**
+     * @brief Передает настройки фильтров зон в общую таблицу SensorFilter
+     */
+    void applyFiltersToSensors() const;
+
 private:
+    // Обновляет карту разрешений из объекта "resolutions"
+    static bool updateResolutions(const JsonObject& resolutions, SensorConfigState& state, bool isEarlyBoot);
+
+    // Заменяет настройки фильтров из объекта "filters" (зоны без записи - без фильтра)
+    static bool updateFilters(const JsonObject& filters, SensorConfigState& state);
+
     static constexpr auto TAG = "SENSOR_ZONE_STAGE";
 };
 
@@ -94,6 +116,7 @@ public:
         _httpEndpoint.begin();
         _fsPersistence.readFromFS();
         this->read([&](const SensorConfigState& state) {
+            state.applyFiltersToSensors();
             state.applyZonesToSensors();
         });
     }
@@ -101,11 +124,19 @@ public:
     /**
      * @brief Обновляет зону для одного датчика в состоянии сервиса и
      * запускает механизм сохранения, если зона изменилась.
-     * @param addressStr Строковый адрес датчика.
+     * @param sensorId Идентификатор датчика.
      * @param newZone Новая зона.
      * @return True, если зона успешно обновлена (даже если не изменилась).
      */
-    bool setZoneForSensor(const std::string& addressStr, SensorZone newZone);
+    bool setZoneForSensor(SensorId sensorId, SensorZone newZone);
+
+    /**
+     * @brief Задает разрешение DS18B20 для одного датчика и сохраняет его.
+     * @param sensorId Идентификатор датчика.
+     * @param bits Разрешение 9..12 бит.
+     * @return True, если датчик найден на шине и разрешение допустимо.
+     */
+    bool setResolutionForSensor(SensorId sensorId, uint8_t bits);
 
 private:
     HttpEndpoint<SensorConfigState> _httpEndpoint;
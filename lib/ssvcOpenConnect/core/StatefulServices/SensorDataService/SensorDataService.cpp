@@ -18,38 +18,49 @@
 // components/sensors/SensorDataService/SensorDataState.cpp
 
 #include "SensorDataService.h"
+#include <algorithm>
 
 SensorDataService* SensorDataService::_instance = nullptr;
 
-void SensorDataState::read(const SensorDataState& state, const JsonObject& root) {
-    for (const auto& pair : state.readings_by_zone) {
-
-        // 1. Извлекаем ключи и значения через .first и .second
-        const SensorZone zone = pair.first;
-        const std::map<std::string, float>& sensor_readings = pair.second;
-
-        // Конвертируем SensorZone enum в строковое имя для ключа JSON
-        const std::string zoneName = SensorZoneHelper::toString(zone);
-
-        // Создаем вложенный JSON-объект для этой зоны
-        const auto zone_obj = root[zoneName.c_str()].to<JsonObject>();
-
-        // Теперь делаем то же самое для внутреннего цикла:
-        for (const auto& sensor_pair : sensor_readings) {
+namespace {
+    bool readingLess(const SensorReading& a, const SensorReading& b) {
+        return a.zone != b.zone ? a.zone < b.zone : a.id < b.id;
+    }
+}
 
-            const std::string& address = sensor_pair.first;
-            const float value = sensor_pair.second;
+void SensorDataState::read(const SensorDataState& state, const JsonObject& root) {
+    writeGrouped(state.readings, root);
+}
 
-            zone_obj[address.c_str()] = value;
+void SensorDataState::writeGrouped(const std::vector<SensorReading>& sorted, const JsonObject& root) {
+    JsonObject zone_obj;
+    bool zoneOpened = false;
+    auto currentZone = SensorZone::UNKNOWN;
+    char addressHex[SENSOR_ID_HEX_LENGTH + 1];
+
+    // Показания отсортированы по зоне, поэтому вложенный объект зоны создается один раз
+    for (const SensorReading& reading : sorted) {
+        if (!zoneOpened || reading.zone != currentZone) {
+            currentZone = reading.zone;
+            zoneOpened = true;
+            // Конвертируем SensorZone enum в строковое имя для ключа JSON
+            const std::string zoneName = SensorZoneHelper::toString(currentZone);
+            zone_obj = root[zoneName.c_str()].to<JsonObject>();
         }
+
+        sensorIdToHex(reading.id, addressHex);
+        zone_obj[static_cast<const char*>(addressHex)] = reading.value;
     }
 }
 
+std::vector<SensorReading>::iterator SensorDataState::lowerBound(const SensorZone zone, const SensorId id) {
+    const SensorReading key{id, zone, 0.0f};
+    return std::lower_bound(readings.begin(), readings.end(), key, readingLess);
+}
+
 void SensorDataService::triggerZoneDataRecalculation()
 {
-    const std::map<SensorZone, std::vector<AbstractSensor*>> groupedSensors =
-        SensorManager::getInstance().getAllSensorsGroupedByZone();
-    updateSensorData(groupedSensors);
+    updateSensorData(*SensorManager::getInstance().getAllSensors());
     ESP_LOGI(TAG, "Triggered data recalculation due to zone change.");
 }
 
@@ -70,83 +81,113 @@ SensorDataService::SensorDataService(PsychicHttpServer *server,
           sveltekit->getMqttClient(),
           SENSOR_DATA_PUB_TOPIC,
           ""
-          )
+          ),
+      _socket(sveltekit->getSocket()),
+      _publishMutex(xSemaphoreCreateMutex())
 {
+    // Показаний немного: копия на каждое обновление дешевле, чем ожидание цикла опроса читателями
+    enableSnapshots();
+    _mqttEndpoint.setPublishIntervals(SENSOR_DATA_MQTT_MIN_INTERVAL_MS, SENSOR_DATA_MQTT_MAX_INTERVAL_MS);
     ESP_LOGI(TAG, "SensorDataService initialized (RAM-only, HTTP: %s, MQTT: %s)",
              SENSOR_DATA_ENDPOINT, SENSOR_DATA_PUB_TOPIC);
 }
 
 
-void SensorDataService::updateSensorData(
-    const std::map<SensorZone, std::vector<AbstractSensor*>>& groupedSensors)
+void SensorDataService::updateSensorData(const std::vector<AbstractSensor*>& sensors)
 {
-    const String originId = "SENSOR_READING_LOOP";
+    static const String originId = "SENSOR_READING_LOOP";
+
+    // Публикаторы (цикл опроса и пересчет зон) сериализуются здесь, чтобы дельты уходили
+    // в порядке обновлений, а EventSocket вызывался уже без мьютекса состояния
+    xSemaphoreTake(_publishMutex, portMAX_DELAY);
 
     // Используем атомарное обновление состояния
     this->update([&](SensorDataState& state) {
+        const StateUpdateResult result = applyDirtySensors(state, sensors);
+        if (result == StateUpdateResult::CHANGED) {
+            // Дельта забирается из транзакции обменом буферов, без копирования
+            _pendingChanged.swap(state.changed);
+            _pendingRemoved.swap(state.removed);
+        }
+        return result;
+    }, originId);
 
-        SensorDataState newState; // Временное состояние для новых данных
-        bool dataChanged = false;
-
-        // Внешний цикл: итерация по std::map<SensorZone, std::vector<AbstractSensor*>>
-        // 'pair' — это std::pair<SensorZone, std::vector<AbstractSensor*>>
-        for (const auto& pair : groupedSensors) {
-
-            const SensorZone zone = pair.first;
-            const std::vector<AbstractSensor*>& sensors = pair.second;
-
-            // Внутренний цикл: итерация по std::vector<AbstractSensor*>
-            for (const auto& sensor : sensors) {
-
-                // Используем только валидные данные
-                if (sensor->isDataValid()) {
-                    const std::string addressStr = SensorManager::addressToString(sensor->getAddress());
-                    const float reading = sensor->getData();
-
-                    // Добавляем данные в новое состояние
-                    newState.readings_by_zone[zone][addressStr] = reading;
-
-                    // Проверяем, изменилось ли значение по сравнению с текущим состоянием (state)
-
-                    // 1. Проверка наличия зоны в старом состоянии
-                    if (state.readings_by_zone.count(zone) == 0) {
-                        dataChanged = true;
-                        continue; // Переходим к следующему датчику
-                    }
-
-                    // Получаем ссылку на внутреннюю карту для текущей зоны
-                    const std::map<std::string, float>& old_readings = state.readings_by_zone.at(zone);
+    if (!_pendingChanged.empty() || !_pendingRemoved.empty()) {
+        emitChanges();
+        _pendingChanged.clear();
+        _pendingRemoved.clear();
+    }
+    xSemaphoreGive(_publishMutex);
+}
 
-                    // 2. Проверка наличия адреса в старом состоянии
-                    if (old_readings.count(addressStr) == 0) {
-                        dataChanged = true;
-                        continue;
-                    }
+StateUpdateResult SensorDataService::applyDirtySensors(SensorDataState& state,
+                                                       const std::vector<AbstractSensor*>& sensors)
+{
+    state.changed.clear();
+    state.removed.clear();
 
-                    // 3. Проверка изменения значения (с учетом допуска для float)
-                    const float old_reading = old_readings.at(addressStr);
-                    if (std::abs(old_reading - reading) > 0.01f) // Допуск 0.01f
-                    {
-                        dataChanged = true;
-                    }
-                }
+    for (AbstractSensor* sensor : sensors) {
+        if (!sensor->isDirty()) {
+            continue;
+        }
+        const SensorId id = sensor->getId();
+        const SensorZone zone = sensor->getZone();
+        const bool valid = sensor->isDataValid();
+        const float value = sensor->getData();
+
+        // Прежняя запись ищется по опубликованной зоне
+        auto it = state.readings.end();
+        if (sensor->isPublishedValid()) {
+            const auto candidate = state.lowerBound(sensor->getPublishedZone(), id);
+            if (candidate != state.readings.end() && candidate->id == id) {
+                it = candidate;
             }
         }
 
-        // Дополнительная проверка на изменение структуры (датчик появился/пропал)
-        // Если размеры карт зон или внутренние данные изменились
-        if (newState.readings_by_zone.size() != state.readings_by_zone.size() ||
-            (dataChanged == false && newState.readings_by_zone != state.readings_by_zone))
-        {
-            dataChanged = true;
+        if (valid && it != state.readings.end() && it->zone == zone) {
+            // Основной случай: новое значение записывается на месте
+            it->value = value;
+        } else {
+            // Смена зоны или валидности меняет структуру
+            if (it != state.readings.end()) {
+                state.readings.erase(it);
+            }
+            if (valid) {
+                state.readings.insert(state.lowerBound(zone, id), SensorReading{id, zone, value});
+            }
         }
 
-        if (dataChanged) {
-            // Заменяем старое состояние новым, чтобы вызвать PUB/WS
-            state.readings_by_zone = std::move(newState.readings_by_zone);
-            return StateUpdateResult::CHANGED;
+        if (valid) {
+            state.changed.push_back({id, zone, value});
+        } else if (sensor->isPublishedValid()) {
+            state.removed.push_back(id);
         }
+        sensor->markPublished(value, valid);
+    }
 
+    if (state.changed.empty() && state.removed.empty()) {
         return StateUpdateResult::UNCHANGED;
-    }, originId);
-}
\ No newline at end of file
+    }
+    std::sort(state.changed.begin(), state.changed.end(), readingLess);
+    return StateUpdateResult::CHANGED;
+}
+
+void SensorDataService::emitChanges()
+{
+    // Номер растет и без подписчиков: пропуск в последовательности означает потерю дельты
+    const uint32_t sequence = ++_sequence;
+    if (!_socket || !_socket->hasSubscribers(_sensorDataEvent)) {
+        return;
+    }
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["seq"] = sequence;
+    SensorDataState::writeGrouped(_pendingChanged, root["changed"].to<JsonObject>());
+    const auto removed = root["removed"].to<JsonArray>();
+    char addressHex[SENSOR_ID_HEX_LENGTH + 1];
+    for (const SensorId id : _pendingRemoved) {
+        sensorIdToHex(id, addressHex);
+        removed.add(static_cast<const char*>(addressHex));
+    }
+    _socket->emitEvent(_sensorDataEvent, root);
+}
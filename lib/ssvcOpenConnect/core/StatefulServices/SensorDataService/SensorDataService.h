@@ -36,21 +36,51 @@
 
 
 #define SENSOR_DATA_PUB_TOPIC "openconnect/sensor/state"
+// Показания меняются каждый цикл опроса: в MQTT уходит последнее не чаще раза в секунду,
+// и раз в 30 секунд повторно, даже без изменений
+#define SENSOR_DATA_MQTT_MIN_INTERVAL_MS 1000
+#define SENSOR_DATA_MQTT_MAX_INTERVAL_MS 30000
 #define SENSOR_DATA_ENDPOINT "/rest/sensor"
+// Событие EventSocket только с изменившимися показаниями
+#define SENSOR_DATA_EVENT "sensor_data"
 
 
+/**
+ * @brief Одно оперативное показание датчика.
+ */
+struct SensorReading {
+    SensorId id;
+    SensorZone zone;
+    float value;
+};
+
 struct SensorDataState {
     /**
-     * @brief Карта оперативных показаний:
-     * Зона (enum) -> (Адрес датчика (string) -> Последнее значение (float))
+     * @brief Оперативные показания, отсортированные по (зона, SensorId).
+     * В JSON группируются по зонам: Зона -> (Адрес датчика (hex) -> Последнее значение)
      */
-    std::map<SensorZone, std::map<std::string, float>> readings_by_zone;
+    std::vector<SensorReading> readings;
+
+    /**
+     * @brief Изменения последнего обновления: новые значения (в том числе смена зоны)
+     * и датчики, показания которых больше не публикуются.
+     */
+    std::vector<SensorReading> changed;
+    std::vector<SensorId> removed;
 
     /**
      * @brief Сериализация состояния в JSON для HTTP GET, MQTT PUB и WebSocket.
      */
     static void read(const SensorDataState& state, const JsonObject& root);
 
+    /**
+     * @brief Группирует отсортированные по (зона, SensorId) показания в JSON: Зона -> (Адрес -> Значение).
+     */
+    static void writeGrouped(const std::vector<SensorReading>& sorted, const JsonObject& root);
+
+    // Позиция для (зона, SensorId) в отсортированном readings
+    std::vector<SensorReading>::iterator lowerBound(SensorZone zone, SensorId id);
+
     /**
      * @brief Десериализация JSON в состояние.
      * Мы не разрешаем клиентам устанавливать показания, поэтому метод неактивен.
@@ -77,16 +107,19 @@ public:
     void begin()
     {
         _httpEndpoint.begin();
+        if (_socket) {
+            _sensorDataEvent = _socket->registerEvent(SENSOR_DATA_EVENT);
+        }
     }
 
     /**
-     * @brief Обновляет состояние сервиса новыми показаниями.
-     * Вызывается из SensorManager.
-     * @param groupedSensors Карта активных датчиков, сгруппированных по зонам.
+     * @brief Переносит в состояние показания датчиков, помеченных стадией сбора как измененные.
+     * Вызывается из SensorManager. Записи обновляются на месте (вставка и удаление - только
+     * при смене зоны или валидности), подписчикам EventSocket рассылаются только изменения.
+     * Затраты на цикл определяются числом изменившихся датчиков, а не их общим числом.
+     * @param sensors Все зарегистрированные датчики.
      */
-    void updateSensorData(
-        const std::map<SensorZone, std::vector<AbstractSensor*>>& groupedSensors
-    );
+    void updateSensorData(const std::vector<AbstractSensor*>& sensors);
 
     void triggerZoneDataRecalculation();
 
@@ -94,8 +127,25 @@ private:
     HttpEndpoint<SensorDataState> _httpEndpoint;
     MqttEndpoint<SensorDataState> _mqttEndpoint;
 
+    EventSocket* _socket;
+    EventId _sensorDataEvent = EVENT_ID_INVALID;
+
+    // Дельта последнего обновления, вынесенная из транзакции; под _publishMutex
+    SemaphoreHandle_t _publishMutex;
+    std::vector<SensorReading> _pendingChanged;
+    std::vector<SensorId> _pendingRemoved;
+    uint32_t _sequence = 0;
+
     static SensorDataService* _instance;
 
+    // Применяет измененные датчики к состоянию и заполняет changed/removed
+    static StateUpdateResult applyDirtySensors(SensorDataState& state,
+                                               const std::vector<AbstractSensor*>& sensors);
+
+    // Рассылает дельту из _pendingChanged/_pendingRemoved событием SENSOR_DATA_EVENT.
+    // Событие не объединяется в очередях EventSocket: каждая дельта доходит по порядку.
+    void emitChanges();
+
     static constexpr auto TAG = "SensorDataState";
 };
 
@@ -8,6 +8,7 @@
 
 // Интервал обновления телеметрии (2 секунды)
 #define TELEMETRY_UPDATE_INTERVAL_MS 2000
+#define TELEMETRY_MQTT_MAX_INTERVAL_MS 30000
 #define TELEMETRY_REST_PATH "/rest/telemetry"
 
 void TelemetryState::read(const TelemetryState &state, JsonObject &root)
@@ -71,6 +72,10 @@ TelemetryService::TelemetryService(PsychicHttpServer *server,
     if (_updateTimer == nullptr) {
         ESP_LOGE(TAG, "Failed to create FreeRTOS Telemetry timer!");
     }
+    // Телеметрия меняется каждый цикл обновления: не чаще него и не реже раза в TELEMETRY_MQTT_MAX_INTERVAL_MS
+    _mqttEndpoint.setPublishIntervals(TELEMETRY_UPDATE_INTERVAL_MS, TELEMETRY_MQTT_MAX_INTERVAL_MS);
+    // Чтение разбирает сохраненный JSON целиком: HTTP и MQTT читают снимок, не блокируя таймер
+    enableSnapshots();
     _httpEndpoint.begin();
 }
 
@@ -128,31 +133,35 @@ void TelemetryService::updateTelemetryState()
 
 
     // Проверка изменения состояния: сравниваем новую строку с сохраненной
-    if (_state.telemetryJson != newTelemetryJson)
+    const bool changed = _state.telemetryJson != newTelemetryJson;
+    if (changed)
     {
         // НОВЫЙ ЛОГ: Обнаружено изменение
         ESP_LOGV(TAG, "Telemetry state changed! Updating and calling handlers.");
 
         _state.telemetryJson = newTelemetryJson;
         _state.lastUpdateTime = millis();
+        publishSnapshot();
+    } else {
+        // НОВЫЙ ЛОГ: Состояние не изменилось
+        ESP_LOGV(TAG, "Telemetry state unchanged.");
+    }
 
+    // Как и StatefulService::update(): обработчики вызываются после освобождения мьютекса
+    endTransaction();
+
+    if (changed)
+    {
         // 1. Определяем, что состояние изменилось
-        auto result = StateUpdateResult::CHANGED;
+        StateUpdateResult result = StateUpdateResult::CHANGED;
 
         // 2. Вызываем хуки (если есть)
         this->callHookHandlers("InternalTimer", result);
 
         // 3. Вызываем обработчики обновления (триггер для WebSockets/EventSockets)
+        // MQTT публикует по своему интервалу
         this->callUpdateHandlers("InternalTimer");
-
-        _mqttEndpoint.commit();
-        ESP_LOGV(TAG, "MQTT Commit triggered. Topic: %s", TELEMETRY_PUB_TOPIC);
-    } else {
-        // НОВЫЙ ЛОГ: Состояние не изменилось
-        ESP_LOGV(TAG, "Telemetry state unchanged.");
     }
-
-    endTransaction();
     // НОВЫЙ ЛОГ: Конец цикла обновления
     ESP_LOGV(TAG, "updateTelemetryState finished. Mutex released.");
 }
\ No newline at end of file
@@ -24,9 +24,16 @@ void ProfileService::begin(FS* fs) {
         _fs->mkdir(_profilesDir);
     }
 
+    _migrateProfileFiles();
+
     bool metadataModified = false;
     JsonDocument metadataDoc;
-    bool metadataExists = _readMetadata(metadataDoc);
+    FSDocumentFormat metadataFormat = _format;
+    bool metadataExists = _readMetadata(metadataDoc, &metadataFormat);
+    if (metadataExists && metadataFormat != _format) {
+        ESP_LOGI(TAG, "Migrating profiles metadata to %s", FSDocument::formatName(_format));
+        metadataModified = true;
+    }
 
     if (!metadataExists || !metadataDoc.is<JsonArray>()) {
         metadataDoc.to<JsonArray>();
@@ -117,7 +124,7 @@ String ProfileService::getCurrentTimestamp() {
 }
 
 // Helper methods for metadata management
-bool ProfileService::_readMetadata(JsonDocument& doc) const {
+bool ProfileService::_readMetadata(JsonDocument& doc, FSDocumentFormat* format) const {
     ESP_LOGI(TAG, "_readMetadata: Entry. Path=%s", _metadataFilePath); // Логирование входа
     File metadataFile = _fs->open(_metadataFilePath, "r");
     if (!metadataFile) {
@@ -126,7 +133,7 @@ bool ProfileService::_readMetadata(JsonDocument& doc) const {
     }
     ESP_LOGI(TAG, "_readMetadata: Metadata file opened: %s", _metadataFilePath); // Логирование открытия файла
 
-    const DeserializationError error = deserializeJson(doc, metadataFile);
+    const DeserializationError error = FSDocument::read(metadataFile, doc, format);
     metadataFile.close();
     if (error) {
         ESP_LOGE(TAG, "_readMetadata: Failed to deserialize metadata file %s: %s", _metadataFilePath, error.c_str()); // Логирование ошибки
@@ -138,19 +145,10 @@ bool ProfileService::_readMetadata(JsonDocument& doc) const {
 
 bool ProfileService::_writeMetadata(const JsonDocument& doc) const {
     ESP_LOGI(TAG, "_writeMetadata: Entry. Path=%s", _metadataFilePath); // Логирование входа
-    File metadataFile = _fs->open(_metadataFilePath, "w");
-    if (!metadataFile) {
-        ESP_LOGE(TAG, "_writeMetadata: Failed to open metadata file for writing: %s", _metadataFilePath); // Логирование ошибки
-        return false;
-    }
-    ESP_LOGI(TAG, "_writeMetadata: Metadata file opened for writing: %s", _metadataFilePath); // Логирование открытия файла
-
-    if (serializeJson(doc, metadataFile) == 0) {
+    if (!FSDocument::write(_fs, _metadataFilePath, doc, _format)) {
         ESP_LOGE(TAG, "_writeMetadata: Failed to write metadata to file: %s", _metadataFilePath); // Логирование ошибки
-        metadataFile.close();
         return false;
     }
-    metadataFile.close();
     ESP_LOGI(TAG, "_writeMetadata: Metadata written successfully."); // Логирование записи
     return true;
 }
@@ -170,8 +168,72 @@ bool ProfileService::_getProfileMetadata(const String& profileId, JsonObject& pr
     return false;
 }
 
+String ProfileService::_profileFilePath(const String& profileId) const {
+    return String(_profilesDir) + "/" + profileId + ".json";
+}
+
+bool ProfileService::_getProfileDocument(const String& profileId, JsonDocument& doc) const {
+    const String filePath = _profileFilePath(profileId);
+    File profileFile = _fs->open(filePath, "r");
+    if (!profileFile) {
+        ESP_LOGE(TAG, "Profile file not found: %s", filePath.c_str());
+        return false;
+    }
+
+    const DeserializationError error = FSDocument::read(profileFile, doc);
+    profileFile.close();
+    if (error) {
+        ESP_LOGE(TAG, "Failed to deserialize profile %s: %s", profileId.c_str(), error.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ProfileService::_writeProfileDocument(const String& profileId, const JsonDocument& doc) const {
+    const String filePath = _profileFilePath(profileId);
+    if (!FSDocument::write(_fs, filePath, doc, _format)) {
+        ESP_LOGE(TAG, "Failed to write profile data to file: %s", filePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ProfileService::_migrateProfileFiles() const {
+    std::vector<String> staleFiles;
+    std::vector<String> profilesToMigrate;
+
+    File profilesDir = _fs->open(_profilesDir);
+    if (!profilesDir) {
+        return;
+    }
+    File file = profilesDir.openNextFile();
+    while (file) {
+        String fileName = file.name();
+        if (fileName.endsWith(FS_DOCUMENT_TEMP_SUFFIX)) {
+            staleFiles.push_back(String(_profilesDir) + "/" + fileName);
+        } else if (fileName.endsWith(".json") && fileName != "profiles_metadata.json" &&
+                   FSDocument::detect(file) != _format) {
+            profilesToMigrate.push_back(fileName.substring(0, fileName.lastIndexOf('.')));
+        }
+        file = profilesDir.openNextFile();
+    }
+    profilesDir.close();
+
+    for (const auto& path : staleFiles) {
+        ESP_LOGW(TAG, "Removing incomplete file from an interrupted write: %s", path.c_str());
+        _fs->remove(path);
+    }
+
+    for (const auto& profileId : profilesToMigrate) {
+        JsonDocument doc;
+        if (_getProfileDocument(profileId, doc) && _writeProfileDocument(profileId, doc)) {
+            ESP_LOGI(TAG, "Profile %s migrated to %s", profileId.c_str(), FSDocument::formatName(_format));
+        }
+    }
+}
+
 bool ProfileService::_profileFileExists(const String& profileId) const {
-    const String filePath = String(_profilesDir) + "/" + profileId + ".json";
+    const String filePath = _profileFilePath(profileId);
     ESP_LOGI(TAG, "_profileFileExists: Checking path=%s", filePath.c_str()); // Логирование проверки пути
     const bool exists = _fs->exists(filePath);
     ESP_LOGI(TAG, "_profileFileExists: File %s exists: %s", filePath.c_str(), exists ? "true" : "false"); // Логирование результата
@@ -263,18 +325,8 @@ String ProfileService::getActiveProfileId() const {
 }
 
 bool ProfileService::_applyProfileInternal(const String& profileId) const {
-    const String filePath = String(_profilesDir) + "/" + profileId + ".json";
-    File profileFile = _fs->open(filePath, "r");
-    if (!profileFile) {
-        ESP_LOGE(TAG, "Profile file not found: %s", filePath.c_str());
-        return false;
-    }
-
     JsonDocument doc; // Use JsonDocument
-    const DeserializationError error = deserializeJson(doc, profileFile);
-    profileFile.close();
-    if (error) {
-        ESP_LOGE(TAG, "Failed to deserialize profile %s: %s", profileId.c_str(), error.c_str());
+    if (!_getProfileDocument(profileId, doc)) {
         return false;
     }
 
@@ -322,18 +374,9 @@ bool ProfileService::_createOrUpdateProfile(const String& profileId, const Strin
         }
     }
 
-    const String filePath = String(_profilesDir) + "/" + profileId + ".json";
-    File profileFile = _fs->open(filePath, "w");
-    if (!profileFile) {
-        ESP_LOGE(TAG, "Failed to open profile file for writing: %s", filePath.c_str());
+    if (!_writeProfileDocument(profileId, profileDoc)) {
         return false;
     }
-    if (serializeJson(profileDoc, profileFile) == 0) {
-        ESP_LOGE(TAG, "Failed to write profile data to file: %s", filePath.c_str());
-        profileFile.close();
-        return false;
-    }
-    profileFile.close();
 
     // 2. Update metadata
     JsonDocument metadataDoc;
@@ -364,7 +407,7 @@ bool ProfileService::_createOrUpdateProfile(const String& profileId, const Strin
 
 bool ProfileService::deleteProfile(const String& profileId) const {
     // 1. Delete the actual profile data file
-    const String filePath = String(_profilesDir) + "/" + profileId + ".json";
+    const String filePath = _profileFilePath(profileId);
     if (_fs->exists(filePath)) {
         if (!_fs->remove(filePath)) {
             ESP_LOGE(TAG, "Failed to delete profile file: %s", filePath.c_str());
@@ -421,41 +464,22 @@ String ProfileService::copyProfile(const String& sourceProfileId, const String&
     String newProfileId = _generateNewProfileId();
     ESP_LOGI(TAG, "copyProfile: Generated newProfileId=%s", newProfileId.c_str());
 
-    String sourceProfileContent;
-    if (!getProfileContent(sourceProfileId, sourceProfileContent)) {
+    JsonDocument profileDoc;
+    if (!_getProfileDocument(sourceProfileId, profileDoc)) {
         ESP_LOGE(TAG, "copyProfile: Failed to get content of source profile %s.", sourceProfileId.c_str());
         return "";
     }
     ESP_LOGI(TAG, "copyProfile: Source profile content retrieved successfully.");
 
-    JsonDocument profileDoc;
-    const DeserializationError error = deserializeJson(profileDoc, sourceProfileContent);
-    if (error) {
-        ESP_LOGE(TAG, "copyProfile: Failed to deserialize source profile content for copying: %s", error.c_str());
-        return "";
-    }
-    ESP_LOGI(TAG, "copyProfile: Source profile content deserialized successfully.");
-
     profileDoc["id"] = newProfileId;
     profileDoc["name"] = newDisplayName;
     profileDoc["createdAt"] = getCurrentTimestamp();
     ESP_LOGI(TAG, "copyProfile: Updated id, name and createdAt in profileDoc.");
 
-    const String destPath = String(_profilesDir) + "/" + newProfileId + ".json";
-    File destFile = _fs->open(destPath, "w");
-    if (!destFile) {
-        ESP_LOGE(TAG, "copyProfile: Failed to create destination profile for copying: %s", destPath.c_str());
+    if (!_writeProfileDocument(newProfileId, profileDoc)) {
+        ESP_LOGE(TAG, "copyProfile: Failed to write copied profile %s.", newProfileId.c_str());
         return "";
     }
-    ESP_LOGI(TAG, "copyProfile: Destination file opened for writing: %s", destPath.c_str());
-
-    if (serializeJson(profileDoc, destFile) == 0) {
-        ESP_LOGE(TAG, "copyProfile: Failed to write copied profile data to file: %s", destPath.c_str());
-        destFile.close();
-        _fs->remove(destPath);
-        return "";
-    }
-    destFile.close();
     ESP_LOGI(TAG, "copyProfile: Profile data written to destination file successfully.");
 
     if (_addProfileToMetadata(newProfileId, newDisplayName)) {
@@ -492,32 +516,11 @@ bool ProfileService::updateProfile(const String& profileId, const String& newDis
         return false;
     }
 
-    const String filePath = String(_profilesDir) + "/" + profileId + ".json";
-    if (_fs->exists(filePath)) {
-        File profileFileRead = _fs->open(filePath, "r");
-        if (!profileFileRead) {
-            ESP_LOGE(TAG, "Failed to open profile data file for reading during name update: %s", filePath.c_str());
-            return false;
-        }
-
+    if (_profileFileExists(profileId)) {
         JsonDocument profileDoc; // Use JsonDocument
-        DeserializationError error = deserializeJson(profileDoc, profileFileRead);
-        profileFileRead.close();
-
-        if (error == DeserializationError::Ok) {
+        if (_getProfileDocument(profileId, profileDoc)) {
             profileDoc["name"] = newDisplayName;
-
-            File profileFileWrite = _fs->open(filePath, "w");
-            if (!profileFileWrite) {
-                ESP_LOGE(TAG, "Failed to open profile data file for writing during name update: %s", filePath.c_str());
-                return false;
-            }
-            if (serializeJson(profileDoc, profileFileWrite) == 0) {
-                ESP_LOGE(TAG, "Failed to update name in profile data file: %s", filePath.c_str());
-            }
-            profileFileWrite.close();
-        } else {
-            ESP_LOGE(TAG, "Failed to deserialize profile %s for name update: %s", profileId.c_str(), error.c_str());
+            _writeProfileDocument(profileId, profileDoc);
         }
     }
     return true;
@@ -571,18 +574,8 @@ bool ProfileService::setActiveAndApplyProfile(const String& profileId) const {
 }
 
 bool ProfileService::getProfileContent(const String& profileId, String& dest) const {
-    const String filePath = String(_profilesDir) + "/" + profileId + ".json";
-    File profileFile = _fs->open(filePath, "r");
-    if (!profileFile) {
-        ESP_LOGW(TAG, "Profile file not found for content retrieval: %s", filePath.c_str());
-        return false;
-    }
-
     JsonDocument doc;
-    const DeserializationError error = deserializeJson(doc, profileFile);
-    profileFile.close();
-    if (error) {
-        ESP_LOGE(TAG, "Failed to deserialize profile %s for content retrieval: %s", profileId.c_str(), error.c_str());
+    if (!_getProfileDocument(profileId, doc)) {
         return false;
     }
 
@@ -646,23 +639,13 @@ bool ProfileService::saveCurrentSettingsToProfile(const String& profileId) const
 }
 
 bool ProfileService::updateProfileContent(const String& profileId, const JsonObject& content) const {
-    const String filePath = String(_profilesDir) + "/" + profileId + ".json";
-    if (!_fs->exists(filePath)) {
-        ESP_LOGE(TAG, "Profile file not found for content update: %s", filePath.c_str());
+    if (!_profileFileExists(profileId)) {
+        ESP_LOGE(TAG, "Profile file not found for content update: %s", _profileFilePath(profileId).c_str());
         return false;
     }
 
     JsonDocument doc;
-    File profileFileRead = _fs->open(filePath, "r");
-    if (!profileFileRead) {
-        ESP_LOGE(TAG, "Failed to open profile data file for reading during content update: %s", filePath.c_str());
-        return false;
-    }
-
-    const DeserializationError error = deserializeJson(doc, profileFileRead);
-    profileFileRead.close();
-    if (error) {
-        ESP_LOGE(TAG, "Failed to deserialize profile %s for content update: %s", profileId.c_str(), error.c_str());
+    if (!_getProfileDocument(profileId, doc)) {
         return false;
     }
 
@@ -687,18 +670,9 @@ bool ProfileService::updateProfileContent(const String& profileId, const JsonObj
     }
 
     // Записываем обновленное содержимое обратно в файл.
-    File profileFileWrite = _fs->open(filePath, "w");
-    if (!profileFileWrite) {
-        ESP_LOGE(TAG, "Failed to open profile data file for writing during content update: %s", filePath.c_str());
-        return false;
-    }
-
-    if (serializeJson(doc, profileFileWrite) == 0) {
-        ESP_LOGE(TAG, "Failed to update content in profile data file: %s", filePath.c_str());
-        profileFileWrite.close();
+    if (!_writeProfileDocument(profileId, doc)) {
         return false;
     }
-    profileFileWrite.close();
 
     // Если профиль активен, применяем его заново.
     if (getActiveProfileId() == profileId) {
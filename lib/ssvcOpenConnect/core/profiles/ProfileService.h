@@ -5,6 +5,7 @@
 #include <vector>
 #include <FS.h>
 #include <ArduinoJson.h>
+#include <FSDocument.h>
 #include <set>
 
 struct ProfileMetadata {
@@ -45,17 +46,22 @@ private:
     FS* _fs;
     const char* _profilesDir = "/profiles";
     const char* _metadataFilePath = "/profiles/profiles_metadata.json";
+    // Формат записи профилей и метаданных; файлы в другом формате читаются и переписываются в begin()
+    FSDocumentFormat _format = FSDocument::defaultFormat();
     std::vector<IProfileObserver*> _observers;
 
     static String getCurrentTimestamp();
 
-    bool _readMetadata(JsonDocument& doc) const;
+    bool _readMetadata(JsonDocument& doc, FSDocumentFormat* format = nullptr) const;
     bool _writeMetadata(const JsonDocument& doc) const;
     bool _getProfileMetadata(const String& profileId, JsonObject& profileObj) const;
     bool _profileFileExists(const String& profileId) const;
     bool _addProfileToMetadata(const String& profileId, const String& displayName) const; // Добавлено
+    String _profileFilePath(const String& profileId) const;
     bool _getProfileDocument(const String& profileId, JsonDocument& doc) const; // Добавлено
     bool _writeProfileDocument(const String& profileId, const JsonDocument& doc) const; // Добавлено
+    // Переписывает файлы профилей, сохраненные в другом формате, и удаляет остатки прерванных записей
+    void _migrateProfileFiles() const;
 
     // Private helper methods for applying and setting active
     bool _applyProfileInternal(const String& profileId) const;
@@ -597,6 +597,8 @@ void RectificationProcess::update(void* pvParameters)
         self->recalculateFlowVolume(telemetry["v1"], telemetry["v2"],
                                     telemetry["v3"]);
 
+        self->publishSnapshot(_currentStage);
+
         ESP_LOGV(TAG, "LastMessage %s", message.c_str());
         xSemaphoreGive(mutex);
       }
@@ -805,6 +807,48 @@ void RectificationProcess::writeTelemetryTo(const JsonVariant telemetry)
 
 }
 
+void RectificationProcess::publishSnapshot(const RectificationStage stage)
+{
+  TelemetrySnapshot snapshot;
+  snapshot.stage = stage;
+  snapshot.tp1 = metric.common.tp1;
+  snapshot.tp2 = metric.common.tp2;
+  // Как и в writeTelemetryTo: ноль означает, что поля в сообщении не было
+  if (metric.tp1_target != 0)
+  {
+    snapshot.tp1_target = metric.tp1_target;
+  }
+  if (metric.tp2_target != 0)
+  {
+    snapshot.tp2_target = metric.tp2_target;
+  }
+  if (metric.alc != 0)
+  {
+    snapshot.alc = metric.alc;
+  }
+  snapshot.mmhg = static_cast<float>(metric.common.mmhg);
+  snapshot.relay = metric.common.relay ? 1.0f : 0.0f;
+  snapshot.signal = metric.common.signal ? 1.0f : 0.0f;
+  snapshot.open = metric.open;
+  snapshot.updatedMs = millis();
+  if (snapshot.updatedMs == 0)
+  {
+    snapshot.updatedMs = 1;
+  }
+
+  taskENTER_CRITICAL(&_snapshotMux);
+  _snapshot = snapshot;
+  taskEXIT_CRITICAL(&_snapshotMux);
+}
+
+RectificationProcess::TelemetrySnapshot RectificationProcess::getTelemetrySnapshot() const
+{
+  taskENTER_CRITICAL(&_snapshotMux);
+  const TelemetrySnapshot snapshot = _snapshot;
+  taskEXIT_CRITICAL(&_snapshotMux);
+  return snapshot;
+}
+
 bool RectificationProcess::getStatus(const JsonVariant status) {
   if (xSemaphoreTake(mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
 
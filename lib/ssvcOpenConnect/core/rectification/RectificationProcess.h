@@ -110,6 +110,23 @@ public:
     ERROR // Ошибка разбора этапов
   };
 
+  // Последние показания контроллера для читателей вне задачи телеметрии (правила тревог).
+  // Копируется целиком под спин-блокировкой, без ожидания мьютекса разбора сообщений.
+  struct TelemetrySnapshot
+  {
+    RectificationStage stage = RectificationStage::EMPTY;
+    float tp1 = NAN;
+    float tp2 = NAN;
+    float tp1_target = NAN; // NaN - контроллер не передал значение
+    float tp2_target = NAN;
+    float mmhg = NAN;
+    float relay = NAN;
+    float signal = NAN;
+    float open = NAN;
+    float alc = NAN;
+    uint32_t updatedMs = 0; // millis() последнего разбора, 0 - телеметрии еще не было
+  };
+
   //
   // Удаляем конструкторы копирования и присваивания
   RectificationProcess(const RectificationProcess&) = delete;
@@ -132,6 +149,8 @@ public:
 
   Metrics& getMetrics();
 
+  TelemetrySnapshot getTelemetrySnapshot() const;
+
   std::string errorSet;
 
 private:
@@ -158,6 +177,11 @@ private:
 
   Metrics metric;
 
+  TelemetrySnapshot _snapshot;
+  mutable portMUX_TYPE _snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+
+  void publishSnapshot(RectificationStage stage);
+
   SsvcConnector* _ssvcConnector;
   SsvcSettings* _ssvcSettings;
   SsvcMqttSettingsService* _ssvcMqttSettingsService;
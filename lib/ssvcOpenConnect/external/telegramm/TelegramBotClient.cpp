@@ -143,7 +143,7 @@ void TelegramBotClient::updateSensorInfo() {
 
     sensorService->read([&](const SensorDataState& currentState) {
 
-        if (currentState.readings_by_zone.empty()) {
+        if (currentState.readings.empty()) {
             cachedStatus.sensorZones.clear();
             return;
         }
@@ -151,33 +151,19 @@ void TelegramBotClient::updateSensorInfo() {
         std::map<std::string, std::vector<std::string>> newSensorZones;
         bool dataChanged = false;
 
-        for (const auto& zonePair : currentState.readings_by_zone) {
-            const SensorZone zone = zonePair.first;
-            const auto& readings = zonePair.second;
-            const std::string zoneName = SensorZoneHelper::toString(zone);
-            std::vector<std::string> sensorTexts;
-
-            for (auto it = readings.rbegin(); it != readings.rend(); ++it) {
-                const std::string& address = it->first;
-                const float sensorValue = it->second;
-
-                std::string shortAddress;
-                if (address.length() > 4) {
-                    shortAddress = address.substr(address.length() - 4);
-                } else {
-                    shortAddress = address;
-                }
+        // Показания отсортированы по (зона, адрес); внутри зоны выводим в обратном порядке адресов
+        for (auto it = currentState.readings.rbegin(); it != currentState.readings.rend(); ++it) {
+            const std::string zoneName = SensorZoneHelper::toString(it->zone);
 
-                char tempBuffer[64];
-                snprintf(tempBuffer, sizeof(tempBuffer), "  %s: <b>%.2f°C</b>\n",
-                             shortAddress.c_str(), sensorValue);
+            char address[SENSOR_ID_HEX_LENGTH + 1];
+            sensorIdToHex(it->id, address);
+            const char* shortAddress = address + SENSOR_ID_HEX_LENGTH - 4;
 
-                sensorTexts.emplace_back(tempBuffer);
-            }
+            char tempBuffer[64];
+            snprintf(tempBuffer, sizeof(tempBuffer), "  %s: <b>%.2f°C</b>\n",
+                         shortAddress, it->value);
 
-            if (!sensorTexts.empty()) {
-                 newSensorZones[zoneName] = sensorTexts;
-            }
+            newSensorZones[zoneName].emplace_back(tempBuffer);
         }
 
         if (cachedStatus.sensorZones.size() != newSensorZones.size() || cachedStatus.sensorZones != newSensorZones) {
@@ -3,6 +3,9 @@
 #include <PsychicHttpServer.h>
 #include <esp_task_wdt.h>
 #include <components/Led/StatusLed.h>
+#ifdef STATEFUL_SERVICE_BENCHMARK
+#include <StatefulServiceBenchmark.h>
+#endif
 
 #define SERIAL_BAUD_RATE 115200
 
@@ -40,6 +43,11 @@ void setup() {
       esp32sveltekit.getSocket(),
       esp32sveltekit.getSecurityManager()
   );
+
+#ifdef STATEFUL_SERVICE_BENCHMARK
+  // Сравнение чтения состояния под мьютексом и из снимка при конкурирующей записи
+  StatefulServiceBenchmark::runAndLog();
+#endif
 }
 
 void loop() {
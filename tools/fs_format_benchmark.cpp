@@ -0,0 +1,228 @@
+/**
+ *   SSVC Open Connect
+ *
+ *   Хостовый бенчмарк форматов хранения настроек: JSON против MessagePack.
+ *   Сравнивает размер и время разбора профилей, метаданных профилей и файлов /config
+ *   теми же вызовами ArduinoJson, что и FSDocument::read() на устройстве (разбор из буфера).
+ *
+ *   Сборка (ArduinoJson 7 берется из .pio/libdeps после сборки прошивки):
+ *     g++ -O2 -std=gnu++14 -I .pio/libdeps/esp32-s3-devkitc-1-16m/ArduinoJson/src \
+ *         tools/fs_format_benchmark.cpp -o fs_format_benchmark
+ *
+ *   Запуск:
+ *     ./fs_format_benchmark                  - встроенные образцы реального размера
+ *     ./fs_format_benchmark 0.json 1.json    - свои файлы (скачанные через /rest/files
+ *                                              или /rest/profiles/content)
+ *
+ *   Абсолютные времена на хосте в десятки раз меньше, чем на ESP32-S3; сравнивать
+ *   имеет смысл отношение JSON/MessagePack.
+ */
+
+#include <ArduinoJson.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Sample {
+    std::string name;
+    std::string data;  // JSON или MessagePack (файлы, уже переведенные устройством)
+};
+
+// Профиль в том виде, в каком его сохраняет ProfileService: SsvcSettings::fillSettings + telegram
+std::string makeProfile(int id) {
+    JsonDocument doc;
+    doc["id"] = std::to_string(id);
+    doc["name"] = "Профиль " + std::to_string(id);
+    doc["createdAt"] = "2025-10-16T07:07:09Z";
+
+    JsonObject s = doc["ssvcSettings"].to<JsonObject>();
+    JsonArray heads = s["heads"].to<JsonArray>();
+    heads.add(6.5f);
+    heads.add(120);
+    JsonArray hearts = s["hearts"].to<JsonArray>();
+    hearts.add(5.5f);
+    hearts.add(480);
+    JsonArray lateHeads = s["late_heads"].to<JsonArray>();
+    lateHeads.add(6.0f);
+    lateHeads.add(60);
+    JsonArray tails = s["tails"].to<JsonArray>();
+    tails.add(4.5f);
+    tails.add(900);
+    s["tails_temp"] = 97.5f;
+    JsonArray valveBw = s["valve_bw"].to<JsonArray>();
+    valveBw.add(210);
+    valveBw.add(230);
+    valveBw.add(250);
+    s["hyst"] = 0.12f;
+    s["decrement"] = 10;
+    s["formula"] = true;
+    s["tank_mmhg"] = 0;
+    s["heads_timer"] = 3600;
+    s["late_heads_timer"] = 600;
+    s["hearts_timer"] = 0;
+    s["start_delay"] = 0;
+    s["hearts_finish_temp"] = 92.3f;
+    s["formula_start_temp"] = 78.4f;
+    s["sound"] = true;
+    s["pressure"] = false;
+    s["relay_inverted"] = false;
+    s["relay_autostart"] = true;
+    s["autoresume"] = true;
+    s["auto_mode"] = false;
+    s["hearts_temp_shift"] = true;
+    s["hearts_pause"] = false;
+    s["tp2_shift"] = 0.3f;
+    s["tp_filter"] = true;
+    s["signal_tp1_control"] = false;
+    s["signal_inverted"] = false;
+    s["tp1_control_temp"] = 40.0f;
+    s["tp1_control_start"] = 70.0f;
+    s["stab_limit_time"] = 30;
+    s["stab_limit_finish"] = true;
+    s["backlight"] = 2;
+    s["release_timer"] = 60;
+    s["release_speed"] = 1.5f;
+    s["heads_final"] = 30;
+    JsonArray parallel = s["parallel"].to<JsonArray>();
+    parallel.add(3.5f);
+    parallel.add(200);
+
+    JsonObject telegram = doc["telegram"].to<JsonObject>();
+    telegram["botToken"] = "1234567890:AAE3b4c5d6e7f8g9h0i1j2k3l4m5n6o7p8q";
+    telegram["chatId"] = "-1001234567890";
+
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+std::string makeMetadata(int profiles) {
+    JsonDocument doc;
+    JsonArray array = doc.to<JsonArray>();
+    for (int i = 0; i < profiles; ++i) {
+        JsonObject p = array.add<JsonObject>();
+        p["id"] = std::to_string(i);
+        p["name"] = "Профиль " + std::to_string(i);
+        p["createdAt"] = "2025-10-16T07:07:09Z";
+        p["isApplied"] = i == 0;
+    }
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+// Настройки порогов тревог для восьми датчиков (/config/alarm_thresholds.json, AlarmThresholdsState::read)
+std::string makeThresholds() {
+    JsonDocument doc;
+    JsonObject thresholds = doc["thresholds"].to<JsonObject>();
+    for (int i = 0; i < 8; ++i) {
+        char address[17];
+        std::snprintf(address, sizeof address, "28FF64%010X", 0x1E3F2A + i);
+        JsonObject t = thresholds[static_cast<const char*>(address)].to<JsonObject>();
+        t["enabled"] = true;
+        t["min"] = 15.0f;
+        t["dangerous"] = 85.0f;
+        t["critical"] = 95.0f;
+        t["hysteresis"] = 0.5f;
+        t["debounce"] = 3;
+        t["max_rate"] = 2.0f;
+    }
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+bool readFile(const char* path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+template <typename Parse>
+double measureUs(Parse parse, int iterations) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        parse();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+}
+
+bool run(const Sample& sample, int iterations) {
+    // Формат определяется по первому байту, как в FSDocument::detect()
+    const auto first = sample.data.empty() ? 0 : static_cast<uint8_t>(sample.data[0]);
+    const bool isMsgPack = (first >= 0x80 && first <= 0x9f) || (first >= 0xdc && first <= 0xdf);
+
+    JsonDocument source;
+    const DeserializationError error = isMsgPack ? deserializeMsgPack(source, sample.data)
+                                                 : deserializeJson(source, sample.data);
+    if (error) {
+        std::printf("%-28s ошибка разбора: %s\n", sample.name.c_str(), error.c_str());
+        return false;
+    }
+
+    std::string json;
+    std::string msgpack;
+    serializeJson(source, json);
+    serializeMsgPack(source, msgpack);
+
+    volatile size_t sink = 0;
+    const double jsonUs = measureUs([&] {
+        JsonDocument doc;
+        deserializeJson(doc, json.data(), json.size());
+        sink += doc.size();
+    }, iterations);
+    const double msgpackUs = measureUs([&] {
+        JsonDocument doc;
+        deserializeMsgPack(doc, msgpack.data(), msgpack.size());
+        sink += doc.size();
+    }, iterations);
+
+    std::printf("%-28s %7zu %7zu %6.0f%% %10.2f %10.2f %6.2fx\n",
+                sample.name.c_str(), json.size(), msgpack.size(),
+                100.0 * static_cast<double>(msgpack.size()) / static_cast<double>(json.size()),
+                jsonUs, msgpackUs, jsonUs / msgpackUs);
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = 20000;
+    std::vector<Sample> samples;
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            Sample sample{argv[i], {}};
+            if (!readFile(argv[i], sample.data)) {
+                std::printf("Не удалось прочитать %s\n", argv[i]);
+                return 1;
+            }
+            samples.push_back(sample);
+        }
+    } else {
+        samples.push_back({"profile", makeProfile(1)});
+        samples.push_back({"profiles_metadata (10)", makeMetadata(10)});
+        samples.push_back({"alarm_thresholds (8)", makeThresholds()});
+    }
+
+    std::printf("%-28s %7s %7s %7s %10s %10s %7s\n",
+                "файл", "JSON,Б", "MP,Б", "размер", "JSON,мкс", "MP,мкс", "уск.");
+    bool ok = true;
+    for (const auto& sample : samples) {
+        ok = run(sample, iterations) && ok;
+    }
+    return ok ? 0 : 1;
+}